@@ -6,12 +6,26 @@ class ReceiverBase;
 struct receiver_context_t;
 
 
+/*!
+Stick values passed from the cockpit to the flight controller.
+
+If LIBRARY_RECEIVER_USE_FIXED_POINT_CONTROLS is defined then the sticks are in q12dot4 fixed point format (ie 1.0F is 2048),
+and update_controls() implementations should use ReceiverBase::get_controls_q12dot4().
+*/
 struct cockpit_controls_t {
     uint32_t tick_count;
+    uint32_t frame_age_us; //!< time from the arrival of the last byte of the receiver frame to the update of the controls, for stick latency compensation
+#if defined(LIBRARY_RECEIVER_USE_FIXED_POINT_CONTROLS)
+    int32_t throttle_stick;
+    int32_t roll_stick;
+    int32_t pitch_stick;
+    int32_t yaw_stick;
+#else
     float throttle_stick;
     float roll_stick;
     float pitch_stick;
     float yaw_stick;
+#endif
 };
 
 class CockpitBase {
@@ -22,7 +36,8 @@ public:
     uint32_t get_timeout_ticks() const { return _timeout_ticks; }
     void set_timeout_ticks(uint32_t timeout_ticks) { _timeout_ticks = timeout_ticks; }
 
-    virtual void update_controls(uint32_t tick_count, const ReceiverBase& receiver, receiver_context_t& ctx) = 0;
+    //! Called when the receiver has unpacked a new frame, `frame_age_us` is the time since the last byte of the frame was received.
+    virtual void update_controls(uint32_t tick_count, uint32_t frame_age_us, const ReceiverBase& receiver, receiver_context_t& ctx) = 0;
     virtual void check_failsafe(uint32_t tick_count, receiver_context_t& ctx) = 0;
 protected:
     uint32_t _timeout_ticks {100};
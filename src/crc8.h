@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+/*!
+CRC8, MSB first, with initial value passed in and no final XOR, as used by CRSF.
+
+Three implementations are provided:
+1. bitwise: 8 shift/XOR iterations per byte, no table.
+2. table: one lookup per byte, 256 byte table.
+3. slicing: processes 4 bytes per iteration using four 256 byte tables.
+
+The tables are generated at compile time, and only take up flash if the corresponding implementation is used.
+
+`update` and `calculate` use the implementation selected at compile time:
+define LIBRARY_RECEIVER_CRC8_BITWISE for flash-constrained targets, or LIBRARY_RECEIVER_CRC8_SLICING for fastest
+calculation of long frames. The default is the table implementation.
+*/
+template <uint8_t POLYNOMIAL>
+class Crc8 {
+public:
+    static constexpr size_t SLICE_COUNT = 4;
+    typedef std::array<uint8_t, 256> table_t;
+public:
+    static constexpr uint8_t update_bitwise(uint8_t crc, uint8_t value) {
+        crc ^= value;
+        for (int ii = 0; ii < 8; ++ii) { // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+            crc = (crc & 0x80U) ? static_cast<uint8_t>((crc << 1U) ^ POLYNOMIAL) : static_cast<uint8_t>(crc << 1U);
+        }
+        return crc;
+    }
+    static inline uint8_t update_table(uint8_t crc, uint8_t value) { return TABLE[crc ^ value]; }
+
+    static uint8_t calculate_bitwise(uint8_t crc, const uint8_t* data, size_t len) {
+        for (size_t ii = 0; ii < len; ++ii) {
+            crc = update_bitwise(crc, data[ii]); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+        return crc;
+    }
+    static uint8_t calculate_table(uint8_t crc, const uint8_t* data, size_t len) {
+        for (size_t ii = 0; ii < len; ++ii) {
+            crc = TABLE[crc ^ data[ii]]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+        return crc;
+    }
+    static uint8_t calculate_slicing(uint8_t crc, const uint8_t* data, size_t len) {
+        // SLICING_TABLES[n][b] is the CRC of byte b followed by n zero bytes
+        size_t ii = 0;
+        for (; ii + SLICE_COUNT <= len; ii += SLICE_COUNT) {
+            // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            crc = static_cast<uint8_t>(
+                SLICING_TABLES[3][crc ^ data[ii]]
+                ^ SLICING_TABLES[2][data[ii + 1]]
+                ^ SLICING_TABLES[1][data[ii + 2]]
+                ^ SLICING_TABLES[0][data[ii + 3]]);
+            // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+        for (; ii < len; ++ii) {
+            crc = SLICING_TABLES[0][crc ^ data[ii]]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+        return crc;
+    }
+
+#if defined(LIBRARY_RECEIVER_CRC8_BITWISE)
+    static inline uint8_t update(uint8_t crc, uint8_t value) { return update_bitwise(crc, value); }
+    static inline uint8_t calculate(uint8_t crc, const uint8_t* data, size_t len) { return calculate_bitwise(crc, data, len); }
+#elif defined(LIBRARY_RECEIVER_CRC8_SLICING)
+    static inline uint8_t update(uint8_t crc, uint8_t value) { return SLICING_TABLES[0][crc ^ value]; }
+    static inline uint8_t calculate(uint8_t crc, const uint8_t* data, size_t len) { return calculate_slicing(crc, data, len); }
+#else
+    static inline uint8_t update(uint8_t crc, uint8_t value) { return update_table(crc, value); }
+    static inline uint8_t calculate(uint8_t crc, const uint8_t* data, size_t len) { return calculate_table(crc, data, len); }
+#endif
+private:
+    static constexpr table_t make_table() {
+        table_t table {};
+        for (size_t ii = 0; ii < table.size(); ++ii) {
+            table[ii] = update_bitwise(0, static_cast<uint8_t>(ii));
+        }
+        return table;
+    }
+    static constexpr std::array<table_t, SLICE_COUNT> make_slicing_tables() {
+        std::array<table_t, SLICE_COUNT> tables {};
+        tables[0] = make_table();
+        for (size_t slice = 1; slice < SLICE_COUNT; ++slice) {
+            for (size_t ii = 0; ii < tables[0].size(); ++ii) {
+                // append a zero byte
+                tables[slice][ii] = tables[0][tables[slice - 1][ii]];
+            }
+        }
+        return tables;
+    }
+    static constexpr table_t TABLE = make_table();
+    static constexpr std::array<table_t, SLICE_COUNT> SLICING_TABLES = make_slicing_tables();
+};
@@ -62,17 +62,6 @@ EspnowTransceiver::EspnowTransceiver(const uint8_t* my_mac_address, uint8_t chan
 {
     transceiver = this;
     memcpy(&_my_mac_address[0], my_mac_address, ESP_NOW_ETH_ALEN);
-#if defined(LIBRARY_RECEIVER_USE_ESPNOW) && defined(FRAMEWORK_USE_FREERTOS)
-    _primary_data_received_queue = xQueueCreateStatic(DATA_RECEIVED_QUEUE_LENGTH, sizeof(_primary_data_received_queue_item), &_primary_data_received_queueStorageArea[0], &_primary_data_received_queue_static);
-    configASSERT(_primary_data_received_queue);
-    const UBaseType_t primaryMessageCount = uxQueueMessagesWaiting(_primary_data_received_queue);
-    assert(primaryMessageCount == 0);
-
-    _secondary_data_received_queue = xQueueCreateStatic(DATA_RECEIVED_QUEUE_LENGTH, sizeof(_secondary_data_received_queueItem), &_secondary_data_received_queueStorageArea[0], &_secondary_data_received_queue_static);
-    configASSERT(_secondary_data_received_queue);
-    const UBaseType_t secondaryMessageCount = uxQueueMessagesWaiting(_secondary_data_received_queue);
-    assert(secondaryMessageCount == 0);
-#endif
 }
 
 #if defined(LIBRARY_RECEIVER_USE_ESPNOW)
@@ -248,8 +237,9 @@ IRAM_ATTR bool EspnowTransceiver::copy_received_data_to_buffer(const uint8_t* ma
             // copy the received data into the _peer_data buffer
             const size_t copy_length = std::min(len, peer_data.received_data_ptr->buffer_size); // so don't overwrite buffer
             memcpy(peer_data.received_data_ptr->buffer_ptr, data, copy_length);
-            // and set the _peer_data length
+            // and set the _peer_data length and arrival time
             peer_data.received_data_ptr->len = copy_length;
+            peer_data.received_data_ptr->time = time_us();
             if (ii == PRIMARY_PEER) {
                 ++_received_packet_count; // only count packets being sent to the primary peer
                 const TickType_t tick_count = xTaskGetTickCount();
@@ -1,8 +1,10 @@
 # pragma once
 
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <time_microseconds.h>
 
 
 #if defined(LIBRARY_RECEIVER_USE_ESPNOW)
@@ -10,7 +12,7 @@
 #include <esp_attr.h>
 #include <esp_now.h>
 #include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
+#include <freertos/task.h>
 
 #else
 
@@ -43,10 +45,11 @@ public:
     static constexpr uint8_t PEER_3 = 4;
     static constexpr uint8_t MAX_PEER_COUNT = 4;
     struct received_data_t {
-        inline received_data_t(uint8_t* a_buffer_ptr, size_t a_buffer_size) : buffer_ptr(a_buffer_ptr), buffer_size(a_buffer_size), len(0) {}
+        inline received_data_t(uint8_t* a_buffer_ptr, size_t a_buffer_size) : buffer_ptr(a_buffer_ptr), buffer_size(a_buffer_size), len(0), time(0) {}
         uint8_t* buffer_ptr;
         size_t buffer_size;
         size_t len;
+        time_us32_t time; //!< arrival time of the data, as given by time_us()
     };
     struct peer_data_t {
         esp_now_peer_info_t peer_info { .peer_addr={0,0,0,0,0,0}, .lmk={0}, .channel=0, .ifidx=WIFI_IF_STA, .encrypt=false, .priv=nullptr };
@@ -106,36 +109,32 @@ private:
     std::array<uint8_t, ESP_NOW_ETH_ALEN + 2> _my_mac_address {0, 0, 0, 0, 0, 0, 0, 0};
 
 #if defined(LIBRARY_RECEIVER_USE_ESPNOW) && defined(FRAMEWORK_USE_FREERTOS)
-    enum { DATA_RECEIVED_QUEUE_LENGTH = 1}; // length MUST be 1 to be used by xQueueOverwriteFromISR
-
-    uint32_t _primary_data_received_queue_item {}; // this is just a dummy item whose value is not used
-    BaseType_t _primary_data_received_queue_higher_priority_task_woken = pdFALSE;
-    std::array<uint8_t, DATA_RECEIVED_QUEUE_LENGTH * sizeof(_primary_data_received_queue_item)> _primary_data_received_queueStorageArea {};
-    StaticQueue_t _primary_data_received_queue_static {};
-    QueueHandle_t _primary_data_received_queue {};
-
-    uint32_t _secondary_data_received_queueItem {}; // this is just a dummy item whose value is not used
-    BaseType_t _secondary_data_received_queueHigherPriorityTaskWoken = pdFALSE;
-    std::array<uint8_t, DATA_RECEIVED_QUEUE_LENGTH * sizeof(_secondary_data_received_queueItem)> _secondary_data_received_queueStorageArea {};
-    StaticQueue_t _secondary_data_received_queue_static {};
-    QueueHandle_t _secondary_data_received_queue {};
-public:
-    inline int32_t WAIT_FOR_PRIMARY_DATA_RECEIVED() { return xQueueReceive(_primary_data_received_queue, &_primary_data_received_queue_item, portMAX_DELAY); }
-    inline int32_t WAIT_FOR_PRIMARY_DATA_RECEIVED(uint32_t ticksToWait) { return xQueueReceive(_primary_data_received_queue, &_primary_data_received_queue_item, ticksToWait); }
-    //inline void SIGNAL_PRIMARY_DATA_RECEIVED_FROM_ISR() { xQueueSendFromISR(_primary_data_received_queue, &_primary_data_received_queue_item, nullptr); }
-    inline void SIGNAL_PRIMARY_DATA_RECEIVED_FROM_ISR() {
-        _primary_data_received_queue_higher_priority_task_woken = pdFALSE;
-        xQueueOverwriteFromISR(_primary_data_received_queue, &_primary_data_received_queue_item, &_primary_data_received_queue_higher_priority_task_woken);
-        portYIELD_FROM_ISR(_primary_data_received_queue_higher_priority_task_woken); // or portEND_SWITCHING_ISR() depending on the port.
+    /*!
+    The tasks waiting for data are woken using direct to task notifications, rather than queues.
+    The task to notify is the one that last called the corresponding WAIT function, until a task has done so no task is notified.
+    The primary and secondary peers use the same notification, so must be waited for by different tasks.
+    */
+    std::atomic<TaskHandle_t> _primary_data_received_task {nullptr};
+    std::atomic<TaskHandle_t> _secondary_data_received_task {nullptr};
+    static inline int32_t WAIT_FOR_DATA_RECEIVED(std::atomic<TaskHandle_t>& task, uint32_t ticksToWait) { // returns pdPASS(1) if notified, pdFAIL(0) if timeout
+        task.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+        return ulTaskNotifyTake(pdTRUE, ticksToWait) > 0 ? pdPASS : pdFAIL;
     }
-    inline int32_t WAIT_FOR_SECONDARY_DATA_RECEIVED() { return xQueueReceive(_secondary_data_received_queue, &_secondary_data_received_queueItem, portMAX_DELAY); }
-    inline int32_t WAIT_FOR_SECONDARY_DATA_RECEIVED(uint32_t ticksToWait) { return xQueueReceive(_secondary_data_received_queue, &_secondary_data_received_queueItem, ticksToWait); }
-    //inline void SIGNAL_SECONDARY_DATA_RECEIVED_FROM_ISR() { xQueueSendFromISR(_secondary_data_received_queue, &_secondary_data_received_queueItem, nullptr); }
-    inline void SIGNAL_SECONDARY_DATA_RECEIVED_FROM_ISR() {
-        _secondary_data_received_queueHigherPriorityTaskWoken = pdFALSE;
-        xQueueOverwriteFromISR(_secondary_data_received_queue, &_secondary_data_received_queueItem, &_secondary_data_received_queueHigherPriorityTaskWoken);
-        portYIELD_FROM_ISR(_secondary_data_received_queueHigherPriorityTaskWoken); // or portEND_SWITCHING_ISR() depending on the port.
+    static inline void SIGNAL_DATA_RECEIVED_FROM_ISR(const std::atomic<TaskHandle_t>& task) {
+        TaskHandle_t task_handle = task.load(std::memory_order_acquire);
+        if (task_handle != nullptr) {
+            BaseType_t higher_priority_task_woken = pdFALSE;
+            vTaskNotifyGiveFromISR(task_handle, &higher_priority_task_woken);
+            portYIELD_FROM_ISR(higher_priority_task_woken); // or portEND_SWITCHING_ISR() depending on the port.
+        }
     }
+public:
+    inline int32_t WAIT_FOR_PRIMARY_DATA_RECEIVED() { return WAIT_FOR_DATA_RECEIVED(_primary_data_received_task, portMAX_DELAY); }
+    inline int32_t WAIT_FOR_PRIMARY_DATA_RECEIVED(uint32_t ticksToWait) { return WAIT_FOR_DATA_RECEIVED(_primary_data_received_task, ticksToWait); }
+    inline void SIGNAL_PRIMARY_DATA_RECEIVED_FROM_ISR() { SIGNAL_DATA_RECEIVED_FROM_ISR(_primary_data_received_task); }
+    inline int32_t WAIT_FOR_SECONDARY_DATA_RECEIVED() { return WAIT_FOR_DATA_RECEIVED(_secondary_data_received_task, portMAX_DELAY); }
+    inline int32_t WAIT_FOR_SECONDARY_DATA_RECEIVED(uint32_t ticksToWait) { return WAIT_FOR_DATA_RECEIVED(_secondary_data_received_task, ticksToWait); }
+    inline void SIGNAL_SECONDARY_DATA_RECEIVED_FROM_ISR() { SIGNAL_DATA_RECEIVED_FROM_ISR(_secondary_data_received_task); }
 #else
 public:
     inline int32_t WAIT_FOR_PRIMARY_DATA_RECEIVED() { return 0; }
@@ -0,0 +1,209 @@
+#include "ibus_sensor_responder.h"
+
+
+IbusSensorResponder::IbusSensorResponder(SerialPort& serialPort, uint8_t first_address) :
+    _serial_port(serialPort),
+    _first_address(first_address)
+{
+    _serial_port.set_watcher(this);
+}
+
+IbusSensorResponder::IbusSensorResponder(SerialPort& serialPort) :
+    IbusSensorResponder(serialPort, 1)
+{
+}
+
+/*!
+IBUS checksum: 0xFFFF minus the sum of the bytes.
+*/
+uint16_t IbusSensorResponder::calculate_checksum(const uint8_t* data, size_t len)
+{
+    uint16_t checksum = 0xFFFF; // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    for (size_t ii = 0; ii < len; ++ii) {
+        checksum = static_cast<uint16_t>(checksum - data[ii]); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+    return checksum;
+}
+
+/*!
+Add a sensor of type `type`, with a value of `value_size` (2 or 4) bytes, and precompute its replies.
+
+The sensor's value is zero until set_sensor_value() is called.
+
+Returns the sensor's address, or 0 if the sensor table is full.
+*/
+uint8_t IbusSensorResponder::add_sensor(uint8_t type, uint8_t value_size)
+{
+    if (_sensor_count >= MAX_SENSOR_COUNT || _first_address + _sensor_count > ADDRESS_MASK) {
+        return 0;
+    }
+    const auto address = static_cast<uint8_t>(_first_address + _sensor_count);
+    sensor_t& sensor = _sensors[_sensor_count];
+
+    sensor.discover_reply = { POLL_LENGTH, static_cast<uint8_t>(COMMAND_DISCOVER | address), 0, 0 };
+    uint16_t checksum = calculate_checksum(&sensor.discover_reply[0], 2);
+    sensor.discover_reply[2] = static_cast<uint8_t>(checksum & 0xFFU);
+    sensor.discover_reply[3] = static_cast<uint8_t>(checksum >> 8U);
+
+    sensor.type_reply = { static_cast<uint8_t>(sensor.type_reply.size()), static_cast<uint8_t>(COMMAND_GET_TYPE | address), type, value_size, 0, 0 };
+    checksum = calculate_checksum(&sensor.type_reply[0], 4);
+    sensor.type_reply[4] = static_cast<uint8_t>(checksum & 0xFFU);
+    sensor.type_reply[5] = static_cast<uint8_t>(checksum >> 8U);
+
+    sensor.value_size = (value_size == VALUE_SIZE_4) ? VALUE_SIZE_4 : VALUE_SIZE_2;
+    sensor.measurement_length = static_cast<uint8_t>(sensor.value_size + 4);
+    for (auto& reply : sensor.measurement_replies) {
+        reply = {};
+        reply[0] = sensor.measurement_length;
+        reply[1] = static_cast<uint8_t>(COMMAND_GET_MEASUREMENT | address);
+    }
+    sensor.measurement_checksum_base = calculate_checksum(&sensor.measurement_replies[0][0], 2);
+    sensor.measurement_index.store(0, std::memory_order_relaxed);
+    ++_sensor_count;
+    set_sensor_value(address, 0);
+    return address;
+}
+
+/*!
+Set the value of the sensor at `address`.
+
+The value and checksum are patched into the measurement reply that is not being sent, which then becomes the one that is sent.
+The checksum is updated from the precomputed checksum of the header, so only the value bytes are summed.
+
+Must be called from a single task. A reply being sent while two value changes are made is torn, and so rejected by the receiver
+because of its checksum, but the values of most sensors change at a much lower rate than the polls.
+*/
+void IbusSensorResponder::set_sensor_value(uint8_t address, int32_t value)
+{
+    const size_t index = static_cast<size_t>(address) - _first_address;
+    if (address < _first_address || index >= _sensor_count) {
+        return;
+    }
+    sensor_t& sensor = _sensors[index];
+    const uint8_t next = sensor.measurement_index.load(std::memory_order_relaxed) ^ 1U;
+    auto& reply = sensor.measurement_replies[next];
+    uint16_t checksum = sensor.measurement_checksum_base;
+    for (size_t ii = 0; ii < sensor.value_size; ++ii) {
+        const auto byte = static_cast<uint8_t>(static_cast<uint32_t>(value) >> (8U*ii));
+        reply[2 + ii] = byte;
+        checksum = static_cast<uint16_t>(checksum - byte);
+    }
+    reply[2 + sensor.value_size] = static_cast<uint8_t>(checksum & 0xFFU);
+    reply[3 + sensor.value_size] = static_cast<uint8_t>(checksum >> 8U);
+    sensor.measurement_index.store(next, std::memory_order_release);
+}
+
+/*!
+Send the precomputed reply to the poll `command_address`, returns false if the poll is not for one of our sensors.
+*/
+bool IbusSensorResponder::respond(uint8_t command_address)
+{
+    const uint8_t address = command_address & ADDRESS_MASK;
+    const size_t index = static_cast<size_t>(address) - _first_address;
+    if (address < _first_address || index >= _sensor_count) {
+        // the poll is for another sensor on the bus
+        return false;
+    }
+    const sensor_t& sensor = _sensors[index];
+    const uint8_t* reply = nullptr;
+    size_t len = 0;
+    switch (command_address & COMMAND_MASK) {
+    case COMMAND_DISCOVER:
+        reply = &sensor.discover_reply[0];
+        len = sensor.discover_reply.size();
+        break;
+    case COMMAND_GET_TYPE:
+        reply = &sensor.type_reply[0];
+        len = sensor.type_reply.size();
+        break;
+    case COMMAND_GET_MEASUREMENT:
+        reply = &sensor.measurement_replies[sensor.measurement_index.load(std::memory_order_acquire)][0];
+        len = sensor.measurement_length;
+        break;
+    default:
+        return false;
+    }
+    // called from the ISR, so the reply must not be sent with a blocking write
+    const size_t written = _serial_port.write_from_isr(reply, len);
+    if (_half_duplex) {
+        _echo_byte_count = written;
+    }
+    if (written == 0) {
+        // the transmitter is busy, so the receiver will get no reply and poll again
+        ++_error_count;
+        return false;
+    }
+    ++_reply_count;
+    return true;
+}
+
+bool IbusSensorResponder::on_data_received_from_isr(uint8_t data)
+{
+    return on_data_received(&data, 1, time_us()) != 0;
+}
+
+size_t IbusSensorResponder::on_data_received_from_isr(const uint8_t* data, size_t len, time_us32_t timestamp)
+{
+    return on_data_received(data, len, timestamp);
+}
+
+/*!
+Parse `len` bytes of data received at time `timestamp`, replying to any polls for our sensors.
+
+Called from within the SerialPort ISR, or from update().
+
+Returns the number of polls replied to.
+*/
+size_t IbusSensorResponder::on_data_received(const uint8_t* data, size_t len, time_us32_t timestamp)
+{
+    if (timestamp - _start_time > POLL_TIMEOUT_US) {
+        // the bus has been idle, so any partial poll or outstanding echo has been lost
+        _poll_index = 0;
+        _echo_byte_count = 0;
+    }
+    _start_time = timestamp;
+
+    size_t reply_count = 0;
+    for (size_t ii = 0; ii < len; ++ii) {
+        if (_echo_byte_count > 0) {
+            --_echo_byte_count;
+            continue;
+        }
+        const uint8_t value = data[ii]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        if (_poll_index == 0 && value != POLL_LENGTH) {
+            continue;
+        }
+        _poll[_poll_index] = value;
+        ++_poll_index;
+        if (_poll_index < POLL_LENGTH) {
+            continue;
+        }
+        _poll_index = 0;
+        const uint16_t checksum = calculate_checksum(&_poll[0], 2);
+        if (_poll[2] != (checksum & 0xFFU) || _poll[3] != (checksum >> 8U)) {
+            ++_error_count;
+            continue;
+        }
+        ++_poll_count;
+        if (respond(_poll[1])) {
+            ++reply_count;
+        }
+    }
+    return reply_count;
+}
+
+/*!
+Read any data from the serial port and reply to any polls, for when the serial port buffers the received data rather than
+giving it to the responder from the ISR.
+
+Returns the number of polls replied to.
+*/
+size_t IbusSensorResponder::update(time_us32_t time)
+{
+    size_t reply_count = 0;
+    size_t len = 0;
+    while ((len = _serial_port.read(&_read_buffer[0], _read_buffer.size())) > 0) {
+        reply_count += on_data_received(&_read_buffer[0], len, time);
+    }
+    return reply_count;
+}
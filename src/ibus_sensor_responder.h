@@ -0,0 +1,112 @@
+#pragma once
+
+#include "serial_port.h"
+
+#include <array>
+#include <atomic>
+
+
+/*!
+IBUS sensor bus responder, so the flight controller can send telemetry to a Flysky receiver.
+
+The receiver polls each sensor address in turn on the (half duplex) sensor bus, using 4 byte frames:
+[0x04][command | address][checksum low][checksum high], where the checksum is 0xFFFF minus the sum of the preceding bytes.
+The commands are:
+1. discover: the sensor replies by echoing the poll.
+2. get type: the sensor replies with [0x06][0x90 | address][type][value size][checksum].
+3. get measurement: the sensor replies with [length][0xA0 | address][value, little endian][checksum], where length is 6 or 8.
+
+The reply has to be sent within a short window after the poll, so the reply for every command and sensor is precomputed.
+The discover and type replies are fixed once the sensor is added. The measurement reply is double buffered: set_sensor_value()
+patches the value and checksum into the idle buffer in place and then makes it the active buffer.
+So answering a poll is just a SerialPort::write_from_isr() of an already complete buffer, which queues the reply for interrupt
+driven transmission rather than blocking the ISR while it is sent.
+
+Sensors are given consecutive addresses, starting at `first_address`.
+*/
+class IbusSensorResponder : public SerialPortWatcherBase {
+public:
+    static constexpr uint8_t POLL_LENGTH = 4;
+    static constexpr uint8_t COMMAND_DISCOVER = 0x80;
+    static constexpr uint8_t COMMAND_GET_TYPE = 0x90;
+    static constexpr uint8_t COMMAND_GET_MEASUREMENT = 0xA0;
+    static constexpr uint8_t COMMAND_MASK = 0xF0;
+    static constexpr uint8_t ADDRESS_MASK = 0x0F;
+    static constexpr uint8_t MAX_SENSOR_COUNT = 15; //!< addresses 1 to 15, address 0 is the receiver itself
+    static constexpr uint32_t POLL_TIMEOUT_US = 1000; //!< a poll takes 350us at 115200 baud, so a longer gap restarts the poll
+
+    // sensor types, values are sent in the units given
+    static constexpr uint8_t SENSOR_TYPE_INTERNAL_VOLTAGE = 0x00; //!< 0.01V
+    static constexpr uint8_t SENSOR_TYPE_TEMPERATURE = 0x01; //!< 0.1 degrees C, offset by 400, ie 400 is 0C
+    static constexpr uint8_t SENSOR_TYPE_RPM_FLYSKY = 0x02;
+    static constexpr uint8_t SENSOR_TYPE_EXTERNAL_VOLTAGE = 0x03; //!< 0.01V
+    static constexpr uint8_t SENSOR_TYPE_CELL = 0x04; //!< 0.01V
+    static constexpr uint8_t SENSOR_TYPE_BATTERY_CURRENT = 0x05; //!< 0.01A
+    static constexpr uint8_t SENSOR_TYPE_FUEL = 0x06; //!< percent
+    static constexpr uint8_t SENSOR_TYPE_RPM = 0x07;
+    static constexpr uint8_t SENSOR_TYPE_COMPASS_HEADING = 0x08; //!< degrees
+    static constexpr uint8_t SENSOR_TYPE_CLIMB_RATE = 0x09; //!< 0.01m/s
+    static constexpr uint8_t SENSOR_TYPE_ARMED = 0x15;
+    static constexpr uint8_t SENSOR_TYPE_FLIGHT_MODE = 0x16;
+    static constexpr uint8_t SENSOR_TYPE_GPS_LATITUDE = 0x80; //!< 4 byte value, 1e-7 degrees
+    static constexpr uint8_t SENSOR_TYPE_GPS_LONGITUDE = 0x81; //!< 4 byte value, 1e-7 degrees
+    static constexpr uint8_t SENSOR_TYPE_GPS_ALTITUDE = 0x82; //!< 4 byte value, 0.01m
+    static constexpr uint8_t SENSOR_TYPE_ALTITUDE = 0x83; //!< 4 byte value, 0.01m
+
+    static constexpr uint8_t VALUE_SIZE_2 = 2;
+    static constexpr uint8_t VALUE_SIZE_4 = 4;
+public:
+    IbusSensorResponder(SerialPort& serialPort, uint8_t first_address);
+    explicit IbusSensorResponder(SerialPort& serialPort);
+private:
+    // IbusSensorResponder is not copyable or moveable
+    IbusSensorResponder(const IbusSensorResponder&) = delete;
+    IbusSensorResponder& operator=(const IbusSensorResponder&) = delete;
+    IbusSensorResponder(IbusSensorResponder&&) = delete;
+    IbusSensorResponder& operator=(IbusSensorResponder&&) = delete;
+public:
+    //! Add a sensor, returns its address or 0 if there are no addresses left.
+    uint8_t add_sensor(uint8_t type, uint8_t value_size);
+    uint8_t add_sensor(uint8_t type) { return add_sensor(type, (type & 0x80U) ? VALUE_SIZE_4 : VALUE_SIZE_2); }
+    void set_sensor_value(uint8_t address, int32_t value);
+    size_t get_sensor_count() const { return _sensor_count; }
+    //! If true (the default) the bytes of each reply are expected to be received back, because TX and RX share a single wire, and they are ignored.
+    void set_half_duplex(bool half_duplex) { _half_duplex = half_duplex; }
+
+    bool on_data_received_from_isr(uint8_t data) override;
+    size_t on_data_received_from_isr(const uint8_t* data, size_t len, time_us32_t timestamp) override;
+    size_t on_data_received(const uint8_t* data, size_t len, time_us32_t timestamp);
+    size_t update(time_us32_t time);
+
+    uint32_t get_poll_count() const { return _poll_count; }
+    uint32_t get_reply_count() const { return _reply_count; }
+    uint32_t get_error_count() const { return _error_count; }
+    static uint16_t calculate_checksum(const uint8_t* data, size_t len);
+private:
+    bool respond(uint8_t command_address);
+private:
+    enum { MEASUREMENT_BUFFER_COUNT = 2 };
+    struct sensor_t {
+        uint8_t value_size;
+        uint8_t measurement_length;
+        uint16_t measurement_checksum_base; //!< checksum of the length and command bytes of the measurement reply
+        std::atomic<uint8_t> measurement_index; //!< index of the measurement reply that is sent, written by set_sensor_value() only
+        std::array<uint8_t, POLL_LENGTH> discover_reply;
+        std::array<uint8_t, 6> type_reply;
+        std::array<std::array<uint8_t, 8>, MEASUREMENT_BUFFER_COUNT> measurement_replies;
+    };
+    SerialPort& _serial_port;
+    const uint8_t _first_address;
+    uint8_t _sensor_count {};
+    bool _half_duplex {true};
+    std::array<sensor_t, MAX_SENSOR_COUNT> _sensors {};
+    std::array<uint8_t, POLL_LENGTH> _poll {};
+    size_t _poll_index {};
+    size_t _echo_byte_count {}; //!< number of bytes of the last reply still to be received back, if half duplex
+    time_us32_t _start_time {};
+    uint32_t _poll_count {};
+    uint32_t _reply_count {};
+    uint32_t _error_count {};
+    enum { READ_BUFFER_SIZE = 64 };
+    std::array<uint8_t, READ_BUFFER_SIZE> _read_buffer {};
+};
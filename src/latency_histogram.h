@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+
+/*!
+Fixed size log-linear (HDR style) histogram of 32-bit values, eg latencies in microseconds.
+
+Values less than 2 * SUB_BUCKET_COUNT each have their own bucket. Above that, each power of two range is split into
+SUB_BUCKET_COUNT equal width buckets, so a value is placed in a bucket whose width is at most 1/SUB_BUCKET_COUNT of the value
+(6.25% for the default of 16 sub-buckets). Values greater than MAX_VALUE are counted in the last bucket.
+
+The bucket index is calculated from the position of the most significant bit and the next SUB_BUCKET_BITS bits of the value,
+so record() is a count leading zeros, a shift, and a few adds, with no loops and no allocation.
+
+record() must be called from a single task (or ISR). snapshot() may be called from any other task: the histogram is protected
+by a sequence number (seqlock), so a snapshot taken while a value is being recorded is detected and retaken.
+*/
+template <unsigned SUB_BUCKET_BITS = 4, unsigned VALUE_BITS = 20>
+class LatencyHistogram {
+public:
+    static_assert(SUB_BUCKET_BITS > 0 && SUB_BUCKET_BITS < VALUE_BITS && VALUE_BITS <= 32, "invalid histogram size");
+    static constexpr uint32_t SUB_BUCKET_COUNT = 1U << SUB_BUCKET_BITS;
+    static constexpr uint32_t MAX_VALUE = static_cast<uint32_t>((uint64_t{1} << VALUE_BITS) - 1);
+    static constexpr size_t BUCKET_COUNT = (VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+    static constexpr int SNAPSHOT_ATTEMPT_COUNT = 4;
+
+    struct snapshot_t {
+        std::array<uint32_t, BUCKET_COUNT> counts;
+        uint32_t count;
+        uint32_t min;
+        uint32_t max;
+        uint64_t sum;
+        uint32_t mean() const { return count == 0 ? 0 : static_cast<uint32_t>(sum / count); }
+        /*!
+        Returns the value below which `per_mille` thousandths of the recorded values fall, eg 990 for the 99th percentile.
+
+        The value returned is the highest value in the bucket containing the percentile, limited to the maximum value recorded,
+        so it is never less than the true percentile and is at most 1/SUB_BUCKET_COUNT above it.
+        */
+        uint32_t value_at_per_mille(uint32_t per_mille) const {
+            if (count == 0) {
+                return 0;
+            }
+            // the rank of the value, rounded up, so the 0th percentile is the first value and the 1000th is the last
+            const uint64_t rank = std::max(uint64_t{1}, (static_cast<uint64_t>(count) * std::min(per_mille, 1000U) + 999) / 1000);
+            uint64_t total = 0;
+            for (size_t ii = 0; ii < BUCKET_COUNT; ++ii) {
+                total += counts[ii];
+                if (total >= rank) {
+                    // the last bucket also holds the values greater than MAX_VALUE
+                    const uint32_t highest = (ii == BUCKET_COUNT - 1) ? max : bucket_highest_value(ii);
+                    return std::max(min, std::min(max, highest));
+                }
+            }
+            return max;
+        }
+        uint32_t value_at_percentile(uint32_t percentile) const { return value_at_per_mille(10 * percentile); }
+    };
+public:
+    static constexpr size_t bucket_index(uint32_t value) {
+        if (value > MAX_VALUE) {
+            value = MAX_VALUE;
+        }
+        if (value < SUB_BUCKET_COUNT) {
+            return value;
+        }
+        // value is in [2^msb, 2^(msb+1)), which is split into SUB_BUCKET_COUNT buckets of width 2^shift
+        const auto msb = static_cast<unsigned>(31 - std::countl_zero(value));
+        const unsigned shift = msb - SUB_BUCKET_BITS;
+        return (static_cast<size_t>(shift + 1) << SUB_BUCKET_BITS) + ((value >> shift) - SUB_BUCKET_COUNT);
+    }
+    static constexpr uint32_t bucket_lowest_value(size_t index) {
+        const auto group = static_cast<unsigned>(index >> SUB_BUCKET_BITS);
+        const auto sub_bucket = static_cast<uint32_t>(index & (SUB_BUCKET_COUNT - 1));
+        return group == 0 ? sub_bucket : (SUB_BUCKET_COUNT + sub_bucket) << (group - 1);
+    }
+    static constexpr uint32_t bucket_highest_value(size_t index) {
+        const auto group = static_cast<unsigned>(index >> SUB_BUCKET_BITS);
+        return group == 0 ? bucket_lowest_value(index) : bucket_lowest_value(index) + ((1U << (group - 1)) - 1);
+    }
+
+    inline void record(uint32_t value) {
+        const uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+        _sequence.store(sequence + 1, std::memory_order_relaxed); // odd while the histogram is being changed
+        std::atomic_thread_fence(std::memory_order_release);
+        ++_data.counts[bucket_index(value)];
+        ++_data.count;
+        _data.sum += value;
+        if (value < _data.min) {
+            _data.min = value;
+        }
+        if (value > _data.max) {
+            _data.max = value;
+        }
+        _sequence.store(sequence + 2, std::memory_order_release);
+    }
+    /*!
+    Copy the histogram into `snapshot`.
+
+    Returns false if a consistent copy could not be made, which can happen only if this is called from a task that has
+    preempted the recording task while it is recording.
+    */
+    bool snapshot(snapshot_t& snapshot) const {
+        for (int ii = 0; ii < SNAPSHOT_ATTEMPT_COUNT; ++ii) {
+            const uint32_t sequence = _sequence.load(std::memory_order_acquire);
+            if (sequence & 1U) {
+                continue;
+            }
+            snapshot = _data;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_sequence.load(std::memory_order_relaxed) == sequence) {
+                return true;
+            }
+        }
+        return false;
+    }
+    //! Must be called from the recording task.
+    void reset() {
+        const uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+        _sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        _data = EMPTY;
+        _sequence.store(sequence + 2, std::memory_order_release);
+    }
+    uint32_t get_count() const { return _data.count; }
+private:
+    static constexpr snapshot_t EMPTY { .counts = {}, .count = 0, .min = UINT32_MAX, .max = 0, .sum = 0 };
+    snapshot_t _data {EMPTY};
+    std::atomic<uint32_t> _sequence {0};
+};
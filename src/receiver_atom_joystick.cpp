@@ -59,29 +59,54 @@ bool ReceiverAtomJoystick::update(uint32_t tick_count_delta)
     _dropped_packet_count_delta = _dropped_packet_count - _dropped_packet_count_previous;
     _dropped_packet_count_previous = _dropped_packet_count;
 
-    if (unpack_packet(CHECK_PACKET)) {
+    const bool valid = unpack_packet(CHECK_PACKET);
+    // ESP-NOW packets are checked here rather than in the receive callback, so the stats are written by the task
+    begin_stats_update();
+    _stats.byte_count += static_cast<uint32_t>(_received_data.len);
+    if (valid) {
+        ++_stats.valid_frame_count;
+    } else {
+        ++_stats.crc_error_count;
+    }
+    end_stats_update();
+    update_frames_per_second(time_us());
+
+    if (valid) {
         if (_packet_count == 5) { // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
             // set the bias so that the current readings are zero.
             set_current_readings_to_bias();
         }
 
         // Save the stick values.
-        _controls.throttle = normalized_stick(THROTTLE);
         // Atom Joystick returns throttle in range [-1.0, 1.0]
         // _positive_half_throttle discards range [-1.0, 0.0) for use by aerial vehicles
         // since Atom Joystick is sprung to return to center position on all axes
+#if defined(LIBRARY_RECEIVER_USE_FIXED_POINT_CONTROLS)
+        _controls_q12dot4.throttle = normalized_stick_q12dot4(THROTTLE);
+        if (_positive_half_throttle) {
+            _controls_q12dot4.throttle = std::max(0, _controls_q12dot4.throttle);
+        }
+        _controls_q12dot4.roll = normalized_stick_q12dot4(ROLL);
+        _controls_q12dot4.pitch = normalized_stick_q12dot4(PITCH);
+        _controls_q12dot4.yaw = normalized_stick_q12dot4(YAW);
+#else
+        _controls.throttle = normalized_stick(THROTTLE);
         if (_positive_half_throttle) {
             _controls.throttle = std::max(0.0F, _controls.throttle); // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
         }
         _controls.roll = normalized_stick(ROLL);
         _controls.pitch = normalized_stick(PITCH);
         _controls.yaw = normalized_stick(YAW);
+#endif
 
         // Save the button values.
         set_switch(MOTOR_ON_OFF_SWITCH, _flip_button);
         set_switch(MODE_SWITCH, _mode);
         set_switch(ALT_MODE_SWITCH, _alt_mode == 4 ? 0 : 1); // _alt_mode has a value of 4 or 5
 
+        // an ESP-NOW packet arrives all at once and is published by the callback, so all its times are the same
+        _frame_time = { _received_data.time, _received_data.time, _received_data.time };
+
         // now we have copied all the packet values, set the _new_packet_available flag
         // NOTE: there is no mutex around this flag
         _new_packet_available = true;
@@ -250,12 +275,22 @@ bool ReceiverAtomJoystick::unpack_packet(checkPacket_t checkPacket)
     _alt_mode = _packet[22];
     _proactive_flag = _packet[23];
 
+#if defined(LIBRARY_RECEIVER_USE_FIXED_POINT_CONTROLS)
+    // q12dot4 * 1000 / 2048 == q12dot4 * 125 / 256, the arithmetic shifts round down, as does the float conversion below since the results are positive
+    _controls_pwm = receiver_controls_pwm_t {
+        .throttle = static_cast<uint16_t>(_positive_half_throttle ? ((_controls_q12dot4.throttle * 125) >> 8U) + CHANNEL_LOW : ((_controls_q12dot4.throttle * 125) >> 9U) + CHANNEL_MIDDLE),
+        .roll = static_cast<uint16_t>(((_controls_q12dot4.roll * 125) >> 9U) + CHANNEL_MIDDLE),
+        .pitch = static_cast<uint16_t>(((_controls_q12dot4.pitch * 125) >> 9U) + CHANNEL_MIDDLE),
+        .yaw = static_cast<uint16_t>(((_controls_q12dot4.yaw * 125) >> 9U) + CHANNEL_MIDDLE)
+    };
+#else
     _controls_pwm = receiver_controls_pwm_t {
         .throttle = static_cast<uint16_t>(_positive_half_throttle ? (_controls.throttle*CHANNEL_RANGE_F + CHANNEL_LOW_F) : (_controls.throttle * CHANNEL_RANGE_F / 2.0F) + CHANNEL_MIDDLE_F),
         .roll = static_cast<uint16_t>((_controls.roll * CHANNEL_RANGE_F / 2.0F) + CHANNEL_MIDDLE_F),
         .pitch = static_cast<uint16_t>((_controls.pitch * CHANNEL_RANGE_F / 2.0F) + CHANNEL_MIDDLE_F),
         .yaw = static_cast<uint16_t>((_controls.yaw * CHANNEL_RANGE_F /2.0F) + CHANNEL_MIDDLE_F)
     };
+#endif
 //NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
 
     set_packet_empty();
@@ -270,21 +305,21 @@ void ReceiverAtomJoystick::set_current_readings_to_bias()
     }
 }
 
-float ReceiverAtomJoystick::normalized_stick(size_t stick_index) const
+int32_t ReceiverAtomJoystick::normalized_stick_q12dot4(size_t stick_index) const
 {
     const stick_t stick = _sticks[stick_index];
     if (!_bias_is_set) {
-       return q12dot4_to_float(stick.raw_q12dot4);
+       return stick.raw_q12dot4;
     }
 
     const int32_t ret = stick.raw_q12dot4 - stick.bias_q12dot4;
     if (ret < -stick.deadband_q12dot4) {
-        return -q12dot4_to_float(-stick.deadband_q12dot4 - ret); // (stick.bias - stick.deadband/2 - min);
+        return ret + stick.deadband_q12dot4; // (stick.bias - stick.deadband/2 - min);
     }
     if (ret > stick.deadband_q12dot4) {
-        return q12dot4_to_float(ret - stick.deadband_q12dot4); // (max - stick.bias - stick.deadband/2);
+        return ret - stick.deadband_q12dot4; // (max - stick.bias - stick.deadband/2);
     }
-    return 0.0F;
+    return 0;
 }
 
 void ReceiverAtomJoystick::reset_sticks()
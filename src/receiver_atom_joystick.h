@@ -46,7 +46,8 @@ private:
     void reset_sticks();
     void set_deadband(int32_t deadband);
     void set_current_readings_to_bias();
-    float normalized_stick(size_t stick_index) const;
+    float normalized_stick(size_t stick_index) const { return q12dot4_to_float(normalized_stick_q12dot4(stick_index)); }
+    int32_t normalized_stick_q12dot4(size_t stick_index) const;
 private:
     struct stick_t {
         int32_t raw_q12dot4 {0};
@@ -0,0 +1,243 @@
+#include "receiver_auto_detect.h"
+#include "receiver_crsf.h"
+#include "receiver_ibus.h"
+#include "receiver_sbus.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+/*!
+Parse `len` bytes of data, stopping once `frame_count_limit` valid frames have been seen.
+
+Returns the number of bytes of data used, this is less than `len` only if the frame count limit was reached.
+*/
+size_t ReceiverSyncDetector::on_data_received(const uint8_t* data, size_t len, uint32_t frame_count_limit)
+{
+    // bytes of a bad frame that are to be rescanned, these are processed before the remaining input
+    std::array<uint8_t, MAX_FRAME_SIZE> rescan; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+    size_t rescan_index = 0;
+    size_t rescan_len = 0;
+    size_t ii = 0;
+    while ((rescan_index < rescan_len || ii < len) && _frame_count < frame_count_limit) {
+        const uint8_t value = (rescan_index < rescan_len) ? rescan[rescan_index++] : data[ii++]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        if (_index == 0 && !is_start_byte(value)) {
+            continue;
+        }
+        _buffer[_index] = value;
+        ++_index;
+        const size_t size = frame_size();
+        if (size == FRAME_SIZE_UNKNOWN || (size != 0 && _index < size)) {
+            continue;
+        }
+        if (size != 0 && is_frame_valid(size)) {
+            ++_frame_count;
+            _index = 0;
+            continue;
+        }
+        // bad length or bad frame, so rescan the bytes after the start byte, ahead of any bytes still to be rescanned.
+        // If any of the frame came from the input data then the rescan buffer was empty, so the bytes always fit.
+        const size_t count = _index - 1;
+        const size_t remaining = rescan_len - rescan_index;
+        memmove(&rescan[count], &rescan[rescan_index], remaining);
+        memcpy(&rescan[0], &_buffer[1], count);
+        rescan_index = 0;
+        rescan_len = count + remaining;
+        _index = 0;
+    }
+    return ii;
+}
+
+bool ReceiverSyncDetector::is_start_byte(uint8_t value) const
+{
+    switch (_protocol) {
+    case PROTOCOL_SBUS:
+        return value == ReceiverSbus::SBUS_START_BYTE;
+    case PROTOCOL_CRSF:
+        return value == ReceiverCrsf::CRSF_SYNC_BYTE || value == ReceiverCrsf::EDGE_TX_SYNC_BYTE;
+    default:
+        return value == ReceiverIbus::SERIAL_RX_PACKET_LENGTH;
+    }
+}
+
+/*!
+Returns the size of the frame being received, FRAME_SIZE_UNKNOWN if not enough bytes have been received to tell,
+or 0 if the bytes received so far cannot be the start of a frame.
+*/
+size_t ReceiverSyncDetector::frame_size() const
+{
+    enum { SBUS_FRAME_SIZE = 25 };
+    switch (_protocol) {
+    case PROTOCOL_SBUS:
+        return SBUS_FRAME_SIZE;
+    case PROTOCOL_CRSF: {
+        if (_index < 2) {
+            return FRAME_SIZE_UNKNOWN;
+        }
+        // length is length of type, payload, and CRC
+        const uint8_t length = _buffer[1];
+        return (length < 2 || length > ReceiverCrsf::MAX_PACKET_SIZE - 2) ? 0 : length + 2U;
+    }
+    default:
+        return ReceiverIbus::SERIAL_RX_PACKET_LENGTH;
+    }
+}
+
+bool ReceiverSyncDetector::is_frame_valid(size_t size) const
+{
+    switch (_protocol) {
+    case PROTOCOL_SBUS:
+        return _buffer[size - 1] == ReceiverSbus::SBUS_END_BYTE;
+    case PROTOCOL_CRSF:
+        // the CRC includes the received CRC byte, so is zero for a valid frame
+        return ReceiverCrsf::crc8_dvb_s2_t::calculate(0, &_buffer[2], size - 2) == 0;
+    default: {
+        // checksum of the 14 channel slots, as calculated by ReceiverIbus
+        enum { CHANNEL_OFFSET = 2 };
+        uint16_t checksum = 0xFFFF; // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+        for (size_t ii = CHANNEL_OFFSET; ii < size - 2; ii += 2) {
+            checksum = static_cast<uint16_t>(checksum + _buffer[ii] + (_buffer[ii + 1] << 8U));
+        }
+        return checksum == static_cast<uint16_t>(_buffer[size - 2] | (_buffer[size - 1] << 8U));
+    }
+    }
+}
+
+
+ReceiverAutoDetect::ReceiverAutoDetect(SerialPort& serialPort, const std::array<ReceiverSerial*, ReceiverSyncDetector::PROTOCOL_COUNT>& receivers, uint32_t valid_frame_count) :
+    _serial_port(serialPort),
+    _receivers(receivers),
+    _valid_frame_count(valid_frame_count)
+{
+    _serial_port.set_watcher(this);
+}
+
+ReceiverAutoDetect::ReceiverAutoDetect(SerialPort& serialPort, const std::array<ReceiverSerial*, ReceiverSyncDetector::PROTOCOL_COUNT>& receivers) :
+    ReceiverAutoDetect(serialPort, receivers, VALID_FRAME_COUNT)
+{
+}
+
+ReceiverSerial* ReceiverAutoDetect::get_receiver() const
+{
+    const protocol_e protocol = get_protocol();
+    return protocol == ReceiverSyncDetector::PROTOCOL_NONE ? nullptr : _receivers[protocol];
+}
+
+bool ReceiverAutoDetect::on_data_received_from_isr(uint8_t data)
+{
+    return on_data_received(&data, 1, time_us()) != 0;
+}
+
+size_t ReceiverAutoDetect::on_data_received_from_isr(const uint8_t* data, size_t len, time_us32_t timestamp)
+{
+    return on_data_received(data, len, timestamp);
+}
+
+/*!
+Parse `len` bytes of data received at time `timestamp`.
+
+Called from within the SerialPort ISR, or from update().
+
+Until a protocol is detected, the data is given to the sync detectors.
+Once a protocol is detected, the rest of the data is given to the receiver for that protocol, so no frames are lost
+between detection and the receiver being attached to the serial port.
+
+Returns the number of complete valid packets received by the detected receiver.
+*/
+size_t ReceiverAutoDetect::on_data_received(const uint8_t* data, size_t len, time_us32_t timestamp)
+{
+    ReceiverSerial* receiver = get_receiver();
+    if (receiver == nullptr) {
+        // find the detector that reaches the valid frame count first
+        size_t used_min = len;
+        for (size_t ii = 0; ii < _detectors.size(); ++ii) {
+            if (_receivers[ii] == nullptr) { // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+                continue;
+            }
+            ReceiverSyncDetector& detector = _detectors[ii]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+            const size_t used = detector.on_data_received(data, len, _valid_frame_count);
+            if (detector.get_frame_count() >= _valid_frame_count && (receiver == nullptr || used < used_min)) {
+                receiver = _receivers[ii]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+                used_min = used;
+                _protocol.store(static_cast<protocol_e>(ii), std::memory_order_release);
+            }
+        }
+        if (receiver == nullptr) {
+            return 0;
+        }
+        data += used_min; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        len -= used_min;
+    }
+    return receiver->on_data_received(data, len, timestamp);
+}
+
+void ReceiverAutoDetect::set_serial_config(size_t index, time_us32_t time)
+{
+    _serial_config_index = index;
+    _serial_config_start_time = time;
+    const serial_config_t& config = SERIAL_CONFIGS[index]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+    _serial_port.set_config(config.baudrate, config.data_bits, config.stop_bits, config.parity);
+    for (auto& detector : _detectors) {
+        detector.reset();
+    }
+}
+
+/*!
+Restart detection, starting with the current serial config.
+*/
+void ReceiverAutoDetect::restart(time_us32_t time)
+{
+    _serial_port.set_watcher(this);
+    _attached = false;
+    _protocol.store(ReceiverSyncDetector::PROTOCOL_NONE, std::memory_order_release);
+    set_serial_config(_serial_config_index, time);
+}
+
+/*!
+Advance auto-detection.
+
+Reads any data from the serial port, and moves on to the next serial config if no protocol has been detected within the dwell time.
+Once a protocol is detected, attaches the receiver to the serial port. After that the serial port is no longer read here,
+since it is read by the receiver, but detection restarts if the receiver stops receiving packets.
+
+Called periodically, with the current time.
+
+Returns the detected receiver, or nullptr if no receiver has been detected.
+*/
+ReceiverSerial* ReceiverAutoDetect::update(time_us32_t time)
+{
+    if (!_started) {
+        _started = true;
+        set_serial_config(_serial_config_index, time);
+    }
+    ReceiverSerial* receiver = get_receiver();
+    size_t len = 0;
+    while (receiver == nullptr && (len = _serial_port.read(&_read_buffer[0], _read_buffer.size())) > 0) {
+        on_data_received(&_read_buffer[0], len, time);
+        receiver = get_receiver();
+    }
+    if (receiver == nullptr) {
+        const bool frames_seen = std::any_of(_detectors.begin(), _detectors.end(), [](const ReceiverSyncDetector& detector) { return detector.get_frame_count() > 0; });
+        if (time - _serial_config_start_time > (frames_seen ? DWELL_EXTENDED_US : DWELL_US)) {
+            set_serial_config((_serial_config_index + 1) % SERIAL_CONFIGS.size(), time);
+        }
+        return nullptr;
+    }
+    if (!_attached) {
+        _attached = true;
+        receiver->attach_serial_port_watcher();
+        // hand over the detected serial config, eg so ReceiverSbus uses fast SBUS at 200000 baud
+        receiver->on_serial_config_changed();
+        _packet_sequence = receiver->get_packet_sequence();
+        _packet_time = time;
+        return receiver;
+    }
+    if (receiver->get_packet_sequence() != _packet_sequence) {
+        _packet_sequence = receiver->get_packet_sequence();
+        _packet_time = time;
+    } else if (time - _packet_time > LOST_TIMEOUT_US) {
+        restart(time);
+        return nullptr;
+    }
+    return receiver;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "serial_port.h"
+
+#include <array>
+#include <atomic>
+
+class ReceiverSerial;
+
+
+/*!
+Lightweight frame detector, used by ReceiverAutoDetect.
+
+Checks only the framing and checksum of one protocol, it does not decode channels.
+If a frame fails its check, the buffered bytes are rescanned from the next possible start byte,
+so the detector synchronizes on the first complete frame in the stream.
+*/
+class ReceiverSyncDetector {
+public:
+    enum protocol_e { PROTOCOL_SBUS, PROTOCOL_CRSF, PROTOCOL_IBUS, PROTOCOL_COUNT, PROTOCOL_NONE = PROTOCOL_COUNT };
+    enum { MAX_FRAME_SIZE = 64 };
+public:
+    explicit ReceiverSyncDetector(protocol_e protocol) : _protocol(protocol) {}
+    size_t on_data_received(const uint8_t* data, size_t len, uint32_t frame_count_limit);
+    uint32_t get_frame_count() const { return _frame_count; }
+    void reset() { _index = 0; _frame_count = 0; }
+private:
+    bool is_start_byte(uint8_t value) const;
+    size_t frame_size() const;
+    bool is_frame_valid(size_t size) const;
+private:
+    static constexpr size_t FRAME_SIZE_UNKNOWN = MAX_FRAME_SIZE + 1;
+    const protocol_e _protocol;
+    size_t _index {};
+    uint32_t _frame_count {};
+    std::array<uint8_t, MAX_FRAME_SIZE> _buffer {};
+};
+
+
+/*!
+Protocol and baudrate auto-detection, for when the receiver on a serial port is not known in advance.
+
+Cycles the serial port through the SERIAL_CONFIGS baudrate, parity, and stop bit settings, feeding the received bytes to a
+sync detector for each protocol. Once a detector has seen `valid_frame_count` valid frames, the serial port is handed to the
+receiver for that protocol, along with the detected serial config (see ReceiverSerial::on_serial_config_changed()).
+
+Construct the receivers first: each receiver attaches itself to the serial port when constructed, and ReceiverAutoDetect then
+attaches itself in their place until detection is complete.
+
+If the detected receiver stops receiving packets for LOST_TIMEOUT_US (eg because the receiver has been swapped) then
+detection restarts.
+*/
+class ReceiverAutoDetect : public SerialPortWatcherBase {
+public:
+    typedef ReceiverSyncDetector::protocol_e protocol_e;
+    struct serial_config_t {
+        uint32_t baudrate;
+        uint8_t data_bits;
+        uint8_t stop_bits;
+        uint8_t parity;
+    };
+    //! serial settings tried in turn, CRSF first since it is the most common
+    static constexpr std::array<serial_config_t, 5> SERIAL_CONFIGS {{
+        { 416666, SerialPort::DATA_BITS_8, SerialPort::STOP_BITS_1, SerialPort::PARITY_NONE }, // CRSF
+        { 115200, SerialPort::DATA_BITS_8, SerialPort::STOP_BITS_1, SerialPort::PARITY_NONE }, // IBUS
+        { 100000, SerialPort::DATA_BITS_8, SerialPort::STOP_BITS_2, SerialPort::PARITY_EVEN }, // SBUS
+        { 420000, SerialPort::DATA_BITS_8, SerialPort::STOP_BITS_1, SerialPort::PARITY_NONE }, // CRSF, unofficial baudrate
+        { 200000, SerialPort::DATA_BITS_8, SerialPort::STOP_BITS_2, SerialPort::PARITY_EVEN }, // SBUS fast
+    }};
+    static constexpr uint32_t DWELL_US = 50000; //!< time spent on each serial config
+    static constexpr uint32_t DWELL_EXTENDED_US = 100000; //!< time spent on a serial config if some valid frames have been seen
+    static constexpr uint32_t LOST_TIMEOUT_US = 1000000;
+    static constexpr uint32_t VALID_FRAME_COUNT = 3;
+public:
+    //! `receivers` is indexed by protocol, and may contain nullptr for protocols that are not to be detected.
+    ReceiverAutoDetect(SerialPort& serialPort, const std::array<ReceiverSerial*, ReceiverSyncDetector::PROTOCOL_COUNT>& receivers, uint32_t valid_frame_count);
+    ReceiverAutoDetect(SerialPort& serialPort, const std::array<ReceiverSerial*, ReceiverSyncDetector::PROTOCOL_COUNT>& receivers);
+private:
+    // ReceiverAutoDetect is not copyable or moveable
+    ReceiverAutoDetect(const ReceiverAutoDetect&) = delete;
+    ReceiverAutoDetect& operator=(const ReceiverAutoDetect&) = delete;
+    ReceiverAutoDetect(ReceiverAutoDetect&&) = delete;
+    ReceiverAutoDetect& operator=(ReceiverAutoDetect&&) = delete;
+public:
+    bool on_data_received_from_isr(uint8_t data) override;
+    size_t on_data_received_from_isr(const uint8_t* data, size_t len, time_us32_t timestamp) override;
+    size_t on_data_received(const uint8_t* data, size_t len, time_us32_t timestamp);
+    ReceiverSerial* update(time_us32_t time);
+    void restart(time_us32_t time);
+    protocol_e get_protocol() const { return _protocol.load(std::memory_order_acquire); }
+    ReceiverSerial* get_receiver() const;
+    size_t get_serial_config_index() const { return _serial_config_index; }
+private:
+    void set_serial_config(size_t index, time_us32_t time);
+private:
+    SerialPort& _serial_port;
+    const std::array<ReceiverSerial*, ReceiverSyncDetector::PROTOCOL_COUNT> _receivers;
+    const uint32_t _valid_frame_count;
+    std::array<ReceiverSyncDetector, ReceiverSyncDetector::PROTOCOL_COUNT> _detectors {
+        ReceiverSyncDetector(ReceiverSyncDetector::PROTOCOL_SBUS),
+        ReceiverSyncDetector(ReceiverSyncDetector::PROTOCOL_CRSF),
+        ReceiverSyncDetector(ReceiverSyncDetector::PROTOCOL_IBUS)
+    };
+    std::atomic<protocol_e> _protocol {ReceiverSyncDetector::PROTOCOL_NONE}; //!< set by on_data_received(), which may be called from the ISR
+    bool _attached {false}; //!< true once the detected receiver has been attached to the serial port
+    bool _started {false};
+    size_t _serial_config_index {};
+    time_us32_t _serial_config_start_time {};
+    uint32_t _packet_sequence {}; //!< packet sequence of the detected receiver, to detect loss of signal
+    time_us32_t _packet_time {};
+    enum { READ_BUFFER_SIZE = 64 };
+    std::array<uint8_t, READ_BUFFER_SIZE> _read_buffer {};
+};
@@ -1,7 +1,14 @@
 #pragma once
 
+#if defined(LIBRARY_RECEIVER_USE_LATENCY_HISTOGRAMS)
+#include "latency_histogram.h"
+#include <array>
+#endif
+#include <atomic>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
+#include <time_microseconds.h>
 
 //! control values from receiver scaled to the range [-1.0F, 1.0F]
 struct receiver_controls_t {
@@ -11,6 +18,19 @@ struct receiver_controls_t {
     float yaw;
 };
 
+/*!
+control values from receiver in q12dot4 fixed point format, ie 1.0F is represented by 2048, so range [-1.0F, 1.0F] is [-2048, 2048].
+
+Used instead of receiver_controls_t when LIBRARY_RECEIVER_USE_FIXED_POINT_CONTROLS is defined, to avoid soft-float on targets without an FPU.
+Has the same size as receiver_controls_t.
+*/
+struct receiver_controls_q12dot4_t {
+    int32_t throttle;
+    int32_t roll;
+    int32_t pitch;
+    int32_t yaw;
+};
+
 //! controls mapped to the Pulse Width Modulation (PWM) range [1000, 2000]
 struct receiver_controls_pwm_t {
     uint16_t throttle;
@@ -19,6 +39,30 @@ struct receiver_controls_pwm_t {
     uint16_t yaw;
 };
 
+//! Arrival times, as given by time_us(), of the first and last bytes of a frame, and the time the frame was published to the receiver task
+struct receiver_frame_time_t {
+    time_us32_t first_byte_us;
+    time_us32_t last_byte_us;
+    time_us32_t published_us;
+};
+
+/*!
+Receiver link statistics, counted in the same way by every protocol.
+
+The counts are totals since the receiver was created. A poor radio link shows as CRC and framing errors with few overruns,
+whereas CPU starvation (the receive buffer not being read in time) shows as overruns.
+*/
+struct receiver_stats_t {
+    uint32_t valid_frame_count; //!< frames that passed the protocol's CRC, checksum, or end byte check
+    uint32_t crc_error_count; //!< frames rejected because of a bad CRC or checksum
+    uint32_t framing_error_count; //!< frames rejected because of a bad length or end byte, or cut short by an inter-frame gap
+    uint32_t resync_count; //!< times the parser lost frame alignment and had to search for the start of a frame
+    uint32_t overrun_count; //!< bytes lost because the serial receive buffer was full
+    uint32_t superseded_frame_count; //!< valid channels frames replaced by a newer channels frame before the receiver task unpacked them
+    uint32_t byte_count; //!< bytes received
+    uint32_t frames_per_second; //!< valid frames received in the most recent one second window
+};
+
 /*!
 Abstract Base Class defining a receiver.
 */
@@ -67,6 +111,16 @@ public:
     static constexpr uint8_t AUX14= 17;
     static constexpr uint8_t AUX15= 18;
     static constexpr uint8_t AUX16= 19;
+
+    //! stages of the receiver pipeline, from the arrival of the last byte of a frame to the cockpit updating the controls
+    enum latency_stage_e {
+        LATENCY_LAST_BYTE_TO_PUBLISH, //!< parsing of the frame by the ISR
+        LATENCY_PUBLISH_TO_TASK, //!< wakeup of the receiver task
+        LATENCY_TASK_TO_CONTROLS, //!< unpacking of the frame by the receiver task
+        LATENCY_LAST_BYTE_TO_CONTROLS, //!< end to end, ie the frame age seen by the cockpit
+        LATENCY_FRAME_INTERVAL, //!< time between the last bytes of successive frames, for jitter
+        LATENCY_STAGE_COUNT
+    };
 public:
      //! 48-bit extended unique identifier (often synonymous with MAC address)
     struct EUI_48_t {
@@ -84,13 +138,42 @@ public:
 
     virtual int32_t WAIT_FOR_DATA_RECEIVED(uint32_t ticksToWait) = 0;
     virtual bool on_data_received_from_isr(uint8_t data) { (void)data; return false; }
+    //! Parse `len` bytes of data received at time `timestamp`, returns the number of complete packets received.
+    virtual size_t on_data_received(const uint8_t* data, size_t len, time_us32_t timestamp) { (void)data; (void)len; (void)timestamp; return 0; }
     virtual bool is_data_available() const { return false; }
     virtual uint8_t read_byte() { return 0; }
+    //! Read up to `max_len` received bytes into `buf` without blocking, returns the number of bytes read.
+    virtual size_t read(uint8_t* buf, size_t max_len) { (void)buf; (void)max_len; return 0; }
+    //! Returns the arrival time of the bytes returned by read(), or the current time if that is not known.
+    virtual time_us32_t get_receive_time_us() const { return time_us(); }
     virtual bool update(uint32_t tick_count_delta) = 0;
     virtual bool unpack_packet() = 0;
 
+#if defined(LIBRARY_RECEIVER_USE_FIXED_POINT_CONTROLS)
+    //! Controls in range [0,1] for throttle, [-1,1] for roll, pitch, and yaw, converted from the fixed point controls
+    receiver_controls_t get_controls() const {
+        return receiver_controls_t {
+            .throttle = q12dot4_to_float(_controls_q12dot4.throttle),
+            .roll = q12dot4_to_float(_controls_q12dot4.roll),
+            .pitch = q12dot4_to_float(_controls_q12dot4.pitch),
+            .yaw = q12dot4_to_float(_controls_q12dot4.yaw)
+        };
+    }
+    //! Controls in range [0,2048] for throttle, [-2048,2048] for roll, pitch, and yaw
+    receiver_controls_q12dot4_t get_controls_q12dot4() const { return _controls_q12dot4; }
+#else
     //! Controls in range [0,1] for throttle, [-1,1] for roll, pitch, and yaw
     receiver_controls_t get_controls() const { return _controls; }
+    //! Controls in range [0,2048] for throttle, [-2048,2048] for roll, pitch, and yaw, converted from the floating point controls
+    receiver_controls_q12dot4_t get_controls_q12dot4() const {
+        return receiver_controls_q12dot4_t {
+            .throttle = float_to_q12dot4(_controls.throttle),
+            .roll = float_to_q12dot4(_controls.roll),
+            .pitch = float_to_q12dot4(_controls.pitch),
+            .yaw = float_to_q12dot4(_controls.yaw)
+        };
+    }
+#endif
     receiver_controls_pwm_t get_controls_pwm() const { return _controls_pwm; }//!< channels in range [1000,2000]
 
     virtual uint16_t get_channel_pwm(size_t index) const = 0;
@@ -108,13 +191,174 @@ public:
     void set_switch(size_t index, uint8_t value) { _switches &= static_cast<uint32_t>(~(0b11U << (2*index))); _switches |= static_cast<uint32_t>((value & 0b11U) << (2*index)); }
     uint32_t get_switches() const { return _switches; }
 
+    int32_t get_dropped_packet_count() const { return _dropped_packet_count; }
     int32_t get_dropped_packet_count_delta() const { return _dropped_packet_count_delta; }
+    /*!
+    Copy the link statistics into `stats`.
+
+    The statistics are written by the parser (usually in the ISR) and are protected by a sequence number (seqlock),
+    so a copy taken while they are being written is detected and retaken.
+    Returns false if a consistent copy could not be made, which can happen only if the parser is being run by a lower priority task.
+    */
+    bool get_stats(receiver_stats_t& stats) const {
+        for (int ii = 0; ii < STATS_ATTEMPT_COUNT; ++ii) {
+            const uint32_t sequence = _stats_sequence.load(std::memory_order_acquire);
+            if (sequence & 1U) {
+                continue;
+            }
+            stats = _stats;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_stats_sequence.load(std::memory_order_relaxed) == sequence) {
+                stats.overrun_count = get_overrun_count();
+                stats.superseded_frame_count = _superseded_frame_count;
+                stats.frames_per_second = _frames_per_second;
+                return true;
+            }
+        }
+        return false;
+    }
+    //! Calculate the frame rate once a second, called by update() with the current time.
+    void update_frames_per_second(time_us32_t time) {
+        static constexpr time_us32_t WINDOW_US = 1'000'000;
+        const time_us32_t elapsed = time - _frames_per_second_window_start;
+        if (elapsed >= WINDOW_US) {
+            const uint32_t frame_count = _stats.valid_frame_count;
+            _frames_per_second = static_cast<uint32_t>(static_cast<uint64_t>(frame_count - _frames_per_second_frame_count) * WINDOW_US / elapsed);
+            _frames_per_second_frame_count = frame_count;
+            _frames_per_second_window_start = time;
+        }
+    }
     uint32_t get_tick_count_delta() const { return _tick_count_delta; }
+    //! Arrival times of the first and last bytes of the most recently unpacked valid frame.
+    receiver_frame_time_t get_frame_time() const { return _frame_time; }
+    //! Time elapsed at `time` since the last byte of the most recently unpacked valid frame was received.
+    time_us32_t get_frame_age_us(time_us32_t time) const { return time - _frame_time.last_byte_us; }
+#if defined(LIBRARY_RECEIVER_USE_LATENCY_HISTOGRAMS)
+    typedef LatencyHistogram<> latency_histogram_t;
+    const latency_histogram_t& get_latency_histogram(latency_stage_e stage) const { return _latency_histograms[stage]; }
+    /*!
+    Record the latencies of the most recently unpacked frame, which was unpacked by a task that woke at `task_time`
+    and passed it to the cockpit at `controls_time`. Called by the ReceiverTask.
+    */
+    void record_latencies(time_us32_t task_time, time_us32_t controls_time) {
+        // the task may have started before the frame was published, eg when the task drains the serial port itself
+        const auto elapsed = [](time_us32_t from, time_us32_t to) { return static_cast<int32_t>(to - from) > 0 ? to - from : 0; };
+        _latency_histograms[LATENCY_LAST_BYTE_TO_PUBLISH].record(elapsed(_frame_time.last_byte_us, _frame_time.published_us));
+        _latency_histograms[LATENCY_PUBLISH_TO_TASK].record(elapsed(_frame_time.published_us, task_time));
+        _latency_histograms[LATENCY_TASK_TO_CONTROLS].record(elapsed(task_time, controls_time));
+        _latency_histograms[LATENCY_LAST_BYTE_TO_CONTROLS].record(elapsed(_frame_time.last_byte_us, controls_time));
+        if (_latency_frame_count > 0) {
+            _latency_histograms[LATENCY_FRAME_INTERVAL].record(elapsed(_latency_previous_last_byte_us, _frame_time.last_byte_us));
+        }
+        _latency_previous_last_byte_us = _frame_time.last_byte_us;
+        ++_latency_frame_count;
+    }
+    void reset_latency_histograms() {
+        for (auto& histogram : _latency_histograms) {
+            histogram.reset();
+        }
+        _latency_frame_count = 0;
+    }
+#endif
     static float q12dot4_to_float(int32_t q4dot12) { return static_cast<float>(q4dot12) * (1.0F / 2048.0F); } //<! convert _q12dot4 fixed point number to floating point
+    static int32_t float_to_q12dot4(float value) { return static_cast<int32_t>(value * 2048.0F + (value < 0.0F ? -0.5F : 0.5F)); } //<! convert floating point number to _q12dot4 fixed point, rounding to nearest
+    /*!
+    Returns value * 2048 / CHANNEL_RANGE, rounded to nearest, ie a PWM offset converted to q12dot4 format.
+
+    2048 / 1000 == 256 / 125, and the division by the constant 125 is implemented by the compiler as a multiply.
+    */
+    static int32_t pwm_delta_to_q12dot4(int32_t value) {
+        static constexpr int32_t DIVISOR = CHANNEL_RANGE / 8;
+        return (value * 256 + (value < 0 ? -DIVISOR/2 : DIVISOR/2)) / DIVISOR; // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    }
+    //! Map controls in range [1000,2000] to floats in range [0,1] for throttle, [-1,1] for roll, pitch, and yaw
+    static receiver_controls_t controls_from_pwm(const receiver_controls_pwm_t& pwm) {
+        return receiver_controls_t {
+            .throttle = divide_by_channel_range(static_cast<int32_t>(pwm.throttle) - CHANNEL_LOW),
+            .roll = divide_by_channel_range(static_cast<int32_t>(pwm.roll) - CHANNEL_MIDDLE),
+            .pitch = divide_by_channel_range(static_cast<int32_t>(pwm.pitch) - CHANNEL_MIDDLE),
+            .yaw = divide_by_channel_range(static_cast<int32_t>(pwm.yaw) - CHANNEL_MIDDLE)
+        };
+    }
+    //! Map controls in range [1000,2000] to q12dot4 fixed point in range [0,2048] for throttle, [-2048,2048] for roll, pitch, and yaw
+    static receiver_controls_q12dot4_t controls_q12dot4_from_pwm(const receiver_controls_pwm_t& pwm) {
+        return receiver_controls_q12dot4_t {
+            .throttle = pwm_delta_to_q12dot4(static_cast<int32_t>(pwm.throttle) - CHANNEL_LOW),
+            .roll = pwm_delta_to_q12dot4(static_cast<int32_t>(pwm.roll) - CHANNEL_MIDDLE),
+            .pitch = pwm_delta_to_q12dot4(static_cast<int32_t>(pwm.pitch) - CHANNEL_MIDDLE),
+            .yaw = pwm_delta_to_q12dot4(static_cast<int32_t>(pwm.yaw) - CHANNEL_MIDDLE)
+        };
+    }
+    /*!
+    Returns static_cast<float>(value) / CHANNEL_RANGE_F, bit-exact, using only integer operations, for |value| < 2^24.
+
+    Multiplying by a precomputed float reciprocal is not bit-exact, so instead the correctly rounded quotient is calculated directly:
+    CHANNEL_RANGE is 1000 = 125 * 2^3, the division by 2^3 is done in the exponent, and the 24-bit mantissa is obtained by
+    an integer division by the constant 125, which the compiler implements as a multiply by a precomputed reciprocal.
+    125 is odd, so the remainder is never exactly half and there are no rounding ties.
+    This avoids a soft-float division on targets without an FPU.
+    */
+    static float divide_by_channel_range_integer(int32_t value) {
+        if (value == 0) {
+            return 0.0F;
+        }
+        static constexpr uint32_t DIVISOR = CHANNEL_RANGE / 8;
+        const uint32_t sign = value < 0 ? 0x8000'0000U : 0U;
+        const uint32_t magnitude = value < 0 ? static_cast<uint32_t>(-value) : static_cast<uint32_t>(value);
+        // normalize so that numerator / DIVISOR is in [2^23, 2^24)
+        int shift = std::countl_zero(magnitude) - 1;
+        uint32_t numerator = magnitude << static_cast<unsigned>(shift);
+        if (numerator >= DIVISOR << 24U) {
+            --shift;
+            numerator >>= 1U;
+        }
+        uint32_t mantissa = numerator / DIVISOR;
+        const uint32_t remainder = numerator - mantissa * DIVISOR;
+        if (2 * remainder > DIVISOR) {
+            ++mantissa;
+        }
+        // value / 1000 == mantissa * 2^(-shift - 3), and mantissa has 24 bits, so the unbiased exponent is 23 - shift - 3
+        int exponent = 20 - shift; // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+        if (mantissa == 1U << 24U) {
+            mantissa >>= 1U;
+            ++exponent;
+        }
+        return std::bit_cast<float>(sign | (static_cast<uint32_t>(exponent + 127) << 23U) | (mantissa & 0x7F'FFFFU)); // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    }
+    //! Returns static_cast<float>(value) / CHANNEL_RANGE_F, using the integer implementation on targets without an FPU.
+    static float divide_by_channel_range(int32_t value) {
+#if defined(__SOFTFP__)
+        return divide_by_channel_range_integer(value);
+#else
+        return static_cast<float>(value) / CHANNEL_RANGE_F;
+#endif
+    }
 
     bool isPacket_received() const { return _packet_received; }
     bool isNew_packet_available() const { return _new_packet_available; }
     void clearNew_packet_available() { _new_packet_available = false; }
+protected:
+    virtual uint32_t get_overrun_count() const { return 0; }
+    //! Called by the parser before and after it changes _stats, so that get_stats() can detect a torn read.
+    inline void begin_stats_update() {
+        _stats_sequence.store(_stats_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    inline void end_stats_update() {
+        _stats_sequence.store(_stats_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    //! Set the PWM controls and map them to the normalized controls
+    void set_controls(uint16_t throttle, uint16_t roll, uint16_t pitch, uint16_t yaw) {
+        _controls_pwm.throttle = throttle;
+        _controls_pwm.roll = roll;
+        _controls_pwm.pitch = pitch;
+        _controls_pwm.yaw = yaw;
+#if defined(LIBRARY_RECEIVER_USE_FIXED_POINT_CONTROLS)
+        _controls_q12dot4 = controls_q12dot4_from_pwm(_controls_pwm);
+#else
+        _controls = controls_from_pwm(_controls_pwm);
+#endif
+    }
 protected:
     uint8_t _packet_received {false}; // may be invalid packet
     uint8_t _new_packet_available {false};
@@ -124,8 +368,25 @@ protected:
     int32_t _dropped_packet_count {};
     int32_t _dropped_packet_count_previous {};
     uint32_t _tick_count_delta {};
+    receiver_frame_time_t _frame_time {}; //!< arrival time of the most recently unpacked valid frame
+    static constexpr int STATS_ATTEMPT_COUNT = 4;
+    receiver_stats_t _stats {}; //!< written by the parser only, between begin_stats_update() and end_stats_update()
+    std::atomic<uint32_t> _stats_sequence {0};
+    uint32_t _superseded_frame_count {}; //!< written by the receiver task
+    uint32_t _frames_per_second {};
+    uint32_t _frames_per_second_frame_count {};
+    time_us32_t _frames_per_second_window_start {};
+#if defined(LIBRARY_RECEIVER_USE_LATENCY_HISTOGRAMS)
+    std::array<latency_histogram_t, LATENCY_STAGE_COUNT> _latency_histograms {};
+    time_us32_t _latency_previous_last_byte_us {};
+    uint32_t _latency_frame_count {};
+#endif
     uint32_t _switches {}; // 16 2 or 3 positions switches, each using 2-bits
+#if defined(LIBRARY_RECEIVER_USE_FIXED_POINT_CONTROLS)
+    receiver_controls_q12dot4_t _controls_q12dot4 {}; //!< the main 4 channels in q12dot4 fixed point format
+#else
     receiver_controls_t _controls {}; //!< the main 4 channels
+#endif
     receiver_controls_pwm_t _controls_pwm {}; //!< the main 4 channels in PWM range
     uint32_t _auxiliary_channel_count {};
 };
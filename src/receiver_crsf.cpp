@@ -1,170 +1,487 @@
 #include "receiver_crsf.h"
+#include "unpack_11bit_channels.h"
+
+#include <algorithm>
+#include <cstring>
 
 
 ReceiverCrsf::ReceiverCrsf(SerialPort& serialPort) :
     ReceiverSerial(serialPort)
 {
     _auxiliary_channel_count = CHANNEL_COUNT - STICK_COUNT;
+    // an RC channels frame is sync, length, type, channel data, and CRC. Other frames may be shorter, but are far less frequent
+    set_data_ready_threshold(CHANNEL_DATA_SIZE + 4);
+}
+
+// the fixed point mapping must give exactly the same result as the float calculation it replaces
+namespace {
+constexpr bool map_to_pwm_matches_float()
+{
+    constexpr float CHANNEL_SCALE = 0.62477120195241F;
+    constexpr float CHANNEL_OFFSET = 880.53935326418548F;
+    for (uint16_t raw = 0; raw < 2048; ++raw) { // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+        if (ReceiverCrsf::map_to_pwm(raw) != static_cast<uint16_t>(CHANNEL_SCALE * static_cast<float>(raw) + CHANNEL_OFFSET)) {
+            return false;
+        }
+    }
+    return true;
 }
+} // anonymous namespace
+static_assert(map_to_pwm_matches_float());
 
 uint16_t ReceiverCrsf::get_channel_pwm(size_t index) const
 {
     if (index >= CHANNEL_COUNT) {
         return CHANNEL_LOW;
     }
-    /* 
-    conversion from RC value to PWM
-    for FRAMETYPE_RC_CHANNELS_PACKED(0x16)
-           RC     PWM
-    min   172 ->  988us
-    mid   992 -> 1500us
-    max  1811 -> 2012us
-    scale factor = (2012-988) / (1811-172) = 0.62477120195241
-    offset = 988 - 172 * 0.62477120195241 = 880.53935326418548
-    */
-    static constexpr float CHANNEL_SCALE = 0.62477120195241F;
-    static constexpr float CHANNEL_OFFSET = 880.53935326418548F;
-
-    return static_cast<uint16_t>(CHANNEL_SCALE * static_cast<float>(_channels[index]) + CHANNEL_OFFSET);
+    if (_subset_channels & (1U << index)) {
+        // channels from subset RC channels packets are stored as PWM
+        return _channels[index];
+    }
+#if defined(LIBRARY_RECEIVER_USE_LAZY_CHANNEL_DECODING)
+    if (!is_channel_decoded(index)) {
+        _channels[index] = unpack_11bit_channel(&_channel_data[0], index);
+        set_channel_decoded(index);
+    }
+#endif
+    return map_to_pwm(_channels[index]);
 }
 
 /*!
-Called from within ReceiverSerial ISR.
+Parse `len` bytes of data received at time `timestamp`.
+
+Called from within the SerialPort ISR, or from the ReceiverTask when using time-based scheduling.
+
+Once the sync, length, and type bytes have been received the rest of the packet is copied in bulk.
+The CRC is calculated as the packet is received, and packets with a bad CRC are counted as errors and not published.
+
+A bad length byte may itself be a sync byte, so is rescanned as the start of the next packet.
+If a packet has a bad CRC, the bytes already buffered are rescanned from the next sync byte, before the remaining input,
+rather than being discarded. So after a corrupted length byte or a dropped byte the parser resynchronizes within one packet,
+rather than losing the following packets too.
+
+Returns the number of complete valid packets received.
 */
-bool ReceiverCrsf::on_data_received_from_isr(uint8_t data)
+size_t ReceiverCrsf::on_data_received(const uint8_t* data, size_t len, time_us32_t timestamp) // NOLINT(readability-function-cognitive-complexity)
 {
-    const time_us32_t time_now_us = time_us();
-    if (time_now_us > _start_time + TIME_NEEDED_PER_FRAME_US) { // cppcheck-suppress unsignedLessThanZero
+    begin_stats_update();
+    _stats.byte_count += static_cast<uint32_t>(len);
+    if (timestamp > _start_time + _time_needed_per_frame_us && _packet_index != 0) { // cppcheck-suppress unsignedLessThanZero
+        // the gap cut short the packet being received, an idle gap between packets is not a drop
         _packet_index = 0;
+        _packet_size = 0;
+        _packet_is_channels = true;
         ++_dropped_packet_count;
+        ++_stats.framing_error_count;
     }
 
-    switch (_packet_index) {
-    case 0:
-        if (data != CRSF_SYNC_BYTE && data != EDGE_TX_SYNC_BYTE) {
-            _packet_is_empty = true;
-            return false;
+    size_t packet_count = 0;
+    size_t ii = 0;
+    // bytes of a bad packet that are to be rescanned, these are processed before the remaining input
+    std::array<uint8_t, MAX_PACKET_SIZE> rescan; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+    size_t rescan_index = 0;
+    size_t rescan_len = 0;
+    while (rescan_index < rescan_len || ii < len) {
+        const bool rescanning = rescan_index < rescan_len;
+        const uint8_t* const input = rescanning ? &rescan[rescan_index] : &data[ii]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        const size_t available = rescanning ? rescan_len - rescan_index : len - ii;
+        size_t consumed = 1;
+        packet_u& packet = _packet_is_channels ? _packets[packet_write_index()] : _other_packets[other_packet_write_index()];
+        if (_packet_index < 3) {
+            const uint8_t value = input[0]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            switch (_packet_index) {
+            case 0:
+                if (value != CRSF_SYNC_BYTE && value != EDGE_TX_SYNC_BYTE) {
+                    skip_byte_searching_for_start();
+                    break;
+                }
+                _searching_for_start = false;
+                _start_time = timestamp;
+                packet.data[0] = value;
+                _packet_index = 1;
+                break;
+            case 1:
+                // length is length of type, payload, and CRC, so must be at least 2
+                if (value < 2 || value > MAX_PACKET_SIZE - 2) {
+                    // the bad length byte may be the sync byte of the next packet, so rescan it
+                    _packet_index = 0;
+                    ++_stats.framing_error_count;
+                    ++_stats.resync_count;
+                    _searching_for_start = true;
+                    consumed = 0;
+                    break;
+                }
+                _packet_size = value + 2U;
+                packet.data[1] = value;
+                _packet_index = 2;
+                break;
+            default:
+                _packet_type = value;
+                _crc = calculate_crc(0, value);
+                _packet_is_channels = is_channels_frame(value);
+                if (_packet_is_channels) {
+                    packet.data[2] = value;
+                } else {
+                    // the sync and length bytes were put in the channels packet, so move them to the other packet
+                    packet_u& other_packet = _other_packets[other_packet_write_index()];
+                    other_packet.data[0] = packet.data[0];
+                    other_packet.data[1] = packet.data[1];
+                    other_packet.data[2] = value;
+                }
+                _packet_index = 3;
+                break;
+            }
+        } else {
+            consumed = std::min(_packet_size - _packet_index, available);
+            memcpy(&packet.data[_packet_index], input, consumed);
+            _crc = crc8_dvb_s2_t::calculate(_crc, input, consumed);
+            _packet_index += consumed;
+        }
+        if (rescanning) {
+            rescan_index += consumed;
+        } else {
+            ii += consumed;
         }
-        _start_time = time_now_us;
-        break;
-    case 1:
-        _packet_size = data + 2;
-        break;
-    case 2:
-        _packet_type = data;
-        break;
-    }
-
-    _packet_isr.data[_packet_index] = data;
-    ++_packet_index;
 
-    if (_packet_size != 0 && _packet_index == _packet_size) {
-        _packet_index = 0;
-        _packet_size = 0;
-        _packet = _packet_isr;
-        return true;
+        if (_packet_index == _packet_size && _packet_index != 0) {
+            const size_t packet_size = _packet_size;
+            const bool is_channels = _packet_is_channels;
+            _packet_index = 0;
+            _packet_size = 0;
+            _packet_is_channels = true;
+            // the CRC includes the received CRC byte, so is zero for a valid packet
+            if (_crc == 0) {
+                if (is_channels) {
+                    _other_packet_published_last = false;
+                    publish_packet_from_isr(timestamp);
+                } else {
+                    publish_other_packet_from_isr();
+                }
+                ++packet_count;
+                continue;
+            }
+            ++_error_packet_count;
+            ++_stats.crc_error_count;
+            // rescan from the next sync byte in the bad packet
+            const auto* const begin = &packet.data[1];
+            const auto* const end = &packet.data[packet_size];
+            const auto* const sync = std::find_if(begin, end, [](uint8_t value) { return value == CRSF_SYNC_BYTE || value == EDGE_TX_SYNC_BYTE; });
+            if (sync != end) {
+                ++_stats.resync_count;
+                _searching_for_start = true;
+                // the bytes to rescan are the rest of the bad packet followed by any unprocessed rescan bytes.
+                // If the bad packet was received while rescanning then it came entirely from the rescan buffer,
+                // so the unprocessed rescan bytes can be moved down without overwriting them.
+                const auto count = static_cast<size_t>(end - sync);
+                const size_t remaining = rescan_len - rescan_index;
+                memmove(&rescan[count], &rescan[rescan_index], remaining);
+                memcpy(&rescan[0], sync, count);
+                rescan_index = 0;
+                rescan_len = count + remaining;
+            }
+        }
     }
-    return false;
+    end_stats_update();
+    return packet_count;
 }
 
 uint8_t ReceiverCrsf::calculate_crc(uint8_t crc, uint8_t value)
 {
-    static constexpr uint8_t POLYNOMIAL = 0xD5;
+    return crc8_dvb_s2_t::update(crc, value);
+}
 
-    crc ^= value;
-    for (int ii = 0; ii < 8; ++ii) { // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
-        const uint8_t topBit = crc & 0x80U;
-        crc <<= 1U;
-        if (topBit) {
-            crc ^= POLYNOMIAL;
+/*!
+CRC of the type and payload bytes, ie excluding the sync, length, and CRC bytes.
+*/
+uint8_t ReceiverCrsf::calculate_crc(const packet_u& packet)
+{
+    // length is length of type, payload, and CRC
+    return packet.value.length < 2 ? 0 : crc8_dvb_s2_t::calculate(0, &packet.data[2], packet.value.length - 1U);
+}
+
+/*!
+Inner CRC of a command frame: the CRC of the type and payload bytes, excluding the command CRC and frame CRC bytes.
+*/
+uint8_t ReceiverCrsf::calculate_command_crc(const packet_u& packet)
+{
+    return packet.value.length < 3 ? 0 : crc8_command_t::calculate(0, &packet.data[2], packet.value.length - 2U);
+}
+
+/*!
+Unpack a subset RC channels packet (0x17), used by ELRS to send fewer channels, at higher resolution, at high packet rates.
+
+The first payload byte is the configuration:
+    bits 0-4 starting channel
+    bits 5-6 resolution: 0 is 10 bits, 1 is 11 bits, 2 is 12 bits, 3 is 13 bits
+    bit 7 reserved
+The channels follow, packed least significant bit first. The channel count is the number of whole channels in the rest of the payload.
+
+Channel values are mapped to PWM as 988 + value / 2^(resolution - 10), so the full range of any resolution maps to [988,2011].
+Only the channels in the subset are updated, channels beyond CHANNEL_COUNT are ignored.
+
+Returns false if the packet is too short to hold any channel data, or if the starting channel is out of range.
+*/
+bool ReceiverCrsf::unpack_subset_rc_channels(const packet_u& packet)
+{
+    enum { STARTING_CHANNEL_MASK = 0x1F, RESOLUTION_SHIFT = 5, RESOLUTION_MASK = 0x03, RESOLUTION_MIN = 10 };
+    static constexpr uint16_t PWM_MIN = 988;
+
+    enum { MIN_LENGTH = 4 }; // type, configuration byte, at least one byte of channel data, and CRC
+    if (packet.value.length < MIN_LENGTH) {
+        return false;
+    }
+    const uint8_t configuration = packet.value.payload[0];
+    const size_t starting_channel = configuration & STARTING_CHANNEL_MASK;
+    if (starting_channel >= CHANNEL_COUNT) {
+        return false;
+    }
+    const unsigned resolution_extra_bits = (configuration >> RESOLUTION_SHIFT) & RESOLUTION_MASK;
+    const unsigned resolution = RESOLUTION_MIN + resolution_extra_bits;
+    // length is length of type, payload, and CRC, the payload is the configuration byte followed by the channel data
+    const size_t data_size = packet.value.length - 3U;
+    const size_t channel_count = std::min(data_size * 8 / resolution, CHANNEL_COUNT - starting_channel);
+
+    const uint8_t* data = &packet.value.payload[1];
+    uint32_t bits = 0;
+    unsigned bit_count = 0;
+    for (size_t ii = starting_channel; ii < starting_channel + channel_count; ++ii) {
+        while (bit_count < resolution) {
+            bits |= static_cast<uint32_t>(*data) << bit_count;
+            ++data; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            bit_count += 8;
         }
+        const uint32_t value = bits & ((1U << resolution) - 1U);
+        bits >>= resolution;
+        bit_count -= resolution;
+        _channels[ii] = static_cast<uint16_t>(PWM_MIN + (value >> resolution_extra_bits));
+        _subset_channels |= 1U << ii;
+#if defined(LIBRARY_RECEIVER_USE_LAZY_CHANNEL_DECODING)
+        set_channel_decoded(ii);
+#endif
     }
-    return crc;
+    return true;
 }
 
-uint8_t ReceiverCrsf::calculate_crc() const
+/*!
+Unpack the packet in slot `packet_index` into the member data, the CRC has already been checked by on_data_received().
+
+Returns true if an RC channels packet or subset RC channels packet was unpacked, false otherwise.
+*/
+bool ReceiverCrsf::unpack_packet_slot(size_t packet_index)
 {
-    uint8_t crc = calculate_crc(0, _packet.value.type);
-    for (size_t ii = 2; ii < _packet.value.length; ++ii) { // length is length of type, payload, and CRC
-        crc = calculate_crc(crc, _packet.value.payload[ii - 2]);
+    const packet_u& packet = _packets[packet_index];
+
+    if (packet.value.type == FRAMETYPE_RC_CHANNELS_PACKED) {
+#if defined(LIBRARY_RECEIVER_USE_LAZY_CHANNEL_DECODING)
+        // only decode the sticks, the other channels are decoded on demand by get_channel_pwm()
+        memcpy(&_channel_data[0], &packet.value.payload[0], CHANNEL_DATA_SIZE);
+        unpack_11bit_channels<STICK_COUNT>(&_channels[0], &packet.value.payload[0]);
+        _decoded_channels = STICK_CHANNELS_MASK;
+#else
+        unpack_11bit_channels<CHANNEL_COUNT>(&_channels[0], &packet.value.payload[0]);
+#endif
+        _subset_channels = 0;
+    } else if (packet.value.type == FRAMETYPE_SUBSET_RC_CHANNELS_PACKED) {
+        if (!unpack_subset_rc_channels(packet)) {
+            return false;
+        }
+    } else {
+        return false;
     }
-    return crc;
+    // Map channels in range [1000,2000] to floats in range [0,1] for throttle, [-1,1] for roll, pitch yaw
+    // qualified calls, so not virtual
+    set_controls(ReceiverCrsf::get_channel_pwm(THROTTLE), ReceiverCrsf::get_channel_pwm(ROLL), ReceiverCrsf::get_channel_pwm(PITCH), ReceiverCrsf::get_channel_pwm(YAW));
+
+    return true;
 }
 
-uint8_t ReceiverCrsf::get_received_crc() const
+/*!
+Handle the most recently published frame that does not carry channel data, eg a command frame.
+
+Only the newest such frame is handled, any older ones published since the last call are skipped.
+
+The frame is copied out of its slot, and the copy is only acted on once the sequence number shows the read was not torn,
+so a command is never acted on twice, or acted on from a slot the ISR was overwriting.
+Other frames are rare, so copying them costs little.
+
+Returns true if there was a new frame.
+*/
+bool ReceiverCrsf::unpack_other_packet()
 {
-    return _packet.value.payload[_packet.value.length - 2];
+    uint32_t sequence = get_other_packet_sequence();
+    if (sequence == _other_packet_sequence_read) {
+        return false;
+    }
+    while (true) {
+        const packet_u packet = _other_packets[packet_read_index(sequence)];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_other_packet_sequence.load(std::memory_order_relaxed) == sequence) {
+            _other_packet_sequence_read = sequence;
+            if (packet.value.type == FRAMETYPE_COMMAND) {
+                handle_command(packet);
+            }
+            return true;
+        }
+        sequence = get_other_packet_sequence();
+    }
 }
 
 /*!
-If the packet is valid then unpack it into the member data and set the packet to empty.
+Speed negotiation: the receiver proposes a new baudrate in a command frame, the flight controller responds and, if it accepted,
+switches to the new baudrate once the response has been sent. See update_baudrate().
 
-Returns true if a valid packet received, false otherwise.
+Speed proposal payload:
+    destination address, origin address, COMMAND_SUBCMD_GENERAL, COMMAND_SUBCMD_GENERAL_CRSF_SPEED_PROPOSAL,
+    port id, baudrate (4 bytes, big endian), command CRC
 
+Called from the task, on a copy of the packet whose read has been checked not to be torn, so may write to the serial port.
 */
-bool ReceiverCrsf::unpack_packet()
+void ReceiverCrsf::handle_command(const packet_u& packet)
 {
-    if (calculate_crc() != get_received_crc()) {
-        _packet_is_empty = true;
-        return false;
+    enum { DESTINATION = 0, COMMAND = 2, SUBCOMMAND = 3, PORT_ID = 4, BAUDRATE = 5 };
+    enum { SPEED_PROPOSAL_LENGTH = 12 }; // type + 10 payload bytes + CRC
+
+    const auto& payload = packet.value.payload;
+    if (packet.value.length != SPEED_PROPOSAL_LENGTH
+        || payload[DESTINATION] != ADDRESS_FLIGHT_CONTROLLER
+        || payload[COMMAND] != COMMAND_SUBCMD_GENERAL
+        || payload[SUBCOMMAND] != COMMAND_SUBCMD_GENERAL_CRSF_SPEED_PROPOSAL
+        || get_received_command_crc(packet) != calculate_command_crc(packet)) {
+        return;
     }
+    const uint32_t baudrate = (static_cast<uint32_t>(payload[BAUDRATE]) << 24U)
+        | (static_cast<uint32_t>(payload[BAUDRATE + 1]) << 16U)
+        | (static_cast<uint32_t>(payload[BAUDRATE + 2]) << 8U)
+        | payload[BAUDRATE + 3];
+    const bool accepted = is_baudrate_supported(baudrate);
 
-    if (_packet.value.type == FRAMETYPE_RC_CHANNELS_PACKED) {
-#if false
-        union channels_u { 
-            std::array<uint8_t, MAX_PACKET_SIZE - 3> payload;
-            rc_channels_packed_t rc;
-        };
-        channels_u channels { .payload = _packet.value.payload };
-        _channels[0] = channels.rc.chan0;
-        _channels[1] = channels.rc.chan1;
-        _channels[2] = channels.rc.chan2;
-        _channels[3] = channels.rc.chan3;
-        _channels[4] = channels.rc.chan4;
-        _channels[5] = channels.rc.chan5;
-        _channels[6] = channels.rc.chan6;
-        _channels[7] = channels.rc.chan7;
-        _channels[8] = channels.rc.chan8;
-        _channels[9] = channels.rc.chan9;
-        _channels[10] = channels.rc.chan10;
-        _channels[11] = channels.rc.chan11;
-        _channels[12] = channels.rc.chan12;
-        _channels[13] = channels.rc.chan13;
-        _channels[14] = channels.rc.chan14;
-        _channels[15] = channels.rc.chan15;
-#else
-        const rc_channels_packed_t* const rcChannels = reinterpret_cast<rc_channels_packed_t*>(&_packet.value.payload[0]);
-        _channels[0] = rcChannels->chan0;
-        _channels[1] = rcChannels->chan1;
-        _channels[2] = rcChannels->chan2;
-        _channels[3] = rcChannels->chan3;
-        _channels[4] = rcChannels->chan4;
-        _channels[5] = rcChannels->chan5;
-        _channels[6] = rcChannels->chan6;
-        _channels[7] = rcChannels->chan7;
-        _channels[8] = rcChannels->chan8;
-        _channels[9] = rcChannels->chan9;
-        _channels[10] = rcChannels->chan10;
-        _channels[11] = rcChannels->chan11;
-        _channels[12] = rcChannels->chan12;
-        _channels[13] = rcChannels->chan13;
-        _channels[14] = rcChannels->chan14;
-        _channels[15] = rcChannels->chan15;
-#endif
-        _packet_is_empty = false;
+    const packet_u response = speed_response_packet(payload[PORT_ID], accepted);
+    _serial_port.write(&response.data[0], response.value.length + 2U);
+
+    if (accepted && baudrate != _serial_port.get_baudrate()) {
+        if (_speed_negotiation_state == SPEED_NEGOTIATION_IDLE) {
+            _baudrate_original = _serial_port.get_baudrate();
+        }
+        _baudrate_proposed = baudrate;
+        _speed_negotiation_state = SPEED_NEGOTIATION_RESPONSE_SENT;
+    }
+}
+
+/*!
+Returns true if `baudrate` may be used for CRSF.
+
+The standard baudrates, and any baudrate in the SerialPort baudrate table from BAUD_RATE up to BAUD_RATE_MAX are supported.
+*/
+bool ReceiverCrsf::is_baudrate_supported(uint32_t baudrate)
+{
+    if (baudrate == BAUD_RATE || baudrate == BAUD_RATE_UNOFFICIAL) {
         return true;
     }
-// Map channels in range [1000,2000] to floats in range [0,1] for throttle, [-1,1] for roll, pitch yaw
-    _controls.throttle = (static_cast<float>(_channels[THROTTLE]) - CHANNEL_RANGE_F) / CHANNEL_RANGE_F;
-    _controls.roll = (static_cast<float>(_channels[ROLL]) - CHANNEL_MIDDLE_F) / CHANNEL_RANGE_F;
-    _controls.pitch = (static_cast<float>(_channels[PITCH]) - CHANNEL_MIDDLE_F) / CHANNEL_RANGE_F;
-    _controls.yaw = (static_cast<float>(_channels[YAW]) - CHANNEL_MIDDLE_F) / CHANNEL_RANGE_F;
+    if (baudrate < BAUD_RATE || baudrate > BAUD_RATE_MAX) {
+        return false;
+    }
+    return std::find(SerialPort::baudrates.begin(), SerialPort::baudrates.end(), baudrate) != SerialPort::baudrates.end();
+}
+
+/*!
+Speed response, sent from the flight controller to the receiver.
+
+Payload:
+    ADDRESS_CRSF_RECEIVER, ADDRESS_FLIGHT_CONTROLLER, COMMAND_SUBCMD_GENERAL, COMMAND_SUBCMD_GENERAL_CRSF_SPEED_RESPONSE,
+    port id, status (1 if accepted, 0 if rejected), command CRC
+*/
+ReceiverCrsf::packet_u ReceiverCrsf::speed_response_packet(uint8_t port_id, bool accepted)
+{
+    enum { SPEED_RESPONSE_LENGTH = 9 }; // type + 7 payload bytes + CRC
+    enum { COMMAND_CRC = 6, CRC = 7 };
+
+    packet_u packet {};
+    packet.value.sync = CRSF_SYNC_BYTE;
+    packet.value.length = SPEED_RESPONSE_LENGTH;
+    packet.value.type = FRAMETYPE_COMMAND;
+    packet.value.payload = {
+        ADDRESS_CRSF_RECEIVER,
+        ADDRESS_FLIGHT_CONTROLLER,
+        COMMAND_SUBCMD_GENERAL,
+        COMMAND_SUBCMD_GENERAL_CRSF_SPEED_RESPONSE,
+        port_id,
+        static_cast<uint8_t>(accepted ? 1 : 0)
+    };
+    packet.value.payload[COMMAND_CRC] = calculate_command_crc(packet);
+    packet.value.payload[CRC] = calculate_crc(packet);
+    return packet;
+}
+
+/*!
+Returns the time allowed to receive a frame, TIME_NEEDED_PER_FRAME_US scaled to `baudrate`.
+*/
+uint32_t ReceiverCrsf::time_needed_per_frame_us(uint32_t baudrate)
+{
+    return baudrate == 0 ? TIME_NEEDED_PER_FRAME_US : static_cast<uint32_t>(static_cast<uint64_t>(TIME_NEEDED_PER_FRAME_US) * BAUD_RATE / baudrate);
+}
+
+/*!
+Set the serial port baudrate, and scale the time allowed to receive a frame to match.
+*/
+void ReceiverCrsf::set_baudrate(uint32_t baudrate)
+{
+    _serial_port.set_baudrate(baudrate);
+    _time_needed_per_frame_us = time_needed_per_frame_us(baudrate);
+}
+
+/*!
+Scale the time allowed to receive a frame to the serial port baudrate, eg BAUD_RATE_UNOFFICIAL as set by ReceiverAutoDetect.
+*/
+void ReceiverCrsf::on_serial_config_changed()
+{
+    _time_needed_per_frame_us = time_needed_per_frame_us(_serial_port.get_baudrate());
+}
+
+/*!
+Advance the speed negotiation.
+
+After a speed response has been sent, switch to the proposed baudrate. This is done on the next call, rather than when the
+response is sent, so that the response is not cut off by the baudrate change.
+If no valid packets have been received within BAUD_RATE_FALLBACK_TIMEOUT_US of switching, then revert to the baudrate used before the negotiation.
+
+Called by update(), with the current time.
+*/
+void ReceiverCrsf::update_baudrate(time_us32_t time)
+{
+    switch (_speed_negotiation_state) {
+    case SPEED_NEGOTIATION_RESPONSE_SENT:
+        set_baudrate(_baudrate_proposed);
+        _baudrate_switch_time_us = time;
+        _baudrate_switch_packet_sequence = get_packet_sequence();
+        _speed_negotiation_state = SPEED_NEGOTIATION_CONFIRMING;
+        break;
+    case SPEED_NEGOTIATION_CONFIRMING:
+        if (get_packet_sequence() != _baudrate_switch_packet_sequence) {
+            _speed_negotiation_state = SPEED_NEGOTIATION_IDLE;
+        } else if (time - _baudrate_switch_time_us > BAUD_RATE_FALLBACK_TIMEOUT_US) {
+            set_baudrate(_baudrate_original);
+            ++_baudrate_fallback_count;
+            _speed_negotiation_state = SPEED_NEGOTIATION_IDLE;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/*!
+Advance any speed negotiation, and then unpack any received packet.
 
-    _controls_pwm.throttle = _channels[THROTTLE];
-    _controls_pwm.roll = _channels[ROLL];
-    _controls_pwm.pitch = _channels[PITCH];
-    _controls_pwm.yaw = _channels[YAW];
+The speed negotiation is advanced first, so a baudrate switch happens on the call after the one that sent the speed response.
 
-    _packet_is_empty = true;
-    return false;
+Returns true if an RC channels packet was received.
+*/
+bool ReceiverCrsf::update(uint32_t tick_count_delta)
+{
+    if (_speed_negotiation_state != SPEED_NEGOTIATION_IDLE) {
+        update_baudrate(time_us());
+    }
+    // update_packet() only calls unpack_packet() if there is a new channels frame, so handle any other frame first
+    unpack_other_packet();
+    return update_packet<ReceiverCrsf>(tick_count_delta);
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "crc8.h"
 #include "receiver_serial.h"
 
 
@@ -14,9 +15,12 @@ public:
     static constexpr uint8_t STOP_BITS = 1;
     static constexpr uint32_t BAUD_RATE = 416666;
     static constexpr uint32_t BAUD_RATE_UNOFFICIAL = 420000;
+    static constexpr uint32_t BAUD_RATE_MAX = 2000000; //!< maximum baudrate accepted in speed negotiation
+    //! if no valid packets are received within this time of switching to a negotiated baudrate, then fall back to the baudrate used before the negotiation
+    static constexpr uint32_t BAUD_RATE_FALLBACK_TIMEOUT_US = 1000000;
 
     static constexpr uint32_t CHANNEL_COUNT = 16;
-    static constexpr uint32_t TIME_NEEDED_PER_FRAME_US = 1750;
+    static constexpr uint32_t TIME_NEEDED_PER_FRAME_US = 1750; //!< at BAUD_RATE, scaled to the negotiated baudrate
 
     static constexpr uint8_t CRSF_SYNC_BYTE = 0xC8;
     static constexpr uint8_t EDGE_TX_SYNC_BYTE = 0xEE;
@@ -67,8 +71,15 @@ public:
     static constexpr uint8_t COMMAND_SUBCMD_GENERAL_CRSF_SPEED_PROPOSAL = 0x70;
     static constexpr uint8_t COMMAND_SUBCMD_GENERAL_CRSF_SPEED_RESPONSE = 0x71;
 
+    enum speed_negotiation_state_e { SPEED_NEGOTIATION_IDLE, SPEED_NEGOTIATION_RESPONSE_SENT, SPEED_NEGOTIATION_CONFIRMING };
+
     static constexpr uint8_t MAX_PACKET_SIZE = 64;
 
+    //! CRC8 DVB-S2, used for the frame CRC
+    typedef Crc8<0xD5> crc8_dvb_s2_t;
+    //! CRC8 with polynomial 0xBA, used for the inner CRC of command frames
+    typedef Crc8<0xBA> crc8_command_t;
+
     union packet_u { 
         std::array<uint8_t, MAX_PACKET_SIZE> data;
         struct value_t {
@@ -79,27 +90,6 @@ public:
             std::array<uint8_t, MAX_PACKET_SIZE - 3> payload;
         } value;
     };
-#pragma pack(push, 1)
-    struct rc_channels_packed_t {
-        // 176 bits of data (11 bits per channel * 16 channels) = 22 bytes.
-        unsigned int chan0 : 11;
-        unsigned int chan1 : 11;
-        unsigned int chan2 : 11;
-        unsigned int chan3 : 11;
-        unsigned int chan4 : 11;
-        unsigned int chan5 : 11;
-        unsigned int chan6 : 11;
-        unsigned int chan7 : 11;
-        unsigned int chan8 : 11;
-        unsigned int chan9 : 11;
-        unsigned int chan10 : 11;
-        unsigned int chan11 : 11;
-        unsigned int chan12 : 11;
-        unsigned int chan13 : 11;
-        unsigned int chan14 : 11;
-        unsigned int chan15 : 11;
-    };
-#pragma pack(pop)
 public:
     explicit ReceiverCrsf(SerialPort& serialPort);
 private:
@@ -109,21 +99,101 @@ private:
     ReceiverCrsf(ReceiverCrsf&&) = delete;
     ReceiverCrsf& operator=(ReceiverCrsf&&) = delete;
 public:
-    virtual bool on_data_received_from_isr(uint8_t data) override;
+    virtual size_t on_data_received(const uint8_t* data, size_t len, time_us32_t timestamp) override;
     virtual uint16_t get_channel_pwm(size_t index) const override;
-    virtual bool unpack_packet() override;
+    virtual bool update(uint32_t tick_count_delta) override;
+    virtual bool unpack_packet() override { return unpack_newest_packet<ReceiverCrsf>(); }
+    virtual void on_serial_config_changed() override;
+    bool unpack_other_packet();
+    void update_baudrate(time_us32_t time);
+    static bool is_baudrate_supported(uint32_t baudrate);
+    static packet_u speed_response_packet(uint8_t port_id, bool accepted);
+    speed_negotiation_state_e get_speed_negotiation_state() const { return _speed_negotiation_state; }
+    uint32_t get_time_needed_per_frame_us() const { return _time_needed_per_frame_us; }
+    //! Number of times a negotiated baudrate was abandoned because no packets were received at it.
+    int32_t get_baudrate_fallback_count() const { return _baudrate_fallback_count; }
+    /*!
+    Map raw CRSF channel value to PWM, for FRAMETYPE_RC_CHANNELS_PACKED(0x16)
+           RC     PWM
+    min   172 ->  988us
+    mid   992 -> 1500us
+    max  1811 -> 2012us
+    scale factor = (2012-988) / (1811-172) = 0.62477120195241
+    offset = 988 - 172 * 0.62477120195241 = 880.53935326418548
+
+    Calculated in Q16 fixed point, bit-exact with `static_cast<uint16_t>(0.62477120195241F * raw + 880.53935326418548F)`
+    for all 2048 raw values (checked at compile time in receiver_crsf.cpp).
+    The offset was found by exhaustive search: any value in [57707037, 57707070] gives the same result as the float calculation.
+    */
+    static constexpr uint16_t map_to_pwm(uint16_t raw) {
+        constexpr uint32_t SCALE_Q16 = 40945; // round(0.62477120195241 * 2^16)
+        constexpr uint32_t OFFSET_Q16 = 57707053;
+        return static_cast<uint16_t>((SCALE_Q16 * raw + OFFSET_Q16) >> 16U);
+    }
+    //! RC channels and subset RC channels frames carry channel data, all other frames are published separately from them.
+    static constexpr bool is_channels_frame(uint8_t type) { return type == FRAMETYPE_RC_CHANNELS_PACKED || type == FRAMETYPE_SUBSET_RC_CHANNELS_PACKED; }
+    uint32_t get_other_packet_sequence() const { return _other_packet_sequence.load(std::memory_order_acquire); }
     static uint8_t calculate_crc(uint8_t crc, uint8_t value);
-    uint8_t calculate_crc() const;
-    uint8_t get_received_crc() const;
+    static uint8_t calculate_crc(const packet_u& packet);
+    static uint8_t get_received_crc(const packet_u& packet) { return packet.value.payload[packet.value.length - 2]; }
+    static uint8_t calculate_command_crc(const packet_u& packet);
+    static uint8_t get_received_command_crc(const packet_u& packet) { return packet.value.payload[packet.value.length - 3]; }
+    uint8_t calculate_crc() const { return calculate_crc(get_packet()); }
+    uint8_t get_received_crc() const { return get_received_crc(get_packet()); }
 // for debug
-    uint8_t get_packet_sync() const { return _packet.value.sync; }
-    uint8_t get_packet_length() const { return _packet.value.length; }
-    uint8_t get_packet_type() const { return _packet.value.type; }
+    uint8_t get_packet_sync() const { return get_packet().value.sync; }
+    uint8_t get_packet_length() const { return get_packet().value.length; }
+    uint8_t get_packet_type() const { return get_packet().value.type; }
+    //! Number of times the parser has rescanned buffered bytes for a sync byte, after a bad length or CRC.
+    int32_t get_resync_count() const { return static_cast<int32_t>(_stats.resync_count); }
+protected:
+    friend class ReceiverSerial; // calls unpack_packet_slot() directly
+    bool unpack_packet_slot(size_t packet_index);
+    size_t other_packet_write_index() const { return _other_packet_sequence.load(std::memory_order_relaxed) & 1U; }
+    inline void publish_other_packet_from_isr() {
+        ++_stats.valid_frame_count;
+        _other_packet_published_last = true;
+        _other_packet_sequence.store(_other_packet_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    bool unpack_subset_rc_channels(const packet_u& packet);
+    void handle_command(const packet_u& packet);
+    void set_baudrate(uint32_t baudrate);
+    static uint32_t time_needed_per_frame_us(uint32_t baudrate);
+    //! the most recently published packet, of either kind
+    const packet_u& get_packet() const {
+        return _other_packet_published_last ? _other_packets[packet_read_index(get_other_packet_sequence())] : _packets[packet_read_index(get_packet_sequence())];
+    }
 private:
     enum { MAX_PAYLOAD_SIZE = MAX_PACKET_SIZE - 6 };
+    enum { CHANNEL_DATA_SIZE = 22 };
     uint32_t _packet_size {};
     uint32_t _packet_type {};
-    packet_u _packet_isr {};
-    packet_u _packet {};
+    uint8_t _crc {}; //!< running CRC of the packet being received
+    uint32_t _subset_channels {}; //!< bitmask of channels last set by a subset RC channels packet, these are stored as PWM values
+    uint32_t _time_needed_per_frame_us {TIME_NEEDED_PER_FRAME_US}; //!< read by on_data_received(), written by the task when the baudrate changes
+    uint32_t _baudrate_original {}; //!< baudrate of the serial port before speed negotiation, restored if speed negotiation fails
+    uint32_t _baudrate_proposed {};
+    time_us32_t _baudrate_switch_time_us {};
+    uint32_t _baudrate_switch_packet_sequence {};
+    int32_t _baudrate_fallback_count {};
+    speed_negotiation_state_e _speed_negotiation_state {SPEED_NEGOTIATION_IDLE};
+    /*!
+    Frames that carry channel data are published in _packets, so a newer channels frame supersedes an older one.
+    All other frames (eg link statistics and commands) are published in _other_packets, with their own sequence number,
+    so they never supersede a channels frame that the task has not yet unpacked.
+    The parser chooses the buffer once it has received the type byte.
+    */
+    std::array<packet_u, PACKET_BUFFER_COUNT> _packets {};
+    std::array<packet_u, PACKET_BUFFER_COUNT> _other_packets {};
+    std::atomic<uint32_t> _other_packet_sequence {0}; //!< number of other packets published by the ISR, written by ISR only
+    uint32_t _other_packet_sequence_read {0}; //!< sequence number of the last other packet read by the task
+    bool _packet_is_channels {true}; //!< true if the packet being received is a channels frame, or its type is not yet known
+    bool _other_packet_published_last {false}; //!< for the debug accessors
+#if defined(LIBRARY_RECEIVER_USE_LAZY_CHANNEL_DECODING)
+    mutable std::array<uint16_t, CHANNEL_COUNT> _channels {}; //!< decoded on demand by get_channel_pwm()
+    std::array<uint8_t, CHANNEL_DATA_SIZE> _channel_data {}; //!< channel data of the most recently unpacked RC channels packet
+#else
     std::array<uint16_t, CHANNEL_COUNT> _channels {};
+#endif
 };
@@ -1,10 +1,14 @@
 #include "receiver_ibus.h"
 
+#include <algorithm>
+#include <cstring>
+
 
 ReceiverIbus::ReceiverIbus(SerialPort& serialPort) :
     ReceiverSerial(serialPort)
 {
     _auxiliary_channel_count = CHANNEL_COUNT - STICK_COUNT;
+    set_data_ready_threshold(PACKET_SIZE);
 }
 
 uint16_t ReceiverIbus::get_channel_pwm(size_t index) const
@@ -12,98 +16,140 @@ uint16_t ReceiverIbus::get_channel_pwm(size_t index) const
     if (index >= CHANNEL_COUNT) {
         return CHANNEL_LOW;
     }
+#if defined(LIBRARY_RECEIVER_USE_LAZY_CHANNEL_DECODING)
+    if (!is_channel_decoded(index)) {
+        _channels[index] = decode_channel(_packet, index);
+        set_channel_decoded(index);
+    }
+#endif
     return _channels[index];
 }
 
 /*!
-Called from within ReceiverSerial ISR.
+Decode channel `index` from `packet`.
+
+Each of the 14 slots holds a channel in its lower 12 bits.
+Later IBUS receivers increase channel count by using the previously unused upper 4 bits of each slot,
+so channels 14 to 17 are each made up of the upper 4 bits of 3 consecutive slots.
+*/
+uint16_t ReceiverIbus::decode_channel(const packet_t& packet, size_t index) const
+{
+    if (index < SLOT_COUNT) {
+        const size_t offset = _channel_offset + 2*index;
+        return static_cast<uint16_t>(packet[offset] + ((packet[offset + 1] & 0x0F) << 8U));
+    }
+    const size_t offset = _channel_offset + 1 + 6*(index - SLOT_COUNT); // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    return static_cast<uint16_t>(((packet[offset] & 0xF0) >> 4) | (packet[offset + 2] & 0xF0) | ((packet[offset + 4] & 0xF0) << 4));
+}
+
+/*!
+Parse `len` bytes of data received at time `timestamp`.
+
+Called from within the SerialPort ISR, or from the ReceiverTask when using time-based scheduling.
+
+Once the sync byte is found the rest of the packet is copied in bulk.
+The checksum is calculated as the packet is received, and packets with a bad checksum are counted as errors and not published.
+
+Returns the number of complete valid packets received.
 */
-bool ReceiverIbus::on_data_received_from_isr(uint8_t data)
+size_t ReceiverIbus::on_data_received(const uint8_t* data, size_t len, time_us32_t timestamp) // NOLINT(readability-function-cognitive-complexity)
 {
-    const time_us32_t time_now_us = time_us();
-    enum { TIME_ALLOWANCE = 500 };
-    if (time_now_us > _start_time + TIME_NEEDED_PER_FRAME_US) { // cppcheck-suppress unsignedLessThanZero
+    begin_stats_update();
+    _stats.byte_count += static_cast<uint32_t>(len);
+    if (timestamp > _start_time + TIME_NEEDED_PER_FRAME_US && _packet_index != 0) { // cppcheck-suppress unsignedLessThanZero
+        // the gap cut short the packet being received, an idle gap between packets is not a drop
         _packet_index = 0;
         ++_dropped_packet_count;
+        ++_stats.framing_error_count;
     }
 
     enum { IA6_SYNC_BYTE = 0x55 };
-    if (_packet_index == 0) {
-        if ((data == SERIAL_RX_PACKET_LENGTH) || (data == TELEMETRY_PACKET_LENGTH)) {
-            _model = MODEL_IA6B;
-            _sync_byte = data;
-            _frame_size = data;
-            _channel_offset = 2;
-        } else if ((_sync_byte == 0) && (data == IA6_SYNC_BYTE)) {
-            _model = MODEL_IA6;
-            _sync_byte = IA6_SYNC_BYTE;
-            enum { IA6_FRAME_SIZE = 31 };
-            _frame_size = IA6_FRAME_SIZE;
-            _channel_offset = 1;
-        } else if (_sync_byte != data) {
-            return false;
+    size_t packet_count = 0;
+    size_t ii = 0;
+    while (ii < len) {
+        if (_packet_index == 0) {
+            const uint8_t sync = data[ii]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            if ((sync == SERIAL_RX_PACKET_LENGTH) || (sync == TELEMETRY_PACKET_LENGTH)) {
+                _model = MODEL_IA6B;
+                _sync_byte = sync;
+                _frame_size = sync;
+                _channel_offset = 2;
+            } else if ((_sync_byte == 0) && (sync == IA6_SYNC_BYTE)) {
+                _model = MODEL_IA6;
+                _sync_byte = IA6_SYNC_BYTE;
+                enum { IA6_FRAME_SIZE = 31 };
+                _frame_size = IA6_FRAME_SIZE;
+                _channel_offset = 1;
+            } else if (_sync_byte != sync) {
+                skip_byte_searching_for_start();
+                ++ii;
+                continue;
+            }
+            _searching_for_start = false;
+            _start_time = timestamp;
+            _checksum = (_model == MODEL_IA6) ? 0x0000 : 0xFFFF; // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
         }
-        _start_time = time_now_us;
-    }
-
-    _packet_isr[_packet_index] = data;
-    ++_packet_index;
+        packet_t& packet = _packets[packet_write_index()];
+        const size_t count = std::min(PACKET_SIZE - _packet_index, len - ii);
+        memcpy(&packet[_packet_index], &data[ii], count); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        // add the channel data, as little endian 16-bit words, to the checksum
+        const size_t checksum_end = std::min(_packet_index + count, static_cast<size_t>(_channel_offset + 2*SLOT_COUNT));
+        for (size_t index = std::max(_packet_index, static_cast<size_t>(_channel_offset)); index < checksum_end; ++index) {
+            const uint16_t value = ((index - _channel_offset) & 1U) ? static_cast<uint16_t>(packet[index] << 8U) : packet[index];
+            _checksum = static_cast<uint16_t>(_checksum + value);
+        }
+        _packet_index += count;
+        ii += count;
 
-    if (_packet_index == PACKET_SIZE) {
-        _packet_index = 0;
-        _packet = _packet_isr;
-        return true;
+        if (_packet_index == PACKET_SIZE) {
+            _packet_index = 0;
+            if (_checksum != get_received_checksum(packet)) {
+                ++_error_packet_count;
+                ++_stats.crc_error_count;
+                continue;
+            }
+            publish_packet_from_isr(timestamp);
+            ++packet_count;
+        }
     }
-    return false;
+    end_stats_update();
+    return packet_count;
 }
 
-uint16_t ReceiverIbus::calculate_checksum() const
+uint16_t ReceiverIbus::calculate_checksum(const packet_t& packet) const
 {
     uint16_t checksum = (_model == MODEL_IA6) ? 0x0000 : 0xFFFF; // NOLINT(misc-const-correctness,cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
     size_t offset = _channel_offset;
     for (size_t ii = 0; ii < SLOT_COUNT; ++ii) {
-        checksum += _packet[offset];
-        checksum += static_cast<uint16_t>(_packet[offset + 1] << 8U);
+        checksum += packet[offset];
+        checksum += static_cast<uint16_t>(packet[offset + 1] << 8U);
         offset += 2;
     }
     return checksum;
 }
 
 /*!
-If the packet is valid then unpack it into the member data and set the packet to empty.
+Unpack the packet in slot `packet_index` into the member data, the checksum has already been checked by on_data_received().
 
-Returns true if a valid packet received, false otherwise.
+Returns true.
 */
-bool ReceiverIbus::unpack_packet()
+bool ReceiverIbus::unpack_packet_slot(size_t packet_index)
 {
-    if (calculate_checksum() != get_received_checksum()) {
-        _packet_is_empty = true;
-        return false;
-    }
+    const packet_t& packet = _packets[packet_index];
 
-    size_t offset = _channel_offset;
-    for (size_t ii = 0; ii < SLOT_COUNT; ++ii) {
-        _channels[ii] = _packet[offset] + ((_packet[offset + 1] & 0x0F) << 8U);
-        offset += 2;
+#if defined(LIBRARY_RECEIVER_USE_LAZY_CHANNEL_DECODING)
+    // only decode the sticks, the other channels are decoded on demand by get_channel_pwm()
+    static constexpr size_t EAGER_CHANNEL_COUNT = STICK_COUNT;
+    _packet = packet;
+    _decoded_channels = STICK_CHANNELS_MASK;
+#else
+    static constexpr size_t EAGER_CHANNEL_COUNT = CHANNEL_COUNT;
+#endif
+    for (size_t ii = 0; ii < EAGER_CHANNEL_COUNT; ++ii) {
+        _channels[ii] = decode_channel(packet, ii);
     }
 
-    // later IBUS receivers increase channel count by using previously unused 4 bits of each channel
-    offset = _channel_offset + 1;
-    for (size_t ii = SLOT_COUNT; ii < CHANNEL_COUNT; ++ii) {
-        _channels[ii] = ((_packet[offset] & 0xF0) >> 4) | (_packet[offset + 2] & 0xF0) | ((_packet[offset + 4] & 0xF0) << 4);
-        offset += 6; // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
-    }
-
-    _controls.throttle = (static_cast<float>(_channels[THROTTLE]) - CHANNEL_RANGE_F) / CHANNEL_RANGE_F;
-    _controls.roll = (static_cast<float>(_channels[ROLL]) - CHANNEL_MIDDLE_F) / CHANNEL_RANGE_F;
-    _controls.pitch = (static_cast<float>(_channels[PITCH]) - CHANNEL_MIDDLE_F) / CHANNEL_RANGE_F;
-    _controls.yaw = (static_cast<float>(_channels[YAW]) - CHANNEL_MIDDLE_F) / CHANNEL_RANGE_F;
-
-    _controls_pwm.throttle = _channels[THROTTLE];
-    _controls_pwm.roll = _channels[ROLL];
-    _controls_pwm.pitch = _channels[PITCH];
-    _controls_pwm.yaw = _channels[YAW];
+    set_controls(_channels[THROTTLE], _channels[ROLL], _channels[PITCH], _channels[YAW]);
 
-    _packet_is_empty = false;
     return true;
 }
@@ -5,6 +5,8 @@
 
 /*!
 IBUS receiver protocol, used by Flysky receivers.
+
+Telemetry is sent to the receiver on its separate sensor bus, using IbusSensorResponder.
 */
 class ReceiverIbus : public ReceiverSerial {
 public:
@@ -31,24 +33,38 @@ private:
     ReceiverIbus(ReceiverIbus&&) = delete;
     ReceiverIbus& operator=(ReceiverIbus&&) = delete;
 public:
-    virtual bool on_data_received_from_isr(uint8_t data) override;
+    virtual size_t on_data_received(const uint8_t* data, size_t len, time_us32_t timestamp) override;
     virtual uint16_t get_channel_pwm(size_t index) const override;
-    virtual bool unpack_packet() override;
-    uint16_t calculate_checksum() const;
-    uint16_t get_received_checksum() const { return _packet[_frame_size - 2] + static_cast<uint16_t>(_packet[_frame_size - 1] << 8U); }
+    virtual bool update(uint32_t tick_count_delta) override { return update_packet<ReceiverIbus>(tick_count_delta); }
+    virtual bool unpack_packet() override { return unpack_newest_packet<ReceiverIbus>(); }
+    uint16_t calculate_checksum() const { return calculate_checksum(_packets[packet_read_index(get_packet_sequence())]); }
+    uint16_t get_received_checksum() const { return get_received_checksum(_packets[packet_read_index(get_packet_sequence())]); }
 // for testing;
     uint8_t getModel() const { return _model; }
     uint8_t get_sync_byte() const { return _sync_byte; }
     uint8_t get_frame_size() const { return _frame_size; }
     uint8_t get_channel_offset() const { return _channel_offset; }
-    uint8_t get_packet(size_t index) const { return _packet[index]; }
+    uint8_t get_packet(size_t index) const { return _packets[packet_read_index(get_packet_sequence())][index]; }
+protected:
+    friend class ReceiverSerial; // calls unpack_packet_slot() directly
+    bool unpack_packet_slot(size_t packet_index);
 private:
     enum { PACKET_SIZE = 32 };
-    std::array<uint8_t, PACKET_SIZE> _packet_isr {};
-    std::array<uint8_t, PACKET_SIZE> _packet {};
+    typedef std::array<uint8_t, PACKET_SIZE> packet_t;
+    uint16_t calculate_checksum(const packet_t& packet) const;
+    uint16_t get_received_checksum(const packet_t& packet) const { return packet[_frame_size - 2] + static_cast<uint16_t>(packet[_frame_size - 1] << 8U); }
+    uint16_t decode_channel(const packet_t& packet, size_t index) const;
+private:
+    std::array<packet_t, PACKET_BUFFER_COUNT> _packets {};
+#if defined(LIBRARY_RECEIVER_USE_LAZY_CHANNEL_DECODING)
+    mutable std::array<uint16_t, CHANNEL_COUNT> _channels {}; //!< decoded on demand by get_channel_pwm()
+    packet_t _packet {}; //!< copy of the most recently unpacked packet
+#else
     std::array<uint16_t, CHANNEL_COUNT> _channels {};
+#endif
     uint8_t _model {};
     uint8_t _sync_byte {};
     uint8_t _frame_size {};
     uint8_t _channel_offset {};
+    uint16_t _checksum {}; //!< running checksum of the packet being received
 };
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "receiver_serial.h"
+#include "receiver_task.h"
+
+#include <array>
+#include <type_traits>
+
+/*!
+Compile-time receiver pipeline, for builds where the RX protocol and the cockpit are known at compile time.
+
+The runtime pipeline makes several virtual calls on the byte->frame->controls path: SerialPort calls the virtual
+ReceiverSerialPortWatcher, which calls the virtual ReceiverBase::on_data_received_from_isr, which calls the virtual
+on_data_received. Then ReceiverTask::loop() calls the virtual update() and the virtual CockpitBase::update_controls().
+Within update() the calls are already direct: each protocol implements update() with ReceiverSerial::update_packet<Protocol>(),
+which calls Protocol::unpack_packet_slot() directly.
+
+ReceiverSerialT<Protocol> and ReceiverTaskT<Receiver, Cockpit> make these calls with the concrete types, as qualified calls,
+so they are direct calls that the compiler can inline, eg:
+
+    static SerialPort serial_port(pins, SerialPort::UART_INDEX_0, ReceiverCrsf::BAUD_RATE, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverSerialT<ReceiverCrsf> receiver(serial_port);
+    static Cockpit cockpit;
+    static ReceiverTaskT<ReceiverSerialT<ReceiverCrsf>, Cockpit> receiver_task(0, receiver, cockpit, context);
+    static ReceiverTaskStorage<4096> receiver_task_storage;
+    receiver_task_storage.start_task(task_info, receiver_task, receiver_task.task_static, priority, core, 0);
+
+ReceiverSerialT<Protocol> is still a ReceiverBase, so it may be used anywhere the runtime pipeline is used.
+The virtual interface remains for runtime selected setups, eg using ReceiverAutoDetect.
+*/
+
+
+/*!
+RX protocol receiver, eg ReceiverCrsf, whose serial port watcher calls the protocol parser directly.
+
+The serial port watcher calls Protocol::on_data_received() directly, rather than through ReceiverBase, so the only
+indirect call left on the ISR path is the call from SerialPort to the watcher, which is made once per block of received data.
+*/
+template <typename Protocol>
+class ReceiverSerialT final : public Protocol {
+public:
+    static_assert(std::is_base_of_v<ReceiverSerial, Protocol>, "Protocol must be a ReceiverSerial");
+    class SerialPortWatcher final : public SerialPortWatcherBase {
+    public:
+        explicit SerialPortWatcher(ReceiverSerialT& receiver) : _receiver(receiver) {}
+        bool on_data_received_from_isr(uint8_t data) override { return _receiver.parse(&data, 1, time_us()) != 0; }
+        size_t on_data_received_from_isr(const uint8_t* data, size_t len, time_us32_t timestamp) override { return _receiver.parse(data, len, timestamp); }
+    private:
+        ReceiverSerialT& _receiver;
+    };
+public:
+    explicit ReceiverSerialT(SerialPort& serial_port) : Protocol(serial_port), _serial_port_watcher(*this) {
+        serial_port.set_watcher(&_serial_port_watcher);
+    }
+    //! Make this receiver the one that the serial port gives received data to, hides ReceiverSerial::attach_serial_port_watcher().
+    void attach_serial_port_watcher() {
+        this->_serial_port.set_watcher(&_serial_port_watcher);
+        this->_serial_port.set_data_ready_threshold(this->_data_ready_threshold);
+    }
+    //! Parse `len` bytes, as on_data_received() but without the virtual call.
+    inline size_t parse(const uint8_t* data, size_t len, time_us32_t timestamp) { return Protocol::on_data_received(data, len, timestamp); }
+    //! Read received bytes from the serial port, as read() but without the virtual call.
+    inline size_t read_direct(uint8_t* buf, size_t max_len) { return this->_serial_port.read(buf, max_len); }
+    bool on_data_received_from_isr(uint8_t data) override { return parse(&data, 1, time_us()) != 0; }
+    size_t read(uint8_t* buf, size_t max_len) override { return read_direct(buf, max_len); }
+private:
+    SerialPortWatcher _serial_port_watcher;
+};
+
+
+/*!
+ReceiverTask for a Receiver and Cockpit known at compile time.
+
+Receiver is a ReceiverBase, typically a ReceiverSerialT<Protocol>, and Cockpit a concrete (ie not abstract) CockpitBase.
+Its receiver and cockpit functions are called with qualified names, so are direct calls that may be inlined.
+
+Started using ReceiverTaskStorage::start_task() with task_static() as the task function.
+*/
+template <typename Receiver, typename Cockpit>
+class ReceiverTaskT : public TaskBase {
+public:
+    static_assert(std::is_base_of_v<ReceiverBase, Receiver>, "Receiver must be a ReceiverBase");
+    static_assert(!std::is_abstract_v<Cockpit>, "Cockpit must be a concrete cockpit");
+    ReceiverTaskT(uint32_t task_interval_microseconds, Receiver& receiver, Cockpit& cockpit, receiver_context_t& context) :
+        TaskBase(task_interval_microseconds),
+        _receiver(receiver),
+        _cockpit(cockpit),
+        _context(context)
+    {}
+public:
+    [[noreturn]] static void task_static(void* arg) {
+        const TaskBase::parameters_t* parameters = static_cast<TaskBase::parameters_t*>(arg);
+        static_cast<ReceiverTaskT*>(parameters->task)->task(); // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+    }
+    //! As ReceiverTask::loop().
+    inline void loop() {
+#if defined(FRAMEWORK_USE_FREERTOS)
+        const TickType_t tick_count = xTaskGetTickCount();
+#else
+        const uint32_t tick_count = time_ms();
+#endif
+        _tick_count_delta = tick_count - _tick_count_previous;
+        _tick_count_previous = tick_count;
+#if defined(LIBRARY_RECEIVER_USE_LATENCY_HISTOGRAMS)
+        const time_us32_t task_time = time_us();
+#endif
+        if (_receiver.Receiver::update(_tick_count_delta)) {
+            const time_us32_t controls_time = time_us();
+#if defined(LIBRARY_RECEIVER_USE_LATENCY_HISTOGRAMS)
+            _receiver.record_latencies(task_time, controls_time);
+#endif
+            _cockpit.Cockpit::update_controls(tick_count, _receiver.get_frame_age_us(controls_time), _receiver, _context);
+        } else {
+            _cockpit.Cockpit::check_failsafe(tick_count, _context);
+        }
+    }
+    //! As ReceiverTask::drain_receiver(), the latest frame wins.
+    inline size_t drain_receiver() {
+        size_t packet_count = 0;
+        size_t len = 0;
+        while ((len = _receiver.Receiver::read(&_read_buffer[0], _read_buffer.size())) > 0) {
+            packet_count += _receiver.Receiver::on_data_received(&_read_buffer[0], len, _receiver.Receiver::get_receive_time_us());
+        }
+        return packet_count;
+    }
+private:
+    //! As ReceiverTask::task().
+    [[noreturn]] void task() {
+#if defined(FRAMEWORK_USE_FREERTOS)
+        if (_task_interval_microseconds == 0) {
+            // event driven scheduling
+            const uint32_t ticksToWait = _cockpit.get_timeout_ticks();
+            while (true) {
+#if defined(LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER)
+                // drain even if the WAIT timed out, since the ISR does not signal for less than a frame's worth of data
+                _receiver.Receiver::WAIT_FOR_DATA_RECEIVED(ticksToWait);
+                drain_receiver();
+#else
+                _receiver.Receiver::WAIT_FOR_DATA_RECEIVED(ticksToWait);
+#endif
+                loop();
+            }
+        } else {
+            // time based scheduling
+            const uint32_t task_interval_ticks = _task_interval_microseconds < 1000 ? 1 : pdMS_TO_TICKS(_task_interval_microseconds / 1000);
+            _previous_wake_time_ticks = xTaskGetTickCount();
+            while (true) {
+#if (tskKERNEL_VERSION_MAJOR > 10) || ((tskKERNEL_VERSION_MAJOR == 10) && (tskKERNEL_VERSION_MINOR >= 5))
+                const BaseType_t was_delayed = xTaskDelayUntil(&_previous_wake_time_ticks, task_interval_ticks);
+                if (was_delayed) {
+                    _was_delayed = true;
+                }
+#else
+                vTaskDelayUntil(&_previous_wake_time_ticks, task_interval_ticks);
+#endif
+                drain_receiver();
+                loop();
+            }
+        }
+#elif defined(FRAMEWORK_LINUX)
+        const uint32_t ticksToWait = _cockpit.get_timeout_ticks();
+        while (true) {
+            if (_receiver.Receiver::WAIT_FOR_DATA_RECEIVED(ticksToWait) > 0) {
+                drain_receiver();
+            }
+            loop();
+        }
+#else
+        while (true) {}
+#endif // FRAMEWORK_USE_FREERTOS
+    }
+private:
+    enum { READ_BUFFER_SIZE = 64 };
+    Receiver& _receiver;
+    Cockpit& _cockpit;
+    receiver_context_t& _context;
+    std::array<uint8_t, READ_BUFFER_SIZE> _read_buffer {};
+};
@@ -1,10 +1,110 @@
 #include "receiver_sbus.h"
+#include "unpack_11bit_channels.h"
+
+#include <algorithm>
+#include <cstring>
 
 
 ReceiverSbus::ReceiverSbus(SerialPort& serialPort) :
-    ReceiverSerial(serialPort)
+    ReceiverSerial(serialPort),
+    _fast(serialPort.get_baudrate() == FAST_BAUDRATE)
 {
     _auxiliary_channel_count = CHANNEL_COUNT - STICK_COUNT;
+    _time_needed_per_frame_us = _fast ? TIME_NEEDED_PER_FRAME_US / 2 : TIME_NEEDED_PER_FRAME_US;
+    set_data_ready_threshold(PACKET_SIZE);
+}
+
+/*!
+Set the serial port to BAUD_RATE or FAST_BAUDRATE, and scale the time allowed to receive a frame to match.
+*/
+void ReceiverSbus::set_fast(bool fast)
+{
+    _fast = fast;
+    _serial_port.set_baudrate(fast ? FAST_BAUDRATE : BAUD_RATE);
+    _time_needed_per_frame_us = fast ? TIME_NEEDED_PER_FRAME_US / 2 : TIME_NEEDED_PER_FRAME_US;
+}
+
+/*!
+Take normal or fast SBUS from the serial port baudrate, eg as set by ReceiverAutoDetect.
+The baudrate is known, so any baudrate probing is stopped.
+*/
+void ReceiverSbus::on_serial_config_changed()
+{
+    _fast = _serial_port.get_baudrate() == FAST_BAUDRATE;
+    _time_needed_per_frame_us = _fast ? TIME_NEEDED_PER_FRAME_US / 2 : TIME_NEEDED_PER_FRAME_US;
+    _probe_state = PROBE_IDLE;
+}
+
+/*!
+Set normal (100 kbaud) or fast (200 kbaud) SBUS, or automatic detection of which of these the receiver uses.
+
+With BAUDRATE_MODE_AUTO the current baudrate is probed first, see update_baudrate().
+*/
+void ReceiverSbus::set_baudrate_mode(baudrate_mode_e baudrate_mode)
+{
+    switch (baudrate_mode) {
+    case BAUDRATE_MODE_NORMAL:
+        set_fast(false);
+        _probe_state = PROBE_IDLE;
+        break;
+    case BAUDRATE_MODE_FAST:
+        set_fast(true);
+        _probe_state = PROBE_IDLE;
+        break;
+    default:
+        _probe_state = PROBE_START;
+        break;
+    }
+}
+
+/*!
+Advance baudrate detection.
+
+Data received at the wrong baudrate is garbage, which only rarely has a start byte and an end byte in the right places.
+So the baudrate is taken to be correct if, within a probe window of PROBE_WINDOW_US, at least PROBE_VALID_PACKET_COUNT packets
+pass the start and end byte checks and there are more valid packets than bad ones.
+Otherwise the other baudrate is tried for the next probe window.
+
+Called by update(), with the current time.
+*/
+void ReceiverSbus::update_baudrate(time_us32_t time)
+{
+    switch (_probe_state) {
+    case PROBE_START:
+        _probe_start_time = time;
+        _probe_packet_sequence = get_packet_sequence();
+        _probe_error_packet_count = _error_packet_count;
+        _probe_state = PROBE_PROBING;
+        break;
+    case PROBE_PROBING: {
+        const uint32_t valid_count = get_packet_sequence() - _probe_packet_sequence;
+        const auto error_count = static_cast<uint32_t>(_error_packet_count - _probe_error_packet_count);
+        if (valid_count >= PROBE_VALID_PACKET_COUNT && valid_count > error_count) {
+            _probe_state = PROBE_IDLE;
+        } else if (time - _probe_start_time > PROBE_WINDOW_US) {
+            set_fast(!_fast);
+            _probe_start_time = time;
+            _probe_packet_sequence = get_packet_sequence();
+            _probe_error_packet_count = _error_packet_count;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+/*!
+Advance any baudrate detection, and then unpack any received packet.
+
+Returns true if a packet was received.
+*/
+bool ReceiverSbus::update(uint32_t tick_count_delta)
+{
+    if (_probe_state != PROBE_IDLE) {
+        update_baudrate(time_us());
+    }
+    return update_packet<ReceiverSbus>(tick_count_delta);
 }
 
 uint16_t ReceiverSbus::get_channel_pwm(size_t index) const
@@ -12,47 +112,87 @@ uint16_t ReceiverSbus::get_channel_pwm(size_t index) const
     if (index >= CHANNEL_COUNT) {
         return CHANNEL_LOW;
     }
+#if defined(LIBRARY_RECEIVER_USE_LAZY_CHANNEL_DECODING)
+    if (!is_channel_decoded(index)) {
+        _channels[index] = map_to_pwm(unpack_11bit_channel(&_channel_data[0], index));
+        set_channel_decoded(index);
+    }
+#endif
     return _channels[index];
 }
 
 /*!
-Called from within ReceiverSerial ISR.
+Parse `len` bytes of data received at time `timestamp`.
+
+Called from within the SerialPort ISR, or from the ReceiverTask when using time-based scheduling.
+
+Once the start byte is found the rest of the packet is copied in bulk.
+Packets with a bad end byte are counted as errors and not published.
+
+Returns the number of complete valid packets received.
 */
-bool ReceiverSbus::on_data_received_from_isr(uint8_t data)
+size_t ReceiverSbus::on_data_received(const uint8_t* data, size_t len, time_us32_t timestamp) // NOLINT(readability-function-cognitive-complexity)
 {
-    const time_us32_t time_now_us = time_us();
     enum { TIME_ALLOWANCE = 500 };
-    if (time_now_us > _start_time + TIME_NEEDED_PER_FRAME_US + TIME_ALLOWANCE) { // cppcheck-suppress unsignedLessThanZero
+    begin_stats_update();
+    _stats.byte_count += static_cast<uint32_t>(len);
+    if (timestamp > _start_time + _time_needed_per_frame_us + TIME_ALLOWANCE && _packet_index != 0) { // cppcheck-suppress unsignedLessThanZero
+        // the gap cut short the packet being received, an idle gap between packets is not a drop
         _packet_index = 0;
         ++_dropped_packet_count;
+        ++_stats.framing_error_count;
     }
 
-    if (_packet_index == 0) {
-        if (data != SBUS_START_BYTE) {
-            _packet_is_empty = true;
-            return false;
+    size_t packet_count = 0;
+    size_t ii = 0;
+    while (ii < len) {
+        if (_packet_index == 0) {
+            // search for the start byte
+            if (data[ii] != SBUS_START_BYTE) { // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                skip_byte_searching_for_start();
+                ++ii;
+                continue;
+            }
+            _searching_for_start = false;
+            _start_time = timestamp;
+        }
+        auto& packet = _packets[packet_write_index()];
+        const size_t count = std::min(PACKET_SIZE - _packet_index, len - ii);
+        memcpy(&packet[_packet_index], &data[ii], count); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        _packet_index += count;
+        ii += count;
+
+        if (_packet_index == PACKET_SIZE) {
+            _packet_index = 0;
+            if (packet[PACKET_SIZE - 1] != SBUS_END_BYTE) {
+                ++_error_packet_count;
+                ++_stats.framing_error_count;
+                continue;
+            }
+            publish_packet_from_isr(timestamp);
+            ++packet_count;
         }
-        _start_time = time_now_us;
     }
+    end_stats_update();
+    return packet_count;
+}
 
-    _packet_isr[_packet_index] = data;
-    ++_packet_index;
-
-    if (_packet_index == PACKET_SIZE) {
-        _packet_index = 0;
-        if (_packet_isr[PACKET_SIZE - 1] != SBUS_END_BYTE) {
-            ++_error_packet_count;
-            _packet_is_empty = true;
+// the integer mapping must give exactly the same result as the float calculation it replaces
+namespace {
+constexpr bool map_to_pwm_matches_float()
+{
+    for (uint16_t raw = 0; raw < 2048; ++raw) { // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+        if (ReceiverSbus::map_to_pwm(raw) != static_cast<uint16_t>(static_cast<uint16_t>(5.0F * static_cast<float>(raw) / 8.0F) + 880)) { // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
             return false;
         }
-        _packet = _packet_isr;
-        return true;
     }
-    return false;
+    return true;
 }
+} // anonymous namespace
+static_assert(map_to_pwm_matches_float());
 
 /*!
-If the packet is valid then unpack it into the member data and set the packet to empty.
+If the packet in slot `packet_index` is valid then unpack it into the member data.
 
 Returns true if a valid packet received, false otherwise.
 
@@ -66,64 +206,33 @@ SBUS uses range [192,1792] which is mapped to [1000,2000] ([CHANNEL_LOW,CHANNEL_
 
 Some transmitters/receivers use range [172,1811] which is  clipped.
 */
-bool ReceiverSbus::unpack_packet()
+bool ReceiverSbus::unpack_packet_slot(size_t packet_index)
 {
-    if (_packet[PACKET_SIZE - 1] != SBUS_END_BYTE) {
-        _packet_is_empty = true;
-        return false;
-    }
+    // the end byte has already been checked by on_data_received()
+    const auto& packet = _packets[packet_index];
     // SBUS uses AETR (Ailerons, Elevator, Throttle, Rudder), ie ROLL, PITCH, THROTTLE, YAW
     // This is the default, so no reordering required
-    _channels[0]  = _packet[1]     | _packet[2]<<8;
-    _channels[1]  = _packet[2]>>3  | _packet[3]<<5;
-    _channels[2]  = _packet[3]>>6  | _packet[4]<<2  | _packet[5]<<10;
-    _channels[3]  = _packet[5]>>1  | _packet[6]<<7;
-    _channels[4]  = _packet[6]>>4  | _packet[7]<<4;
-    _channels[5]  = _packet[7]>>7  | _packet[8]<<1  | _packet[9]<<9;
-    _channels[6]  = _packet[9]>>2  | _packet[10]<<6;
-    _channels[7]  = _packet[10]>>5 | _packet[11]<<3;
-    _channels[8]  = _packet[12]    | _packet[13]<<8;
-    _channels[9]  = _packet[13]>>3 | _packet[14]<<5;
-    _channels[10] = _packet[14]>>6 | _packet[15]<<2 | _packet[16]<<10;
-    _channels[11] = _packet[16]>>1 | _packet[17]<<7;
-    _channels[12] = _packet[17]>>4 | _packet[18]<<4;
-    _channels[13] = _packet[18]>>7 | _packet[19]<<1 | _packet[20]<<9;
-    _channels[14] = _packet[20]>>2 | _packet[21]<<6;
-    _channels[15] = _packet[21]>>5 | _packet[22]<<3;
-
+#if defined(LIBRARY_RECEIVER_USE_LAZY_CHANNEL_DECODING)
+    // only decode the sticks, the other channels are decoded on demand by get_channel_pwm()
+    static constexpr size_t EAGER_CHANNEL_COUNT = STICK_COUNT;
+    memcpy(&_channel_data[0], &packet[1], CHANNEL_DATA_SIZE);
+    _decoded_channels = STICK_CHANNELS_MASK | (1U << 16U) | (1U << 17U);
+#else
+    static constexpr size_t EAGER_CHANNEL_COUNT = CHANNEL_11_BIT_COUNT;
+#endif
+    unpack_11bit_channels<EAGER_CHANNEL_COUNT>(&_channels[0], &packet[1]);
 
     // map range [192,1792] to [1000,2000]
-#if true
-    for (size_t ii = 0; ii < CHANNEL_11_BIT_COUNT; ++ii) {
-        _channels[ii] &= 0x07FF;
-        _channels[ii] = static_cast<uint16_t>(5.0F * static_cast<float>(_channels[ii]) / 8.0F) + 880;
-    }
-#else
-    for (size_t ii = 0; ii < 16; ++ii) {
-        uint32_t channel =  _channels[ii];
-        channel <<= 16;
-        channel *=5;
-        channel >>= 19;
-        channel += 880;
-        _channels[ii] = static_cast<uint16_t>(channel);
+    for (size_t ii = 0; ii < EAGER_CHANNEL_COUNT; ++ii) {
+        _channels[ii] = map_to_pwm(_channels[ii]);
     }
-#endif
 
     enum { FLAG_CHANNEL_16 = 0x01, FLAG_CHANNEL_17 = 0x02, FLAG_LOST_FRAME = 0x04, FLAG_LOST_SIGNAL = 0x08 };
-    const uint8_t flags = _packet[23];
+    const uint8_t flags = packet[23];
     _channels[16] = (flags & FLAG_CHANNEL_16) ? CHANNEL_HIGH : CHANNEL_LOW;
     _channels[17] = (flags & FLAG_CHANNEL_17) ? CHANNEL_HIGH : CHANNEL_LOW;
 
-    _controls.throttle = (static_cast<float>(_channels[THROTTLE]) - CHANNEL_RANGE_F) / CHANNEL_RANGE_F;
-    _controls.roll = (static_cast<float>(_channels[ROLL]) - CHANNEL_MIDDLE_F) / CHANNEL_RANGE_F;
-    _controls.pitch = (static_cast<float>(_channels[PITCH]) - CHANNEL_MIDDLE_F) / CHANNEL_RANGE_F;
-    _controls.yaw = (static_cast<float>(_channels[YAW]) - CHANNEL_MIDDLE_F) / CHANNEL_RANGE_F;
-
-    _controls_pwm.throttle = _channels[THROTTLE];
-    _controls_pwm.roll = _channels[ROLL];
-    _controls_pwm.pitch = _channels[PITCH];
-    _controls_pwm.yaw = _channels[YAW];
+    set_controls(_channels[THROTTLE], _channels[ROLL], _channels[PITCH], _channels[YAW]);
 
-    _packet_is_empty = false;
     return true;
 }
@@ -19,7 +19,12 @@ public:
     static constexpr uint32_t CHANNEL_COUNT = 18;
     static constexpr uint8_t SBUS_START_BYTE = 0x0F;
     static constexpr uint8_t SBUS_END_BYTE = 0x00;
-    static constexpr uint32_t TIME_NEEDED_PER_FRAME_US = 3000;
+    static constexpr uint32_t TIME_NEEDED_PER_FRAME_US = 3000; //!< 25 bytes of 12 bits at BAUD_RATE, halved at FAST_BAUDRATE
+    //! with BAUDRATE_MODE_AUTO, the baudrate is switched if PROBE_VALID_PACKET_COUNT valid packets are not received within this time
+    static constexpr uint32_t PROBE_WINDOW_US = 100000;
+    static constexpr uint32_t PROBE_VALID_PACKET_COUNT = 3;
+    enum baudrate_mode_e { BAUDRATE_MODE_NORMAL, BAUDRATE_MODE_FAST, BAUDRATE_MODE_AUTO };
+    enum probe_state_e { PROBE_IDLE, PROBE_START, PROBE_PROBING };
 public:
     explicit ReceiverSbus(SerialPort& serialPort);
 private:
@@ -29,12 +34,37 @@ private:
     ReceiverSbus(ReceiverSbus&&) = delete;
     ReceiverSbus& operator=(ReceiverSbus&&) = delete;
 public:
-    virtual bool on_data_received_from_isr(uint8_t data) override;
+    virtual size_t on_data_received(const uint8_t* data, size_t len, time_us32_t timestamp) override;
     virtual uint16_t get_channel_pwm(size_t index) const override;
-    virtual bool unpack_packet() override;
+    virtual bool update(uint32_t tick_count_delta) override;
+    virtual bool unpack_packet() override { return unpack_newest_packet<ReceiverSbus>(); }
+    virtual void on_serial_config_changed() override;
+    void set_baudrate_mode(baudrate_mode_e baudrate_mode);
+    void update_baudrate(time_us32_t time);
+    bool is_fast() const { return _fast; }
+    //! Returns true once BAUDRATE_MODE_AUTO has found the baudrate, or if the baudrate was set explicitly.
+    bool is_baudrate_detected() const { return _probe_state == PROBE_IDLE; }
+    uint32_t get_time_needed_per_frame_us() const { return _time_needed_per_frame_us; }
+    //! Map raw SBUS channel value in range [192,1792] to PWM range [1000,2000], bit-exact with `static_cast<uint16_t>(5.0F * raw / 8.0F) + 880`
+    static constexpr uint16_t map_to_pwm(uint16_t raw) { return static_cast<uint16_t>(((5U * raw) >> 3U) + 880U); }
+protected:
+    friend class ReceiverSerial; // calls unpack_packet_slot() directly
+    bool unpack_packet_slot(size_t packet_index);
+    void set_fast(bool fast);
 private:
     enum { PACKET_SIZE = 25 };
-    std::array<uint8_t, PACKET_SIZE> _packet_isr {};
-    std::array<uint8_t, PACKET_SIZE> _packet {};
+    enum { CHANNEL_DATA_SIZE = 22 };
+    uint32_t _time_needed_per_frame_us {TIME_NEEDED_PER_FRAME_US}; //!< read by on_data_received(), written by the task when the baudrate changes
+    bool _fast {false};
+    probe_state_e _probe_state {PROBE_IDLE};
+    time_us32_t _probe_start_time {};
+    uint32_t _probe_packet_sequence {}; //!< packet sequence at the start of the probe window
+    int32_t _probe_error_packet_count {}; //!< error packet count at the start of the probe window
+    std::array<std::array<uint8_t, PACKET_SIZE>, PACKET_BUFFER_COUNT> _packets {};
+#if defined(LIBRARY_RECEIVER_USE_LAZY_CHANNEL_DECODING)
+    mutable std::array<uint16_t, CHANNEL_COUNT> _channels {}; //!< decoded on demand by get_channel_pwm()
+    std::array<uint8_t, CHANNEL_DATA_SIZE> _channel_data {}; //!< channel data of the most recently unpacked packet
+#else
     std::array<uint16_t, CHANNEL_COUNT> _channels {};
+#endif
 };
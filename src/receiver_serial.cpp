@@ -11,11 +11,17 @@ bool ReceiverSerialPortWatcher::on_data_received_from_isr(uint8_t data)
     return _receiver.on_data_received_from_isr(data);
 }
 
+size_t ReceiverSerialPortWatcher::on_data_received_from_isr(const uint8_t* data, size_t len, time_us32_t timestamp)
+{
+    return _receiver.on_data_received(data, len, timestamp);
+}
+
 
 ReceiverSerial::ReceiverSerial(SerialPort& serialPort) :
     _serial_port(serialPort),
     _serial_port_watcher(*this)
 {
+    _serial_port.set_watcher(&_serial_port_watcher);
 }
 
 void ReceiverSerial::init()
@@ -29,7 +35,17 @@ This waits for data from the serial UART
 */
 int32_t ReceiverSerial::WAIT_FOR_DATA_RECEIVED(uint32_t ticksToWait)
 {
-    return _serial_port.WAIT_DATA_READY(ticksToWait);
+    return _serial_port.WAIT_FOR_DATA_RECEIVED(ticksToWait);
+}
+
+/*!
+Parse a single byte, returns true if a packet is complete.
+
+Called from within the SerialPort ISR, or from the ReceiverTask when using time-based scheduling.
+*/
+bool ReceiverSerial::on_data_received_from_isr(uint8_t data)
+{
+    return on_data_received(&data, 1, time_us()) != 0;
 }
 
 bool ReceiverSerial::is_data_available() const
@@ -46,31 +62,9 @@ uint8_t ReceiverSerial::read_byte()
 }
 
 /*!
-If a packet was received then unpack it and return true.
-
-Returns false if an empty or invalid packet was received.
+Used to get all the bytes received since the last call when using time-based scheduling.
 */
-bool ReceiverSerial::update(uint32_t tick_count_delta)
+size_t ReceiverSerial::read(uint8_t* buf, size_t max_len)
 {
-    if (is_packet_empty()) {
-        return false;
-    }
-
-    if (!unpack_packet()) {
-        return false;
-    }
-
-    _packet_received = true;
-    ++_packet_count;
-
-    // record tickoutDelta for instrumentation
-    _tick_count_delta = tick_count_delta;
-
-    // track dropped packets
-    _dropped_packet_count_delta = _dropped_packet_count - _dropped_packet_count_previous;
-    _dropped_packet_count_previous = _dropped_packet_count;
-
-    // NOTE: there is no mutex around this flag
-    _new_packet_available = true;
-    return true;
+    return _serial_port.read(buf, max_len);
 }
@@ -3,12 +3,16 @@
 #include "serial_port.h"
 #include "receiver_base.h"
 
+#include <array>
+#include <atomic>
+
 
 class ReceiverSerialPortWatcher : public SerialPortWatcherBase {
 public:
     virtual ~ReceiverSerialPortWatcher() = default;
     explicit ReceiverSerialPortWatcher(ReceiverBase& receiver);
     bool on_data_received_from_isr(uint8_t data) override;
+    size_t on_data_received_from_isr(const uint8_t* data, size_t len, time_us32_t timestamp) override;
 private:
     ReceiverBase& _receiver;
 };
@@ -18,6 +22,16 @@ class ReceiverSerial : public ReceiverBase {
 public:
     explicit ReceiverSerial(SerialPort& serialPort);
     void init();
+    //! Make this receiver the one that the serial port gives received data to, eg after protocol auto-detection.
+    void attach_serial_port_watcher() {
+        _serial_port.set_watcher(&_serial_port_watcher);
+        _serial_port.set_data_ready_threshold(_data_ready_threshold);
+    }
+    /*!
+    Called when the serial port has been configured for this receiver by something else, eg by protocol auto-detection.
+    The receiver updates its settings that depend on the serial port baudrate.
+    */
+    virtual void on_serial_config_changed() {}
 private:
     // ReceiverSerial is not copyable or moveable
     ReceiverSerial(const ReceiverSerial&) = delete;
@@ -26,18 +40,144 @@ private:
     ReceiverSerial& operator=(ReceiverSerial&&) = delete;
 public:
     virtual int32_t WAIT_FOR_DATA_RECEIVED(uint32_t ticksToWait) override;
+    virtual bool on_data_received_from_isr(uint8_t data) override;
+    virtual size_t on_data_received(const uint8_t* data, size_t len, time_us32_t timestamp) override = 0;
     virtual bool is_data_available() const override;
     virtual uint8_t read_byte() override;
-    virtual bool update(uint32_t tick_count_delta) override;
-    bool is_packet_empty() const { return _packet_is_empty; }
-    void set_packet_empty() { _packet_is_empty = true; }
+    virtual size_t read(uint8_t* buf, size_t max_len) override;
+    virtual time_us32_t get_receive_time_us() const override { return _serial_port.get_receive_time_us(); }
+    bool is_packet_empty() const { return get_packet_sequence() == _packet_sequence_read; }
+    void set_packet_empty() { _packet_sequence_read = get_packet_sequence(); }
     size_t get_packet_index() const { return _packet_index; } // for testing
+    //! Number of complete packets rejected by on_data_received() because of a bad CRC, checksum, or end byte.
+    int32_t get_error_packet_count() const { return _error_packet_count; }
+    uint32_t get_packet_sequence() const { return _packet_sequence.load(std::memory_order_acquire); }
+protected:
+    /*!
+    Packets are double buffered: the ISR assembles a packet in place in the write slot and then publishes it by incrementing
+    the packet sequence number, which flips the write and read slots. So there is no packet copy in the ISR.
+    The arrival times of the packet's first byte (`_start_time`) and last byte, and the time it was published, are published with it.
+
+    The task reads the packet in place from the read slot and then checks the sequence number is unchanged (seqlock).
+    If the ISR has published another packet while the task was reading, the read may have been torn and the task must re-read.
+    */
+    static constexpr size_t PACKET_BUFFER_COUNT = 2;
+    static size_t packet_read_index(uint32_t sequence) { return (sequence & 1U) ^ 1U; }
+    size_t packet_write_index() const { return _packet_sequence.load(std::memory_order_relaxed) & 1U; }
+    inline void publish_packet_from_isr(time_us32_t last_byte_time) {
+        _frame_times[packet_write_index()] = { _start_time, last_byte_time, time_us() };
+        ++_stats.valid_frame_count;
+        _packet_sequence.store(_packet_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_release); // subsequent writes to the new write slot must not be seen before the sequence increment
+    }
+    //! Returns true if no packet was published while the packet with sequence number `sequence` was being read.
+    bool packet_sequence_unchanged(uint32_t sequence) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return _packet_sequence.load(std::memory_order_relaxed) == sequence;
+    }
+    virtual uint32_t get_overrun_count() const override { return _serial_port.get_rx_overrun_count(); }
+    //! Called by the protocol's constructor with its frame size, so that in ring buffer mode the task is woken once per frame.
+    void set_data_ready_threshold(size_t data_ready_threshold) {
+        _data_ready_threshold = data_ready_threshold;
+        _serial_port.set_data_ready_threshold(data_ready_threshold);
+    }
+    /*!
+    Called by the parser when a byte is skipped while searching for the start of a frame.
+    A run of skipped bytes means frame alignment was lost, and is counted as a single resync.
+    */
+    inline void skip_byte_searching_for_start() {
+        if (!_searching_for_start) {
+            _searching_for_start = true;
+            ++_stats.resync_count;
+        }
+    }
+    /*!
+    The implementation of update() for the protocol `Protocol`, eg ReceiverSbus, which derives from ReceiverSerial (CRTP).
+    If a packet was received then unpack it and return true.
+
+    Returns false if no new packet has been received since the last update, or if an invalid packet was received.
+    */
+    template <typename Protocol>
+    inline bool update_packet(uint32_t tick_count_delta) {
+        update_frames_per_second(time_us());
+        if (is_packet_empty()) {
+            return false;
+        }
+        if (!unpack_newest_packet<Protocol>()) {
+            return false;
+        }
+        _packet_received = true;
+        ++_packet_count;
+        // record tickoutDelta for instrumentation
+        _tick_count_delta = tick_count_delta;
+        // track dropped packets
+        _dropped_packet_count_delta = _dropped_packet_count - _dropped_packet_count_previous;
+        _dropped_packet_count_previous = _dropped_packet_count;
+        // NOTE: there is no mutex around this flag
+        _new_packet_available = true;
+        return true;
+    }
+    /*!
+    The implementation of unpack_packet() for the protocol `Protocol`: unpack the most recently published packet.
+
+    Protocol::unpack_packet_slot(packet_index) is called with a qualified name, so the path from update() to the unpacked
+    channels is made with direct calls, even when the receiver is used through a ReceiverBase.
+    Protocol must be a friend of ReceiverSerial, so that unpack_packet_slot() need not be public.
+
+    The packet is read in place, so if the ISR published another packet during the unpacking then the read may have been torn,
+    in which case the newer packet is unpacked instead.
+
+    Only the newest packet is unpacked: any packets published since the last unpack (eg when the task has drained a burst of
+    several frames from the receive buffer) are stale, so are skipped and counted as superseded.
+    Protocols publish only frames that carry channel data here, so a frame is only superseded by a newer channels frame
+    (see ReceiverCrsf, which publishes its other frames separately).
+
+    Returns false if there is no new packet, or if the packet is invalid.
+    */
+    template <typename Protocol>
+    inline bool unpack_newest_packet() {
+        uint32_t sequence = get_packet_sequence();
+        if (sequence == _packet_sequence_read) {
+            return false;
+        }
+        while (true) {
+            const size_t packet_index = packet_read_index(sequence);
+            const bool valid = static_cast<Protocol*>(this)->Protocol::unpack_packet_slot(packet_index); // NOLINT(cppcoreguidelines-pro-type-static-cast-downcast)
+            const receiver_frame_time_t frame_time = _frame_times[packet_index];
+            if (packet_sequence_unchanged(sequence)) {
+                _superseded_frame_count += sequence - _packet_sequence_read - 1;
+                _packet_sequence_read = sequence;
+                if (valid) {
+                    _frame_time = frame_time;
+                }
+                return valid;
+            }
+            sequence = get_packet_sequence();
+        }
+    }
+#if defined(LIBRARY_RECEIVER_USE_LAZY_CHANNEL_DECODING)
+    /*!
+    With lazy channel decoding only the stick channels are decoded when a packet is unpacked. The channel data is copied,
+    and the auxiliary channels are decoded by get_channel_pwm() the first time they are requested after each packet.
+    _decoded_channels has a bit set for each channel that has been decoded from the current packet.
+
+    get_channel_pwm() updates the decoded channel cache, so must be called from the same task as unpack_packet().
+    */
+    static constexpr uint32_t STICK_CHANNELS_MASK = (1U << STICK_COUNT) - 1U;
+    bool is_channel_decoded(size_t index) const { return (_decoded_channels & (1U << index)) != 0; }
+    void set_channel_decoded(size_t index) const { _decoded_channels |= 1U << index; }
+    mutable uint32_t _decoded_channels {};
+#endif
 protected:
     SerialPort& _serial_port;
     ReceiverSerialPortWatcher _serial_port_watcher;
-    bool _packet_is_empty {true};
+    std::atomic<uint32_t> _packet_sequence {0}; //!< number of packets published by the ISR, written by ISR only
+    uint32_t _packet_sequence_read {0}; //!< sequence number of the last packet read by the task
     uint32_t _received_packet_count {};
     int32_t _error_packet_count {};
+    size_t _data_ready_threshold {1};
+    bool _searching_for_start {false}; //!< true while bytes are being skipped to find the start of a frame
     size_t _packet_index {};
-    time_us32_t _start_time {};
+    time_us32_t _start_time {}; //!< arrival time of the first byte of the packet being received
+    std::array<receiver_frame_time_t, PACKET_BUFFER_COUNT> _frame_times {};
 };
@@ -40,14 +40,43 @@ void ReceiverTask::loop()
 
     _tick_count_delta = tick_count - _tick_count_previous;
     _tick_count_previous = tick_count;
+#if defined(LIBRARY_RECEIVER_USE_LATENCY_HISTOGRAMS)
+    const time_us32_t task_time = time_us();
+#endif
 
     if (_receiver.update(_tick_count_delta)) {
-        _cockpit.update_controls(tick_count, _receiver, _context);
+        const time_us32_t controls_time = time_us();
+#if defined(LIBRARY_RECEIVER_USE_LATENCY_HISTOGRAMS)
+        _receiver.record_latencies(task_time, controls_time);
+#endif
+        _cockpit.update_controls(tick_count, _receiver.get_frame_age_us(controls_time), _receiver, _context);
     } else {
         _cockpit.check_failsafe(tick_count, _context);
     }
 }
 
+/*!
+Read all the bytes the receiver has buffered and give them to the RX protocol parser, a block at a time.
+
+Every available byte is consumed, rather than stopping at the first complete packet, so that with time based scheduling
+the following update() acts on the newest frame: the latest frame wins, and any older frames completed in the same
+burst are counted as superseded (see receiver_stats_t).
+
+The bytes are given their arrival time, which with LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER is the time the ISR pushed them
+into the receive ring buffer, so the frame age includes the time spent waiting in the buffer.
+
+Returns the number of complete packets received.
+*/
+size_t ReceiverTask::drain_receiver()
+{
+    size_t packet_count = 0;
+    size_t len = 0;
+    while ((len = _receiver.read(&_read_buffer[0], _read_buffer.size())) > 0) {
+        packet_count += _receiver.on_data_received(&_read_buffer[0], len, _receiver.get_receive_time_us());
+    }
+    return packet_count;
+}
+
 /*!
 Task function for the ReceiverTask. Sets up and runs the task loop() function.
 */
@@ -61,10 +90,24 @@ Task function for the ReceiverTask. Sets up and runs the task loop() function.
         const uint32_t ticksToWait = _cockpit.get_timeout_ticks();
         while (true) {
             if (_receiver.WAIT_FOR_DATA_RECEIVED(ticksToWait) == pdPASS) {
+#if defined(LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER)
+                // the ISR has only filled the receive buffer, so drain it into the RX protocol parser.
+                // loop() is called even if no packet was completed, so the receiver is updated when receiving data
+                // it cannot parse, eg so that SBUS baudrate detection can move on from the wrong baudrate
+                drain_receiver();
+                loop();
+#else
                 loop();
+#endif
             } else {
-                // WAIT timed out, so check failsafe
-                _cockpit.check_failsafe(xTaskGetTickCount(), _context);
+#if defined(LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER)
+                // the ISR only signals once a frame's worth of data has been received, so drain anything less than that,
+                // eg a short CRSF command frame
+                drain_receiver();
+#endif
+                // WAIT timed out, so check failsafe. This is done via loop(), so the receiver is updated even when no packets
+                // are being received, eg so that CRSF can fall back to its original baudrate if a baudrate change fails
+                loop();
             }
         }
     } else {
@@ -82,16 +125,22 @@ Task function for the ReceiverTask. Sets up and runs the task loop() function.
 #else
             vTaskDelayUntil(&_previous_wake_time_ticks, task_interval_ticks);
 #endif
-            while (_receiver.is_data_available()) {
-                // Read 1 byte from UART buffer and give it to the RX protocol parser
-                if (_receiver.on_data_received_from_isr(_receiver.read_byte())) {
-                    // on_data_received returns true once packet is complete
-                    break;
-                }
-            }
+            // Read the whole burst from the UART (or receive ring buffer) and give it to the RX protocol parser
+            drain_receiver();
             loop();
         }
     }
+#elif defined(FRAMEWORK_LINUX)
+    // event driven scheduling, WAIT_FOR_DATA_RECEIVED waits on the serial device using epoll
+    const uint32_t ticksToWait = _cockpit.get_timeout_ticks();
+    while (true) {
+        if (_receiver.WAIT_FOR_DATA_RECEIVED(ticksToWait) > 0) {
+            drain_receiver();
+        }
+        // loop() is called even if no packet was completed or the WAIT timed out: it checks failsafe if there is no new packet,
+        // and updates the receiver, eg so that CRSF can fall back to its original baudrate if a baudrate change fails
+        loop();
+    }
 #else
     while (true) {}
 #endif // FRAMEWORK_USE_FREERTOS
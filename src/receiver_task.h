@@ -1,7 +1,24 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <task_base.h> // NOLINT(clang-diagnostic-pragma-pack)
 
+#if defined(FRAMEWORK_USE_FREERTOS)
+#if defined(FRAMEWORK_ESPIDF) || defined(FRAMEWORK_ARDUINO_ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#if defined(FRAMEWORK_ARDUINO_STM32)
+#include <STM32FreeRTOS.h>
+#endif
+#include <FreeRTOS.h>
+#include <task.h>
+#endif
+#endif // FRAMEWORK_USE_FREERTOS
+
 class ReceiverBase;
 class CockpitBase;
 struct receiver_context_t;
@@ -18,10 +35,74 @@ public:
 public:
     [[noreturn]] static void task_static(void* arg);
     void loop();
+    size_t drain_receiver();
 private:
     [[noreturn]] void task();
 private:
+    enum { READ_BUFFER_SIZE = 64 };
     ReceiverBase& _receiver;
     CockpitBase& _cockpit;
     receiver_context_t& _context;
+    std::array<uint8_t, READ_BUFFER_SIZE> _read_buffer {};
+};
+
+
+/*!
+Statically allocated storage for a ReceiverTask: the task object, its parameters, the FreeRTOS task control block, and its stack.
+
+The stack is provided by ReceiverTaskStorage<STACK_DEPTH_BYTES>, so the stack size is chosen per instance at compile time.
+*/
+class ReceiverTaskStorageBase {
+public:
+    typedef void (*task_function_t)(void* arg);
+public:
+    ReceiverTask* create_task(task_info_t& task_info, ReceiverBase& receiver, CockpitBase& cockpit, receiver_context_t& context, uint8_t priority, uint32_t core, uint32_t task_interval_microseconds);
+    ReceiverTask* create_task(ReceiverBase& receiver, CockpitBase& cockpit, receiver_context_t& context, uint8_t priority, uint32_t core, uint32_t task_interval_microseconds);
+    ReceiverTask* get_task() { return _receiver_task.has_value() ? &_receiver_task.value() : nullptr; }
+    bool start_task(task_info_t& task_info, TaskBase& task, task_function_t task_function, uint8_t priority, uint32_t core, uint32_t task_interval_microseconds);
+    bool is_used() const { return _task_parameters.task != nullptr; }
+protected:
+    explicit ReceiverTaskStorageBase(size_t stack_depth_bytes) : _stack_depth_bytes(stack_depth_bytes) {}
+    virtual ~ReceiverTaskStorageBase() = default;
+    virtual uint8_t* get_stack_buffer() = 0;
+private:
+    // ReceiverTaskStorageBase is not copyable or moveable, since the task uses its storage
+    ReceiverTaskStorageBase(const ReceiverTaskStorageBase&) = delete;
+    ReceiverTaskStorageBase& operator=(const ReceiverTaskStorageBase&) = delete;
+    ReceiverTaskStorageBase(ReceiverTaskStorageBase&&) = delete;
+    ReceiverTaskStorageBase& operator=(ReceiverTaskStorageBase&&) = delete;
+private:
+    size_t _stack_depth_bytes;
+    std::optional<ReceiverTask> _receiver_task {};
+    // task parameters must not be on the stack, since they are used when the task is started, which is after create_task() returns
+    TaskBase::parameters_t _task_parameters {};
+#if defined(FRAMEWORK_USE_FREERTOS)
+    StaticTask_t _task_buffer {};
+#endif
+};
+
+/*!
+Storage for a ReceiverTask with a stack of STACK_DEPTH_BYTES.
+
+Each instance holds one task, so several receivers, each with its own cockpit and core affinity, can be run by declaring a
+ReceiverTaskStorage for each, typically as a static, eg:
+
+    static ReceiverTaskStorage<4096> crsf_task_storage;
+    static ReceiverTaskStorage<2048> sbus_task_storage;
+    crsf_task_storage.create_task(crsf_receiver, crsf_cockpit, context, priority, CORE_0, 0);
+    sbus_task_storage.create_task(sbus_receiver, sbus_cockpit, context, priority, CORE_1, 0);
+*/
+template <size_t STACK_DEPTH_BYTES>
+class ReceiverTaskStorage : public ReceiverTaskStorageBase {
+public:
+    ReceiverTaskStorage() : ReceiverTaskStorageBase(STACK_DEPTH_BYTES) {}
+protected:
+    uint8_t* get_stack_buffer() override { return reinterpret_cast<uint8_t*>(&_stack[0]); } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+private:
+#if defined(FRAMEWORK_ESPIDF) || defined(FRAMEWORK_ARDUINO_ESP32) || !defined(FRAMEWORK_USE_FREERTOS)
+    std::array<uint8_t, STACK_DEPTH_BYTES> _stack {};
+#else
+    static_assert(STACK_DEPTH_BYTES % sizeof(StackType_t) == 0, "STACK_DEPTH_BYTES must be a multiple of sizeof(StackType_t)");
+    std::array<StackType_t, STACK_DEPTH_BYTES / sizeof(StackType_t)> _stack {};
+#endif
 };
@@ -40,27 +40,66 @@ ReceiverTask* ReceiverTask::create_task(ReceiverBase& receiver, CockpitBase& coc
     return create_task(task_info, receiver, cockpit, context, priority, core, task_interval_microseconds);
 }
 
+/*!
+Create and start a ReceiverTask in the default storage, which has a stack of RECEIVER_TASK_STACK_DEPTH_BYTES.
+
+The default storage holds a single task, so this may only be called once: a second call asserts, or, if assertions are
+disabled, returns nullptr. Previously each call created a new task. Use ReceiverTaskStorage to run more than one receiver task.
+*/
 ReceiverTask* ReceiverTask::create_task(task_info_t& task_info, ReceiverBase& receiver, CockpitBase& cockpit, receiver_context_t& context, uint8_t priority, uint32_t core, uint32_t task_interval_microseconds)
 {
-    static ReceiverTask receiver_task(task_interval_microseconds, receiver, cockpit, context);
-
-    // Note that task parameters must not be on the stack, since they are used when the task is started, which is after this function returns.
-    static TaskBase::parameters_t taskParameters { // NOLINT(misc-const-correctness) false positive
-        .task = &receiver_task,
-    };
 #if !defined(RECEIVER_TASK_STACK_DEPTH_BYTES)
     enum { RECEIVER_TASK_STACK_DEPTH_BYTES = 4096 };
 #endif
-#if defined(FRAMEWORK_ESPIDF) || defined(FRAMEWORK_ARDUINO_ESP32) || !defined(FRAMEWORK_USE_FREERTOS)
-    static std::array<uint8_t, RECEIVER_TASK_STACK_DEPTH_BYTES> stack;
-#else
-    static std::array<StackType_t, RECEIVER_TASK_STACK_DEPTH_BYTES / sizeof(StackType_t)> stack;
-#endif
+    // the default storage, for a single receiver task, use ReceiverTaskStorage directly to run more than one receiver task
+    static ReceiverTaskStorage<RECEIVER_TASK_STACK_DEPTH_BYTES> storage;
+
+    assert(!storage.is_used() && "ReceiverTask::create_task() called more than once, use ReceiverTaskStorage for more than one receiver task");
+    return storage.create_task(task_info, receiver, cockpit, context, priority, core, task_interval_microseconds);
+}
+
+ReceiverTask* ReceiverTaskStorageBase::create_task(ReceiverBase& receiver, CockpitBase& cockpit, receiver_context_t& context, uint8_t priority, uint32_t core, uint32_t task_interval_microseconds)
+{
+    task_info_t task_info {};
+    return create_task(task_info, receiver, cockpit, context, priority, core, task_interval_microseconds);
+}
+
+/*!
+Create a ReceiverTask for `receiver` in this storage, and, if using FreeRTOS, start it.
+
+Returns nullptr if this storage is already used.
+*/
+ReceiverTask* ReceiverTaskStorageBase::create_task(task_info_t& task_info, ReceiverBase& receiver, CockpitBase& cockpit, receiver_context_t& context, uint8_t priority, uint32_t core, uint32_t task_interval_microseconds)
+{
+    if (is_used()) {
+        return nullptr;
+    }
+    ReceiverTask& receiver_task = _receiver_task.emplace(task_interval_microseconds, receiver, cockpit, context);
+    start_task(task_info, receiver_task, ReceiverTask::task_static, priority, core, task_interval_microseconds);
+    return &receiver_task;
+}
+
+/*!
+Start `task` using this storage's stack and task control block, `task_function` is called with the task parameters,
+so must cast `parameters->task` back to the type of `task`, as ReceiverTask::task_static() does.
+
+Used to start tasks other than ReceiverTask, eg ReceiverTaskT, which must outlive the storage's use.
+
+Returns false if this storage is already used.
+*/
+bool ReceiverTaskStorageBase::start_task(task_info_t& task_info, TaskBase& task, task_function_t task_function, uint8_t priority, uint32_t core, uint32_t task_interval_microseconds)
+{
+    if (is_used()) {
+        return false;
+    }
+    _task_parameters.task = &task;
+    uint8_t* const stack_buffer = get_stack_buffer();
+
     task_info = {
         .task_handle = nullptr,
         .name = "ReceiverTask", // max length 16, including zero terminator
-        .stack_depth_bytes = RECEIVER_TASK_STACK_DEPTH_BYTES,
-        .stack_buffer = reinterpret_cast<uint8_t*>(&stack[0]), // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        .stack_depth_bytes = static_cast<uint32_t>(_stack_depth_bytes),
+        .stack_buffer = stack_buffer,
         .priority = priority,
         .core = core,
         .task_interval_microseconds = task_interval_microseconds
@@ -69,47 +108,47 @@ ReceiverTask* ReceiverTask::create_task(task_info_t& task_info, ReceiverBase& re
     assert(std::strlen(task_info.name) < configMAX_TASK_NAME_LEN);
     assert(task_info.priority < configMAX_PRIORITIES);
 
-    static StaticTask_t taskBuffer;
+    auto* const stack = reinterpret_cast<StackType_t*>(stack_buffer); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
 #if defined(FRAMEWORK_ESPIDF) || defined(FRAMEWORK_ARDUINO_ESP32)
     task_info.task_handle = xTaskCreateStaticPinnedToCore(
-        ReceiverTask::task_static,
+        task_function,
         task_info.name,
         task_info.stack_depth_bytes / sizeof(StackType_t),
-        &taskParameters,
+        &_task_parameters,
         task_info.priority,
-        &stack[0],
-        &taskBuffer,
+        stack,
+        &_task_buffer,
         task_info.core
     );
     assert(task_info.task_handle != nullptr && "Unable to create ReceiverTask");
 #elif defined(FRAMEWORK_RPI_PICO) || defined(FRAMEWORK_ARDUINO_RPI_PICO)
     task_info.task_handle = xTaskCreateStaticAffinitySet(
-        ReceiverTask::task_static,
+        task_function,
         task_info.name,
         task_info.stack_depth_bytes / sizeof(StackType_t),
-        &taskParameters,
+        &_task_parameters,
         task_info.priority,
-        &stack[0],
-        &taskBuffer,
+        stack,
+        &_task_buffer,
         task_info.core
     );
     assert(task_info.task_handle != nullptr && "Unable to create ReceiverTask");
 #else
     task_info.task_handle = xTaskCreateStatic(
-        ReceiverTask::task_static,
+        task_function,
         task_info.name,
         task_info.stack_depth_bytes / sizeof(StackType_t),
-        &taskParameters,
+        &_task_parameters,
         task_info.priority,
-        &stack[0],
-        &taskBuffer
+        stack,
+        &_task_buffer
     );
     assert(task_info.task_handle != nullptr && "Unable to create ReceiverTask");
     // vTaskCoreAffinitySet(task_info.task_handle, task_info.core);
 #endif
 #else
-    (void)taskParameters;
+    (void)task_function;
 #endif // FRAMEWORK_USE_FREERTOS
 
-    return &receiver_task;
+    return true;
 }
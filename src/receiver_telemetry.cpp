@@ -18,7 +18,11 @@ size_t pack_telemetry_data_receiver(uint8_t* telemetry_data_ptr, uint32_t id, ui
     td->tickInterval = static_cast<uint16_t>(receiver.get_tick_count_delta());
     td->dropped_packet_count = static_cast<uint16_t>(receiver.get_dropped_packet_count_delta());
 
+#if defined(LIBRARY_RECEIVER_USE_FIXED_POINT_CONTROLS)
+    td->data.controls = receiver.get_controls_q12dot4(),
+#else
     td->data.controls = receiver.get_controls(),
+#endif
     td->data.switches = receiver.get_switches(),
     td->data.aux[0] = static_cast<uint16_t>(receiver.get_auxiliary_channel(0));
     td->data.aux[1] = static_cast<uint16_t>(receiver.get_auxiliary_channel(1));
@@ -27,3 +31,38 @@ size_t pack_telemetry_data_receiver(uint8_t* telemetry_data_ptr, uint32_t id, ui
 
     return td->len;
 };
+
+#if defined(LIBRARY_RECEIVER_USE_LATENCY_HISTOGRAMS)
+/*!
+Packs percentiles of the receiver latency histograms into a TD_RECEIVER_LATENCY packet. Returns the length of the packet.
+
+If a histogram could not be read consistently (because it was being recorded to) its stage is sent with a count of zero.
+*/
+size_t pack_telemetry_data_receiver_latency(uint8_t* telemetry_data_ptr, uint32_t id, uint32_t sequence_number, const ReceiverBase& receiver)
+{
+    TD_RECEIVER_LATENCY* td = reinterpret_cast<TD_RECEIVER_LATENCY*>(telemetry_data_ptr); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,hicpp-use-auto,modernize-use-auto)
+
+    td->id = id;
+    td->type = TD_RECEIVER_LATENCY::TYPE;
+    td->len = sizeof(TD_RECEIVER_LATENCY);
+    td->subType = TD_RECEIVER_LATENCY::SUB_TYPE;
+    td->sequence_number = static_cast<uint8_t>(sequence_number);
+
+    const auto saturate = [](uint32_t value) { return static_cast<uint16_t>(value > UINT16_MAX ? UINT16_MAX : value); };
+    static ReceiverBase::latency_histogram_t::snapshot_t snapshot; // static, since it is too large to put on the stack
+    for (size_t ii = 0; ii < ReceiverBase::LATENCY_STAGE_COUNT; ++ii) {
+        TD_RECEIVER_LATENCY::stage_t& stage = td->stages[ii]; // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        if (!receiver.get_latency_histogram(static_cast<ReceiverBase::latency_stage_e>(ii)).snapshot(snapshot)) {
+            stage = {};
+            continue;
+        }
+        stage.count = snapshot.count;
+        stage.p50 = saturate(snapshot.value_at_percentile(50));
+        stage.p90 = saturate(snapshot.value_at_percentile(90));
+        stage.p99 = saturate(snapshot.value_at_percentile(99));
+        stage.max = saturate(snapshot.max);
+    }
+
+    return td->len;
+}
+#endif
@@ -22,10 +22,38 @@ struct TD_RECEIVER {
     uint16_t tickInterval {0}; //!< tick number of ticks since last receiver update
     uint16_t dropped_packet_count {0}; //!< the number of packets dropped by the receiver
     struct data_t {
+#if defined(LIBRARY_RECEIVER_USE_FIXED_POINT_CONTROLS)
+        receiver_controls_q12dot4_t controls; //!< controls in q12dot4 fixed point format
+#else
         receiver_controls_t controls;
+#endif
         uint32_t switches;
         std::array<uint16_t, 4> aux; //!< 4 auxiliary channels
     };
     data_t data;
 };
+
+/*!
+Packet for the transmission of the receiver pipeline latency histograms, summarized as percentiles.
+
+Has the same type as TD_RECEIVER, distinguished by its subType. Latencies are in microseconds, saturated at 65535.
+*/
+struct TD_RECEIVER_LATENCY {
+    enum { TYPE = TD_RECEIVER::TYPE };
+    enum { SUB_TYPE = 1 };
+    uint32_t id {0};
+    uint8_t type {TYPE};
+    uint8_t len {sizeof(TD_RECEIVER_LATENCY)}; //!< length of whole packet, ie sizeof(TD_RECEIVER_LATENCY)
+    uint8_t subType {SUB_TYPE};
+    uint8_t sequence_number {0};
+
+    struct stage_t {
+        uint32_t count; //!< number of frames recorded
+        uint16_t p50;
+        uint16_t p90;
+        uint16_t p99;
+        uint16_t max;
+    };
+    std::array<stage_t, ReceiverBase::LATENCY_STAGE_COUNT> stages; //!< indexed by ReceiverBase::latency_stage_e
+};
 #pragma pack(pop)
@@ -21,6 +21,10 @@ bool ReceiverVirtual::update(uint32_t tick_count_delta)
 {
     (void)tick_count_delta;
 
+    // a virtual frame arrives when it is updated
+    const time_us32_t time = time_us();
+    _frame_time = { time, time, time };
+
     ++_packet_count;
     _dropped_packet_count = static_cast<int32_t>(_received_packet_count) - _packet_count;
     _dropped_packet_count_delta = _dropped_packet_count - _dropped_packet_count_previous;
@@ -25,7 +25,17 @@ public:
 public: // for testing
     void set_channel_pwm(size_t index, uint16_t pwm_value);
     void set_auxiliary_channel_pwm(size_t index, uint16_t pwm_value) { set_channel_pwm(index + ReceiverBase::STICK_COUNT, pwm_value); }
+#if defined(LIBRARY_RECEIVER_USE_FIXED_POINT_CONTROLS)
+    void set_controls(const receiver_controls_t& controls) {
+        _controls_q12dot4 = { float_to_q12dot4(controls.throttle), float_to_q12dot4(controls.roll), float_to_q12dot4(controls.pitch), float_to_q12dot4(controls.yaw) };
+    }
+    void set_controls(const receiver_controls_q12dot4_t& controls) { _controls_q12dot4 = controls; }
+#else
     void set_controls(const receiver_controls_t& controls) { _controls = controls; }
+    void set_controls(const receiver_controls_q12dot4_t& controls) {
+        _controls = { q12dot4_to_float(controls.throttle), q12dot4_to_float(controls.roll), q12dot4_to_float(controls.pitch), q12dot4_to_float(controls.yaw) };
+    }
+#endif
 private:
     uint32_t _received_packet_count {};
     std::array<uint16_t, CHANNEL_COUNT> _pwm_values {};
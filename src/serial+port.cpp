@@ -2,10 +2,22 @@
 
 #include "receiver_base.h"
 
+#include <cassert>
+#include <cstring>
+
 #if defined(FRAMEWORK_RPI_PICO) || defined(FRAMEWORK_ARDUINO_RPI_PICO)
 #include <hardware/gpio.h>
 #include <hardware/uart.h>
 #elif defined(FRAMEWORK_ESPIDF)
+#elif defined(FRAMEWORK_LINUX)
+// use termios2 directly, rather than <termios.h>, so that non-standard baudrates (eg 416666 and 420000) can be set
+#include <asm/ioctls.h>
+#include <asm/termbits.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+// <sys/ioctl.h> conflicts with <asm/termbits.h>, so declare ioctl directly
+extern "C" int ioctl(int fd, unsigned long request, ...) noexcept; // NOLINT(cert-dcl50-cpp)
 #elif defined(FRAMEWORK_TEST)
 #elif defined(FRAMEWORK_STM32_CUBE) || defined(FRAMEWORK_ARDUINO_STM32)
 static inline GPIO_TypeDef* gpioPort(uint8_t port) { return reinterpret_cast<GPIO_TypeDef*>(GPIOA_BASE + port*(GPIOB_BASE - GPIOA_BASE)); }
@@ -14,49 +26,178 @@ static inline uint16_t gpioPin(uint8_t pin) { return static_cast<uint16_t>(1U <<
 #endif // FRAMEWORK
 
 
+std::array<SerialPort*, SerialPort::UART_COUNT> SerialPort::instances {};
+
+
 /*!
-Pointer to the receiver used by the ISR.
+Dispatch a UART interrupt to the SerialPort using UART `uart_index`.
 */
-SerialPort* SerialPort::self;
-
+FAST_CODE void SerialPort::data_ready_isr(uint8_t uart_index)
+{
+    SerialPort* serial_port = get_instance(uart_index);
+    if (serial_port != nullptr) {
+        serial_port->data_ready_from_isr();
+    }
+}
 
 #if defined(FRAMEWORK_RPI_PICO) || defined(FRAMEWORK_ARDUINO_RPI_PICO)
-void __not_in_flash_func(SerialPort::data_ready_isr)() // NOLINT(bugprone-reserved-identifier,cert-dcl37-c,cert-dcl51-cpp)
+void __not_in_flash_func(SerialPort::uart0_irq_handler)() // NOLINT(bugprone-reserved-identifier,cert-dcl37-c,cert-dcl51-cpp)
+{
+    data_ready_isr(UART_INDEX_0);
+}
+
+void __not_in_flash_func(SerialPort::uart1_irq_handler)() // NOLINT(bugprone-reserved-identifier,cert-dcl37-c,cert-dcl51-cpp)
+{
+    data_ready_isr(UART_INDEX_1);
+}
+
+void __not_in_flash_func(SerialPort::data_ready_from_isr)() // NOLINT(bugprone-reserved-identifier,cert-dcl37-c,cert-dcl51-cpp)
 {
     //gpio_put(PICO_DEFAULT_LED_PIN, 1);
-    while (uart_is_readable(self->_uart)) {
-        // Read 1 byte from UART buffer and give it to the RX protocol parser
-        const uint8_t data = uart_getc(self->_uart);
-        if (self->on_data_received_from_isr(data)) {
-            // on_data_received returns true once packet is complete
-            self->SIGNAL_DATA_READY_FROM_ISR();
+#if defined(LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER)
+    // Move the UART FIFO into the ring buffer and leave the parsing to the ReceiverTask.
+    // The receive timeout interrupt means the line has gone idle, ie the end of a burst, it is cleared by reading the FIFO
+    const bool line_idle = (uart_get_hw(_uart)->mis & UART_UARTMIS_RTMIS_BITS) != 0;
+    const size_t available_before = _rx_buffer.available();
+    set_receive_time_from_isr(time_us());
+    while (uart_is_readable(_uart)) {
+        _rx_buffer.push(static_cast<uint8_t>(uart_getc(_uart)));
+    }
+    if (data_ready_threshold_reached(available_before) || (line_idle && _rx_buffer.available() > 0)) {
+        SIGNAL_DATA_READY_FROM_ISR();
+    }
+#else
+    // Read the UART FIFO and give it to the RX protocol parser in a single call
+    enum { UART_FIFO_SIZE = 32 };
+    std::array<uint8_t, UART_FIFO_SIZE> buf; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+    const time_us32_t time_now_us = time_us();
+    while (uart_is_readable(_uart)) {
+        size_t len = 0;
+        while (len < buf.size() && uart_is_readable(_uart)) {
+            buf[len] = static_cast<uint8_t>(uart_getc(_uart));
+            ++len;
+        }
+        if (on_data_received_from_isr(&buf[0], len, time_now_us)) {
+            // on_data_received returns the number of complete packets
+            SIGNAL_DATA_READY_FROM_ISR();
         }
     }
+#endif
 }
 #elif defined(FRAMEWORK_STM32_CUBE)
-// ISR called back when byte received on uart
-#if false
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) // cppcheck-suppress constParameterPointer
+#if !defined(LIBRARY_RECEIVER_USE_APPLICATION_HAL_UART_CALLBACK)
+/*!
+ISR called back by the HAL when a byte has been received on a UART, overrides the HAL's weak definition.
+If the application needs its own HAL_UART_RxCpltCallback, for UARTs that are not used by a SerialPort, then define
+LIBRARY_RECEIVER_USE_APPLICATION_HAL_UART_CALLBACK and forward the callback to SerialPort::data_ready_isr(huart),
+which ignores UARTs that do not belong to a SerialPort.
+*/
+extern "C" void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) // cppcheck-suppress constParameterPointer
 {
     SerialPort::data_ready_isr(huart);
 }
 #endif
 
+/*!
+Returns the UART index of the STM32 USART `instance`, the inverse of the mapping in init(). STM32 indices are 1-based.
+*/
+uint8_t SerialPort::get_uart_index(const USART_TypeDef* instance)
+{
+    if (instance == USART1) {
+        return UART_INDEX_0;
+    }
+#if defined(USART2)
+    if (instance == USART2) {
+        return UART_INDEX_1;
+    }
+#endif
+#if defined(USART3)
+    if (instance == USART3) {
+        return UART_INDEX_2;
+    }
+#endif
+#if defined(UART4)
+    if (instance == UART4) {
+        return UART_INDEX_3;
+    }
+#endif
+#if defined(UART5)
+    if (instance == UART5) {
+        return UART_INDEX_4;
+    }
+#endif
+#if defined(USART6)
+    if (instance == USART6) {
+        return UART_INDEX_5;
+    }
+#endif
+#if defined(UART7)
+    if (instance == UART7) {
+        return UART_INDEX_6;
+    }
+#endif
+#if defined(UART8)
+    if (instance == UART8) {
+        return UART_INDEX_7;
+    }
+#endif
+    return UART_COUNT;
+}
+
 FAST_CODE void SerialPort::data_ready_isr(const UART_HandleTypeDef *huart) // NOLINT(readability-convert-member-functions-to-static)
 {
-    if (huart->Instance == self->_uart.Instance) {
-        if (self->on_data_received_from_isr(self->_rx_byte)) {
-            // on_data_received returns true once packet is complete
-            self->SIGNAL_DATA_READY_FROM_ISR();
+    data_ready_isr(get_uart_index(huart->Instance));
+}
+
+FAST_CODE void SerialPort::data_ready_from_isr()
+{
+#if defined(LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER)
+    const size_t available_before = _rx_buffer.available();
+    set_receive_time_from_isr(time_us());
+    _rx_buffer.push(_rx_byte);
+    if (data_ready_threshold_reached(available_before)) {
+        SIGNAL_DATA_READY_FROM_ISR();
+    }
+#else
+    if (on_data_received_from_isr(_rx_byte)) {
+        // on_data_received returns true once packet is complete
+        SIGNAL_DATA_READY_FROM_ISR();
+    }
+#endif
+    // Re-enable the interrupt for the next byte
+    HAL_UART_Receive_IT(&_uart, &_rx_byte, 1);
+}
+#elif defined(FRAMEWORK_TEST)
+/*!
+For FRAMEWORK_TEST, read the simulated UART FIFO, filled by receive_into_uart_fifo(), in the same way as the RPI Pico ISR.
+*/
+void SerialPort::data_ready_from_isr()
+{
+#if defined(LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER)
+    const size_t available_before = _rx_buffer.available();
+    set_receive_time_from_isr(time_us());
+    uint8_t data = 0;
+    while (_uart_fifo.pop(data)) {
+        _rx_buffer.push(data);
+    }
+    if (data_ready_threshold_reached(available_before)) {
+        SIGNAL_DATA_READY_FROM_ISR();
+    }
+#else
+    std::array<uint8_t, UART_FIFO_SIZE> buf; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+    const time_us32_t time_now_us = time_us();
+    size_t len = 0;
+    while ((len = _uart_fifo.read(&buf[0], buf.size())) > 0) {
+        if (on_data_received_from_isr(&buf[0], len, time_now_us)) {
+            SIGNAL_DATA_READY_FROM_ISR();
         }
-        // Re-enable the interrupt for the next byte
-        HAL_UART_Receive_IT(&self->_uart, &self->_rx_byte, 1);
     }
+#endif
 }
 #else
-FAST_CODE void SerialPort::data_ready_isr()
+FAST_CODE void SerialPort::data_ready_from_isr()
 {
-    self->SIGNAL_DATA_READY_FROM_ISR();
+    SIGNAL_DATA_READY_FROM_ISR();
 }
 #endif
 
@@ -78,6 +219,20 @@ SerialPort::SerialPort(SerialPortWatcherBase* watcher, const serial_pins_t& pins
     ,_uart(uart_index)
 #endif
 {
+    if (uart_index < UART_COUNT) {
+        assert(instances[uart_index] == nullptr && "UART already has a SerialPort");
+        instances[uart_index] = this;
+    }
+}
+
+SerialPort::~SerialPort()
+{
+#if defined(FRAMEWORK_LINUX)
+    close();
+#endif
+    if (_uart_index < UART_COUNT && instances[_uart_index] == this) {
+        instances[_uart_index] = nullptr;
+    }
 }
 
 SerialPort::SerialPort(const stm32_uart_pins_t& pins, uint8_t uart_index, uint32_t baudrate, uint8_t data_bits, uint8_t stop_bits, uint8_t parity) :
@@ -90,6 +245,57 @@ SerialPort::SerialPort(const uart_pins_t& pins, uint8_t uart_index, uint32_t bau
 {
 }
 
+#if defined(FRAMEWORK_LINUX)
+SerialPort::SerialPort(const char* device, uint32_t baudrate, uint8_t data_bits, uint8_t stop_bits, uint8_t parity) :
+    SerialPort(nullptr, serial_pins_t{}, UART_INDEX_NONE, baudrate, data_bits, stop_bits, parity)
+{
+    _device = device;
+}
+
+void SerialPort::close()
+{
+    if (_epoll_fd >= 0) {
+        ::close(_epoll_fd);
+        _epoll_fd = -1;
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+}
+
+/*!
+Sets the tty to raw mode with the given baudrate, using termios2 so that any baudrate may be used.
+*/
+bool SerialPort::set_termios(uint32_t baudrate) // NOLINT(readability-make-member-function-const)
+{
+    struct termios2 tio {};
+    if (ioctl(_fd, TCGETS2, &tio) < 0) {
+        return false;
+    }
+    // raw mode: no input or output processing, no echo, no signals
+    tio.c_iflag = 0;
+    tio.c_oflag = 0;
+    tio.c_lflag = 0;
+    tio.c_cflag = CLOCAL | CREAD | BOTHER;
+    tio.c_cflag |= (_data_bits == DATA_BITS_5) ? CS5 : (_data_bits == DATA_BITS_6) ? CS6 : (_data_bits == DATA_BITS_7) ? CS7 : CS8;
+    if (_stop_bits == STOP_BITS_2) {
+        tio.c_cflag |= CSTOPB;
+    }
+    if (_parity == PARITY_EVEN) {
+        tio.c_cflag |= PARENB;
+    } else if (_parity == PARITY_ODD) {
+        tio.c_cflag |= PARENB | PARODD;
+    }
+    tio.c_ispeed = baudrate;
+    tio.c_ospeed = baudrate;
+    // reads return immediately, waiting is done using epoll
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    return ioctl(_fd, TCSETS2, &tio) == 0;
+}
+#endif
+
 void SerialPort::init() // NOLINT(readability-make-member-function-const)
 {
 #if defined(FRAMEWORK_RPI_PICO) || defined(FRAMEWORK_ARDUINO_RPI_PICO)
@@ -112,7 +318,7 @@ void SerialPort::init() // NOLINT(readability-make-member-function-const)
 
     // Enable UART interrupt
     const irq_num_t irqNum = _uart_index == 0 ? UART0_IRQ : UART1_IRQ;
-    irq_set_exclusive_handler(irqNum, data_ready_isr);
+    irq_set_exclusive_handler(irqNum, _uart_index == 0 ? uart0_irq_handler : uart1_irq_handler);
     irq_set_enabled(irqNum, true);
     enum { RX_NEEDS_DATA = true, RX_DOES_NOT_NEED_DATA = false };
     enum { TX_NEEDS_DATA = true, TX_DOES_NOT_NEED_DATA = false };
@@ -216,6 +422,22 @@ void SerialPort::init() // NOLINT(readability-make-member-function-const)
 #if !defined(FRAMEWORK_STM32_CUBE_F1)
         alternate = GPIO_AF8_USART6;
 #endif
+#endif
+    } else if (_uart_index == 6) { // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+#if defined(UART7)
+        __HAL_RCC_UART7_CLK_ENABLE();
+        _uart.Instance = UART7;
+#if defined(FRAMEWORK_STM32_CUBE_F4)
+        alternate = GPIO_AF8_UART7;
+#endif
+#endif
+    } else if (_uart_index == 7) { // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+#if defined(UART8)
+        __HAL_RCC_UART8_CLK_ENABLE();
+        _uart.Instance = UART8;
+#if defined(FRAMEWORK_STM32_CUBE_F4)
+        alternate = GPIO_AF8_UART8;
+#endif
 #endif
     }
 
@@ -239,8 +461,28 @@ void SerialPort::init() // NOLINT(readability-make-member-function-const)
     HAL_UART_Receive_IT(&_uart, &_rx_byte, 1);
 
 
+#elif defined(FRAMEWORK_LINUX)
+    if (_device == nullptr) {
+        return;
+    }
+    close();
+    _fd = ::open(_device, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC); // NOLINT(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+    if (_fd < 0) {
+        return;
+    }
+    if (!set_termios(_baudrate)) {
+        close();
+        return;
+    }
+    ioctl(_fd, TCFLSH, TCIOFLUSH); // NOLINT(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+    _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.fd = _fd;
+    if (_epoll_fd < 0 || epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _fd, &event) < 0) {
+        close();
+    }
 #elif defined(FRAMEWORK_TEST)
-
 #else // defaults to FRAMEWORK_ARDUINO
 #if defined(FRAMEWORK_ARDUINO_ESP32)
     const uint32_t config = (_parity == PARITY_NONE) ? SERIAL_8N1 : (_parity == PARITY_EVEN) ? SERIAL_8E1 : SERIAL_8O1;
@@ -253,8 +495,9 @@ void SerialPort::uartInit() // NOLINT(readability-make-member-function-const)
 {
 #if defined(FRAMEWORK_STM32_CUBE) || defined(FRAMEWORK_ARDUINO_STM32)
     _uart.Init.BaudRate = _baudrate;
-    _uart.Init.WordLength = UART_WORDLENGTH_8B;
-    _uart.Init.StopBits = UART_STOPBITS_1;
+    // the word length includes the parity bit
+    _uart.Init.WordLength = (_parity == PARITY_NONE) ? UART_WORDLENGTH_8B : UART_WORDLENGTH_9B;
+    _uart.Init.StopBits = (_stop_bits == STOP_BITS_2) ? UART_STOPBITS_2 : UART_STOPBITS_1;
     _uart.Init.Parity = (_parity == PARITY_NONE) ? UART_PARITY_NONE : (_parity == PARITY_EVEN) ? UART_PARITY_EVEN : UART_PARITY_ODD;
     _uart.Init.Mode = UART_MODE_TX_RX;
     _uart.Init.HwFlowCtl = UART_HWCONTROL_NONE;
@@ -279,19 +522,38 @@ This waits for data from the serial UART
 */
 int32_t SerialPort::WAIT_FOR_DATA_RECEIVED(uint32_t ticksToWait) // NOLINT(readability-make-member-function-const)
 {
+#if defined(FRAMEWORK_LINUX)
+    if (_epoll_fd < 0) {
+        return 0;
+    }
+    // ticks are milliseconds, 0xFFFFFFFF (portMAX_DELAY) converts to -1, which waits indefinitely
+    epoll_event event {};
+    return epoll_wait(_epoll_fd, &event, 1, static_cast<int>(ticksToWait)) > 0 ? 1 : 0;
+#else
     return WAIT_DATA_READY(ticksToWait);
+#endif
 }
 
+/*!
+If LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER is defined then data is read from the receive ring buffer, filled by the ISR.
+
+For FRAMEWORK_TEST there is no hardware, so the receive ring buffer is always used, and is filled using push_from_isr().
+
+For FRAMEWORK_LINUX data is read from the serial device.
+*/
 bool SerialPort::is_data_available() const
 {
-#if defined(FRAMEWORK_RPI_PICO) || defined(FRAMEWORK_ARDUINO_RPI_PICO)
+#if defined(FRAMEWORK_LINUX)
+    int available = 0;
+    return _fd >= 0 && ioctl(_fd, FIONREAD, &available) == 0 && available > 0; // NOLINT(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+#elif defined(LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER) || defined(FRAMEWORK_TEST)
+    return !_rx_buffer.empty();
+#elif defined(FRAMEWORK_RPI_PICO) || defined(FRAMEWORK_ARDUINO_RPI_PICO)
     return uart_is_readable(_uart);
 #elif defined(FRAMEWORK_ESPIDF)
     return false;
 #elif defined(FRAMEWORK_STM32_CUBE) || defined(FRAMEWORK_ARDUINO_STM32)
     return (__HAL_UART_GET_FLAG(&_uart, UART_FLAG_RXNE)) ? true : false;
-#elif defined(FRAMEWORK_TEST)
-    return false;
 #else // defaults to FRAMEWORK_ARDUINO
 #if defined(FRAMEWORK_ARDUINO_ESP32)
     return const_cast<HardwareSerial&>(_uart).available() > 0;
@@ -306,7 +568,14 @@ Used to get received byte when using time-based scheduling.
 */
 uint8_t SerialPort::read_byte()
 {
-#if defined(FRAMEWORK_RPI_PICO) || defined(FRAMEWORK_ARDUINO_RPI_PICO)
+#if defined(FRAMEWORK_LINUX)
+    uint8_t data {};
+    return _fd >= 0 && ::read(_fd, &data, 1) == 1 ? data : 0;
+#elif defined(LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER) || defined(FRAMEWORK_TEST)
+    uint8_t data {};
+    _rx_buffer.pop(data);
+    return data;
+#elif defined(FRAMEWORK_RPI_PICO) || defined(FRAMEWORK_ARDUINO_RPI_PICO)
     return uart_getc(_uart);
 #elif defined(FRAMEWORK_ESPIDF)
     return 0;
@@ -318,8 +587,6 @@ uint8_t SerialPort::read_byte()
     HAL_UART_Receive(&_uart, &data, sizeof(data), HAL_MAX_DELAY);
 #endif
     return data;
-#elif defined(FRAMEWORK_TEST)
-    return 0;
 #else // defaults to FRAMEWORK_ARDUINO
 #if defined(FRAMEWORK_ARDUINO_ESP32)
     return static_cast<uint8_t>(_uart.read());
@@ -329,6 +596,76 @@ uint8_t SerialPort::read_byte()
 #endif
 }
 
+/*!
+Read up to `max_len` bytes that have already been received, without blocking.
+
+Empties the UART FIFO, driver buffer, or receive ring buffer in a single call, returns the number of bytes read.
+*/
+size_t SerialPort::read(uint8_t* buf, size_t max_len)
+{
+#if defined(FRAMEWORK_LINUX)
+    if (_fd < 0) {
+        return 0;
+    }
+    // non-blocking, so returns whatever the driver has buffered
+    const ssize_t len = ::read(_fd, buf, max_len);
+    return len > 0 ? static_cast<size_t>(len) : 0;
+#elif defined(LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER) || defined(FRAMEWORK_TEST)
+    return _rx_buffer.read(buf, max_len);
+#elif defined(FRAMEWORK_RPI_PICO) || defined(FRAMEWORK_ARDUINO_RPI_PICO)
+    size_t len = 0;
+    while (len < max_len && uart_is_readable(_uart)) {
+        buf[len] = static_cast<uint8_t>(uart_getc(_uart)); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        ++len;
+    }
+    return len;
+#elif defined(FRAMEWORK_ESPIDF)
+    (void)buf;
+    (void)max_len;
+    return 0;
+#elif defined(FRAMEWORK_STM32_CUBE) || defined(FRAMEWORK_ARDUINO_STM32)
+    // read the data register directly, rather than using HAL_UART_Receive with its per-byte timeout handling
+    size_t len = 0;
+    while (len < max_len && __HAL_UART_GET_FLAG(&_uart, UART_FLAG_RXNE)) {
+#if defined(FRAMEWORK_STM32_CUBE_F3) || defined(FRAMEWORK_STM32_CUBE_F7)
+        buf[len] = static_cast<uint8_t>(_uart.Instance->RDR & 0xFF); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+#elif defined(FRAMEWORK_STM32_CUBE_F1) || defined(FRAMEWORK_STM32_CUBE_F4)
+        buf[len] = static_cast<uint8_t>(_uart.Instance->DR & 0xFF); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+#else
+        HAL_UART_Receive(&_uart, &buf[len], 1, 0); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+#endif
+        ++len;
+    }
+    return len;
+#else // defaults to FRAMEWORK_ARDUINO
+#if defined(FRAMEWORK_ARDUINO_ESP32)
+    const size_t available = static_cast<size_t>(_uart.available());
+    return _uart.read(buf, available < max_len ? available : max_len);
+#else
+    const size_t available = static_cast<size_t>(Serial.available());
+    return Serial.readBytes(buf, available < max_len ? available : max_len);
+#endif
+#endif
+}
+
+/*!
+Returns the arrival time of the data returned by read().
+
+If the receive ring buffer is used this is the time the ISR pushed the newest data into it, so that the age of a frame
+includes the time it waited in the buffer. Otherwise read() takes the data directly from the UART or serial device,
+so the current time is returned.
+*/
+time_us32_t SerialPort::get_receive_time_us() const
+{
+#if defined(FRAMEWORK_LINUX)
+    return time_us();
+#elif defined(LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER) || defined(FRAMEWORK_TEST)
+    return _receive_time_us.load(std::memory_order_relaxed);
+#else
+    return time_us();
+#endif
+}
+
 size_t SerialPort::available_for_write()
 {
 #if defined(FRAMEWORK_RPI_PICO)
@@ -337,6 +674,9 @@ size_t SerialPort::available_for_write()
     return 0;
 #elif defined(FRAMEWORK_STM32_CUBE) || defined(FRAMEWORK_ARDUINO_STM32)
     return (__HAL_UART_GET_FLAG(&_uart, UART_FLAG_TXE)) ? true : false;
+#elif defined(FRAMEWORK_LINUX)
+    // writes are queued by the tty driver
+    return _fd >= 0 ? 1 : 0;
 #elif defined(FRAMEWORK_TEST)
     return 0;
 #else // defaults to FRAMEWORK_ARDUINO
@@ -356,8 +696,12 @@ void SerialPort::write_byte(uint8_t data)
     (void)data;
 #elif defined(FRAMEWORK_STM32_CUBE) || defined(FRAMEWORK_ARDUINO_STM32)
     HAL_UART_Transmit(&_uart, &data, 1, HAL_MAX_DELAY);
+#elif defined(FRAMEWORK_LINUX)
+    if (_fd >= 0) {
+        (void)::write(_fd, &data, 1);
+    }
 #elif defined(FRAMEWORK_TEST)
-    (void)data;
+    _tx_buffer.push(data);
 #else // defaults to FRAMEWORK_ARDUINO
 #if defined(FRAMEWORK_ARDUINO_ESP32)
     _uart.write(data);
@@ -379,15 +723,61 @@ size_t SerialPort::write(const uint8_t* buf, size_t len)
 #elif defined(FRAMEWORK_STM32_CUBE) || defined(FRAMEWORK_ARDUINO_STM32)
     HAL_UART_Transmit(&_uart, buf, len, HAL_MAX_DELAY);
     return len;
+#elif defined(FRAMEWORK_LINUX)
+    if (_fd < 0) {
+        return 0;
+    }
+    const ssize_t written = ::write(_fd, buf, len);
+    return written > 0 ? static_cast<size_t>(written) : 0;
 #elif defined(FRAMEWORK_TEST)
+    return _tx_buffer.write(buf, len);
+#else // defaults to FRAMEWORK_ARDUINO
+#if defined(FRAMEWORK_ARDUINO_ESP32)
+    return _uart.write(buf, len);
+#else
+    return Serial.write(buf, len);
+#endif
+#endif
+}
+
+/*!
+Write `len` bytes without blocking, so may be called from an ISR, eg to reply to a poll as soon as it is received.
+
+The data is queued for interrupt driven transmission: into the UART transmit FIFO on the RPI Pico,
+or copied and sent using HAL_UART_Transmit_IT() on the STM32. So `len` must be at most TX_FROM_ISR_BUFFER_SIZE.
+
+Returns the number of bytes queued, which is less than `len` if the transmitter is busy.
+*/
+size_t SerialPort::write_from_isr(const uint8_t* buf, size_t len)
+{
+    assert(len <= TX_FROM_ISR_BUFFER_SIZE);
+#if defined(FRAMEWORK_RPI_PICO)
+    size_t count = 0;
+    while (count < len && uart_is_writable(_uart)) {
+        // the FIFO has space, so this does not block
+        uart_putc_raw(_uart, static_cast<char>(buf[count])); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        ++count;
+    }
+    return count;
+#elif defined(FRAMEWORK_ESPIDF)
     (void)buf;
     (void)len;
     return 0;
+#elif defined(FRAMEWORK_STM32_CUBE) || defined(FRAMEWORK_ARDUINO_STM32)
+    if (_uart.gState != HAL_UART_STATE_READY) {
+        return 0;
+    }
+    memcpy(&_tx_from_isr_buffer[0], buf, len);
+    return HAL_UART_Transmit_IT(&_uart, &_tx_from_isr_buffer[0], static_cast<uint16_t>(len)) == HAL_OK ? len : 0;
+#elif defined(FRAMEWORK_LINUX) || defined(FRAMEWORK_TEST)
+    return write(buf, len);
 #else // defaults to FRAMEWORK_ARDUINO
 #if defined(FRAMEWORK_ARDUINO_ESP32)
+    // the ESP32 receive callback runs in the UART event task rather than an ISR, and writes go to the transmit ring buffer
     return _uart.write(buf, len);
 #else
-    return Serial.write(buf, len);
+    // only write if the data fits in the transmit buffer, so the write does not block
+    return static_cast<size_t>(Serial.availableForWrite()) >= len ? Serial.write(buf, len) : 0;
 #endif
 #endif
 }
@@ -397,6 +787,11 @@ bool SerialPort::on_data_received_from_isr(uint8_t data)
     return _watcher ? _watcher->on_data_received_from_isr(data) : true;
 }
 
+size_t SerialPort::on_data_received_from_isr(const uint8_t* data, size_t len, time_us32_t timestamp)
+{
+    return _watcher ? _watcher->on_data_received_from_isr(data, len, timestamp) : len;
+}
+
 uint32_t SerialPort::set_baudrate(uint32_t baudrate)
 {
     _baudrate = baudrate;
@@ -407,6 +802,13 @@ uint32_t SerialPort::set_baudrate(uint32_t baudrate)
 #elif defined(FRAMEWORK_STM32_CUBE) || defined(FRAMEWORK_ARDUINO_STM32)
     HAL_UART_DeInit(&_uart);
     uartInit();
+    // HAL_UART_DeInit() aborts the pending receive, so re-enable the receive interrupt, as init() does
+    HAL_UART_Receive_IT(&_uart, &_rx_byte, 1);
+    return baudrate;
+#elif defined(FRAMEWORK_LINUX)
+    if (_fd >= 0) {
+        return set_termios(baudrate) ? baudrate : 0;
+    }
     return baudrate;
 #elif defined(FRAMEWORK_TEST)
     return baudrate;
@@ -419,3 +821,30 @@ uint32_t SerialPort::set_baudrate(uint32_t baudrate)
 #endif
 #endif
 }
+
+/*!
+Set the baudrate and frame format, eg to switch between the 8E2 used by SBUS and the 8N1 used by CRSF and IBUS.
+
+Returns the baudrate set, or 0 on failure.
+*/
+uint32_t SerialPort::set_config(uint32_t baudrate, uint8_t data_bits, uint8_t stop_bits, uint8_t parity)
+{
+    _data_bits = data_bits;
+    _stop_bits = stop_bits;
+    _parity = parity;
+#if defined(FRAMEWORK_RPI_PICO) || defined(FRAMEWORK_ARDUINO_RPI_PICO)
+    const uart_parity_t uart_parity =
+        (_parity == PARITY_NONE) ? UART_PARITY_NONE :
+        (_parity == PARITY_EVEN) ? UART_PARITY_EVEN : UART_PARITY_ODD;
+    uart_set_format(_uart, _data_bits, _stop_bits, uart_parity);
+    return set_baudrate(baudrate);
+#elif defined(FRAMEWORK_ARDUINO_ESP32)
+    _baudrate = baudrate;
+    _uart.end();
+    init();
+    return baudrate;
+#else
+    // set_baudrate() reinitializes the UART (STM32) or the tty (Linux) using the new frame format
+    return set_baudrate(baudrate);
+#endif
+}
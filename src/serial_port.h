@@ -1,6 +1,10 @@
 #pragma once
 
+#include "spsc_ring_buffer.h"
+
 #include <array>
+#include <atomic>
+#include <cstddef>
 #include <time_microseconds.h>
 
 
@@ -16,13 +20,13 @@
 
 #if defined(FRAMEWORK_ESPIDF) || defined(FRAMEWORK_ARDUINO_ESP32)
 #include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
+#include <freertos/task.h>
 #else
 #if defined(FRAMEWORK_STM32_CUBE) || defined(FRAMEWORK_ARDUINO_STM32)
 #include <STM32FreeRTOS.h>
 #endif
 #include <FreeRTOS.h>
-#include <queue.h>
+#include <task.h>
 #endif
 
 #endif // FRAMEWORK_USE_FREERTOS
@@ -50,6 +54,10 @@
 #include <stm32f7xx_hal_gpio.h>
 #include <stm32f7xx_hal_uart.h>
 #endif
+#elif defined(FRAMEWORK_LINUX)
+#if defined(FRAMEWORK_TEST)
+#error "FRAMEWORK_LINUX and FRAMEWORK_TEST are separate frameworks, define only one of them"
+#endif
 #elif defined(FRAMEWORK_TEST)
 #else // defaults to FRAMEWORK_ARDUINO
 #if defined(FRAMEWORK_ARDUINO_ESP32)
@@ -62,6 +70,8 @@ class SerialPortWatcherBase {
 public:
     virtual ~SerialPortWatcherBase() = default;
     virtual bool on_data_received_from_isr(uint8_t data) = 0;
+    //! Returns the number of complete packets received
+    virtual size_t on_data_received_from_isr(const uint8_t* data, size_t len, time_us32_t timestamp) = 0;
 };
 
 
@@ -75,6 +85,9 @@ public:
     static constexpr uint8_t UART_INDEX_5 = 5;
     static constexpr uint8_t UART_INDEX_6 = 6;
     static constexpr uint8_t UART_INDEX_7 =7;
+    static constexpr size_t UART_COUNT = 8;
+    //! For a SerialPort that is not driven by a UART interrupt, eg a Linux tty or a test port, so is not registered in `instances`.
+    static constexpr uint8_t UART_INDEX_NONE = 0xFF;
 
     static constexpr uint8_t PARITY_NONE = 0;
     static constexpr uint8_t PARITY_EVEN = 1;
@@ -89,7 +102,7 @@ public:
     static constexpr uint8_t DATA_BITS_8 = 8;
     static constexpr uint8_t DATA_BITS_9 = 9;
 
-    static constexpr uint8_t BAUDRATE_AUTO = 0;
+    static constexpr uint8_t BAUDRATE_AUTO = 0; //!< baudrate and frame format are found using ReceiverAutoDetect
     static constexpr uint8_t BAUDRATE_9600 = 1;
     static constexpr uint8_t BAUDRATE_19200 = 2;
     static constexpr uint8_t BAUDRATE_38400 = 3;
@@ -106,6 +119,17 @@ public:
     static constexpr uint8_t BAUDRATE_2000000 = 14;
     static constexpr uint8_t BAUDRATE_2470000 = 15;
     static constexpr uint8_t BAUDRATE_COUNT = 16;
+
+#if defined(SERIAL_PORT_RX_BUFFER_SIZE)
+    static constexpr size_t RX_BUFFER_SIZE = SERIAL_PORT_RX_BUFFER_SIZE;
+#else
+    static constexpr size_t RX_BUFFER_SIZE = 256;
+#endif
+    static constexpr size_t TX_FROM_ISR_BUFFER_SIZE = 32; //!< maximum length of a write_from_isr()
+#if defined(FRAMEWORK_TEST)
+    static constexpr size_t TX_BUFFER_SIZE = 256;
+    static constexpr size_t UART_FIFO_SIZE = 32; //!< size of the simulated UART receive FIFO
+#endif
 public:
     // negative pin means it is inverted
     struct port_pin_t {
@@ -133,8 +157,16 @@ public:
     SerialPort(const stm32_uart_pins_t& pins, uint8_t uart_index, uint32_t baudrate, uint8_t data_bits, uint8_t stop_bits, uint8_t parity);
     SerialPort(const uart_pins_t& pins, uint8_t uart_index, uint32_t baudrate, uint8_t data_bits, uint8_t stop_bits, uint8_t parity);
     SerialPort(SerialPortWatcherBase* watcher, const serial_pins_t& pins, uint8_t uart_index, uint32_t baudrate, uint8_t data_bits, uint8_t stop_bits, uint8_t parity);
+    ~SerialPort();
+#if defined(FRAMEWORK_LINUX)
+    //! `device` is the path of a tty or pty, eg "/dev/ttyAMA0", it must remain valid for the lifetime of the SerialPort.
+    SerialPort(const char* device, uint32_t baudrate, uint8_t data_bits, uint8_t stop_bits, uint8_t parity);
+    bool is_open() const { return _fd >= 0; }
+    void close();
+#endif
     void init();
     void uartInit();
+    void set_watcher(SerialPortWatcherBase* watcher) { _watcher = watcher; }
 private:
     // SerialPort is not copyable or moveable
     SerialPort(const SerialPort&) = delete;
@@ -144,33 +176,104 @@ private:
 public:
     int32_t WAIT_FOR_DATA_RECEIVED(uint32_t ticksToWait);
     bool on_data_received_from_isr(uint8_t data);
+    size_t on_data_received_from_isr(const uint8_t* data, size_t len, time_us32_t timestamp);
     bool is_data_available() const;
     uint8_t read_byte();
+    size_t read(uint8_t* buf, size_t max_len);
     size_t available_for_write();
     void write_byte(uint8_t data);
     size_t write(const uint8_t* buf, size_t len);
+    size_t write_from_isr(const uint8_t* buf, size_t len);
     uint32_t set_baudrate(uint32_t baudrate);
+    uint32_t get_baudrate() const { return _baudrate; }
+    uint32_t set_config(uint32_t baudrate, uint8_t data_bits, uint8_t stop_bits, uint8_t parity);
+    uint8_t get_data_bits() const { return _data_bits; }
+    uint8_t get_stop_bits() const { return _stop_bits; }
+    uint8_t get_parity() const { return _parity; }
+    //! Push a received byte into the receive ring buffer, called by the ISR when LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER is defined.
+    inline bool push_from_isr(uint8_t data) { set_receive_time_from_isr(time_us()); return _rx_buffer.push(data); }
+    //! Push a block of bytes, received at time `timestamp`, into the receive ring buffer, for FRAMEWORK_TEST this simulates data arriving at the UART.
+    inline size_t push_from_isr(const uint8_t* data, size_t len, time_us32_t timestamp) { set_receive_time_from_isr(timestamp); return _rx_buffer.write(data, len); }
+    inline size_t push_from_isr(const uint8_t* data, size_t len) { return push_from_isr(data, len, time_us()); }
+    time_us32_t get_receive_time_us() const;
+    size_t get_rx_buffer_available() const { return _rx_buffer.available(); }
+    /*!
+    Set the number of bytes that must be in the receive ring buffer before the ISR signals that data is ready,
+    typically the size of the protocol's frame. Only used if LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER is defined.
+    */
+    void set_data_ready_threshold(size_t data_ready_threshold) { _data_ready_threshold = data_ready_threshold == 0 ? 1 : data_ready_threshold; }
+    size_t get_data_ready_threshold() const { return _data_ready_threshold; }
+    uint32_t get_rx_overrun_count() const { return _rx_buffer.get_overrun_count(); }
+#if defined(FRAMEWORK_TEST)
+    //! For FRAMEWORK_TEST there is no UART, so written data is kept in a transmit ring buffer, from which it can be read back.
+    size_t read_transmitted(uint8_t* buf, size_t max_len) { return _tx_buffer.read(buf, max_len); }
+    //! For FRAMEWORK_TEST, simulate bytes arriving in the UART receive FIFO, they are read out by data_ready_isr().
+    size_t receive_into_uart_fifo(const uint8_t* data, size_t len) { return _uart_fifo.write(data, len); }
+    //! For FRAMEWORK_TEST, the number of times the ISR has signalled that data is ready.
+    uint32_t get_data_ready_signal_count() const { return _data_ready_signal_count; }
+#endif
 public:
-    static void data_ready_isr();
+    //! Returns the SerialPort using UART `uart_index`, or nullptr if there is none.
+    static SerialPort* get_instance(uint8_t uart_index) { return uart_index < UART_COUNT ? instances[uart_index] : nullptr; }
+    static void data_ready_isr(uint8_t uart_index);
+#if defined(FRAMEWORK_RPI_PICO) || defined(FRAMEWORK_ARDUINO_RPI_PICO)
+    static void uart0_irq_handler();
+    static void uart1_irq_handler();
+#endif
 #if defined(FRAMEWORK_STM32_CUBE) || defined(FRAMEWORK_ARDUINO_STM32)
     static void data_ready_isr(const UART_HandleTypeDef *huart);
+    static uint8_t get_uart_index(const USART_TypeDef* instance);
+#endif
+private:
+    void data_ready_from_isr();
+    /*!
+    Returns true if the receive ring buffer, which held `available_before` bytes before the ISR pushed to it, now holds
+    at least _data_ready_threshold bytes. So the ISR signals once when a frame's worth of data has arrived,
+    rather than on every byte or FIFO drain. Once the task has drained the buffer the next frame signals again.
+    */
+    inline bool data_ready_threshold_reached(size_t available_before) const {
+        return available_before < _data_ready_threshold && _rx_buffer.available() >= _data_ready_threshold;
+    }
+    /*!
+    Record the arrival time of the data the ISR is about to push into the receive ring buffer.
+    It is stored before the data is pushed, so by the time the task can read the data the time is visible too.
+    */
+    inline void set_receive_time_from_isr(time_us32_t timestamp) { _receive_time_us.store(timestamp, std::memory_order_relaxed); }
+private:
+#if defined(FRAMEWORK_LINUX)
+    bool set_termios(uint32_t baudrate);
 #endif
 private:
-    static SerialPort* self; //!< alias of `this` to be used in Interrupt Service Routine
+    /*!
+    The SerialPort using each UART, indexed by UART index, so that the Interrupt Service Routines can find their SerialPort in O(1).
+    Set when a SerialPort with a UART index is constructed, it is an error to construct two SerialPorts on the same UART.
+    */
+    static std::array<SerialPort*, UART_COUNT> instances;
     SerialPortWatcherBase* _watcher {nullptr};
     const serial_pins_t _pins {};
     const uint8_t _uart_index;
-    const uint8_t _data_bits;
-    const uint8_t _stop_bits;
-    const uint8_t _parity;
+    uint8_t _data_bits;
+    uint8_t _stop_bits;
+    uint8_t _parity;
     uint32_t _baudrate;
+    SpscRingBuffer<RX_BUFFER_SIZE> _rx_buffer {};
+    std::atomic<time_us32_t> _receive_time_us {0}; //!< arrival time of the newest data in the receive ring buffer, written by ISR only
+    size_t _data_ready_threshold {1};
 #if defined(FRAMEWORK_RPI_PICO) || defined(FRAMEWORK_ARDUINO_RPI_PICO)
     uart_inst_t* _uart {};
 #elif defined(FRAMEWORK_ESPIDF)
 #elif defined(FRAMEWORK_STM32_CUBE) || defined(FRAMEWORK_ARDUINO_STM32)
     UART_HandleTypeDef _uart {};
     uint8_t _rx_byte {};
+    std::array<uint8_t, TX_FROM_ISR_BUFFER_SIZE> _tx_from_isr_buffer {}; //!< data being sent by write_from_isr(), the HAL sends from it under interrupt
+#elif defined(FRAMEWORK_LINUX)
+    const char* _device {nullptr};
+    int _fd {-1};
+    int _epoll_fd {-1};
 #elif defined(FRAMEWORK_TEST)
+    SpscRingBuffer<TX_BUFFER_SIZE> _tx_buffer {};
+    SpscRingBuffer<UART_FIFO_SIZE> _uart_fifo {};
+    uint32_t _data_ready_signal_count {};
 #else // defaults to FRAMEWORK_ARDUINO
 #if defined(FRAMEWORK_ARDUINO_ESP32)
     HardwareSerial _uart;
@@ -179,24 +282,36 @@ private:
 
 #if defined(FRAMEWORK_USE_FREERTOS)
 
-    uint32_t _data_ready_queue_item {};
-    BaseType_t _data_ready_queue_higher_priority_task_woken = pdFALSE;
-    enum { DATA_READY_QUEUE_LENGTH = 1 };
-    std::array<uint8_t, DATA_READY_QUEUE_LENGTH * sizeof(_data_ready_queue_item)> _data_ready_queue_storage_area {};
-    StaticQueue_t _data_ready_queueStatic {};
-    QueueHandle_t _data_ready_queue {};
+    /*!
+    The task waiting for data is woken using a direct to task notification, which is lighter than a queue both in the ISR and in the task.
+    The task to notify is the one that last called WAIT_DATA_READY(), until a task has done so the ISR has no task to notify.
+    The ISR only signals once a complete valid packet has been parsed, or, if LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER is defined,
+    once the receive ring buffer holds a frame's worth of data (see set_data_ready_threshold()) or, on the RPI Pico,
+    when the line goes idle at the end of a burst. So in both modes the task is woken about once per frame.
+    */
+    std::atomic<TaskHandle_t> _data_ready_task {nullptr};
 public:
-    inline int32_t WAIT_DATA_READY(uint32_t ticksToWait) { return xQueueReceive(_data_ready_queue, &_data_ready_queue_item, ticksToWait); } // returns pdPASS(1) if queue read, pdFAIL(0) if timeout
+    inline int32_t WAIT_DATA_READY(uint32_t ticksToWait) { // returns pdPASS(1) if notified, pdFAIL(0) if timeout
+        _data_ready_task.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+        return ulTaskNotifyTake(pdTRUE, ticksToWait) > 0 ? pdPASS : pdFAIL;
+    }
     inline void SIGNAL_DATA_READY_FROM_ISR() {
-        _data_ready_queue_higher_priority_task_woken = pdFALSE;
-        xQueueOverwriteFromISR(_data_ready_queue, &_data_ready_queue_item, &_data_ready_queue_higher_priority_task_woken); 
-        portYIELD_FROM_ISR(_data_ready_queue_higher_priority_task_woken); // cppcheck-suppress cstyleCast
+        TaskHandle_t task = _data_ready_task.load(std::memory_order_acquire);
+        if (task != nullptr) {
+            BaseType_t higher_priority_task_woken = pdFALSE;
+            vTaskNotifyGiveFromISR(task, &higher_priority_task_woken);
+            portYIELD_FROM_ISR(higher_priority_task_woken); // cppcheck-suppress cstyleCast
+        }
     }
 #else
 
 public:
     inline int32_t WAIT_DATA_READY(uint32_t ticksToWait) { (void)ticksToWait; return 0; }
+#if defined(FRAMEWORK_TEST)
+    inline void SIGNAL_DATA_READY_FROM_ISR() { ++_data_ready_signal_count; }
+#else
     inline void SIGNAL_DATA_READY_FROM_ISR() {}
+#endif
 
 #endif // FRAMEWORK_USE_FREERTOS
 public:
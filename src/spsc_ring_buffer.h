@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+
+/*!
+Fixed capacity, wait-free, Single Producer Single Consumer (SPSC) byte ring buffer.
+
+The producer (typically a UART Interrupt Service Routine) only calls `push`.
+The consumer (typically the ReceiverTask) only calls `pop`, `read`, `available` and `empty`.
+
+The head index is written only by the producer and the tail index is written only by the consumer,
+so no read-modify-write atomic operations are needed. This means it is safe to use on cores
+without atomic RMW instructions (eg Cortex-M0+ on the RPI Pico).
+
+Indices are free running and wrap at 2^32, CAPACITY must be a power of 2.
+*/
+template <size_t CAPACITY>
+class SpscRingBuffer {
+public:
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of 2");
+    static_assert(CAPACITY <= 0x8000'0000U, "CAPACITY too large");
+    static constexpr size_t capacity() { return CAPACITY; }
+public:
+    /*!
+    Push a byte into the buffer. Called by the producer only.
+
+    Returns false, and increments the overrun count, if the buffer is full.
+    */
+    inline bool push(uint8_t data) {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        const uint32_t tail = _tail.load(std::memory_order_acquire);
+        if (head - tail >= CAPACITY) {
+            _overrun_count.store(_overrun_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        _buffer[head & MASK] = data;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    /*!
+    Push up to `len` bytes into the buffer. Called by the producer only.
+
+    Returns the number of bytes pushed, bytes that do not fit are dropped and counted as overruns.
+    */
+    inline size_t write(const uint8_t* data, size_t len) {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        const uint32_t tail = _tail.load(std::memory_order_acquire);
+        const size_t space = CAPACITY - (head - tail);
+        const size_t count = len < space ? len : space;
+        for (size_t ii = 0; ii < count; ++ii) {
+            _buffer[(head + ii) & MASK] = data[ii]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+        if (count < len) {
+            _overrun_count.store(_overrun_count.load(std::memory_order_relaxed) + static_cast<uint32_t>(len - count), std::memory_order_relaxed);
+        }
+        _head.store(head + static_cast<uint32_t>(count), std::memory_order_release);
+        return count;
+    }
+    /*!
+    Pop a byte from the buffer. Called by the consumer only.
+
+    Returns false if the buffer is empty.
+    */
+    inline bool pop(uint8_t& data) {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        const uint32_t head = _head.load(std::memory_order_acquire);
+        if (head == tail) {
+            return false;
+        }
+        data = _buffer[tail & MASK];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    /*!
+    Read up to `max_len` bytes into `buf`. Called by the consumer only.
+
+    Returns the number of bytes read.
+    */
+    inline size_t read(uint8_t* buf, size_t max_len) {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        const uint32_t head = _head.load(std::memory_order_acquire);
+        const size_t available = head - tail;
+        const size_t len = available < max_len ? available : max_len;
+        for (size_t ii = 0; ii < len; ++ii) {
+            buf[ii] = _buffer[(tail + ii) & MASK]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+        _tail.store(tail + static_cast<uint32_t>(len), std::memory_order_release);
+        return len;
+    }
+    //! Number of bytes available to the consumer.
+    inline size_t available() const { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed); }
+    inline bool empty() const { return available() == 0; }
+    //! Number of bytes dropped because the buffer was full.
+    inline uint32_t get_overrun_count() const { return _overrun_count.load(std::memory_order_relaxed); }
+    //! Discard any buffered data. Called by the consumer only.
+    inline void clear() { _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release); }
+private:
+    static constexpr uint32_t MASK = CAPACITY - 1;
+    std::atomic<uint32_t> _head {0}; //!< written by producer only
+    std::atomic<uint32_t> _tail {0}; //!< written by consumer only
+    std::atomic<uint32_t> _overrun_count {0}; //!< written by producer only
+    std::array<uint8_t, CAPACITY> _buffer {};
+};
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+
+/*!
+Unpacking of channels packed as consecutive 11-bit little endian values, as used by SBUS and CRSF.
+
+Channel k occupies bits [11k, 11k+11) of the data, so it starts at byte (11k)/8 with a bit offset of (11k)%8.
+Since 8 channels occupy exactly 11 bytes, the byte offsets and bit shifts repeat every 8 channels.
+
+Two implementations are provided:
+1. scalar: portable, each channel is extracted independently using a 32-bit window and a shift.
+   A single channel can be extracted with `unpack_11bit_channel`.
+2. vector: 8 channels at a time, using SSE2 (or SSSE3) on x86, or NEON on AArch64.
+   Only instruction sets that the native unit tests can run on are used, so each vector path is tested against the scalar one.
+   Each 16-bit lane holds the bytes at (11k)/8 and (11k)/8+1 (`lo`) and at (11k)/8+1 and (11k)/8+2 (`hi`),
+   and the channel is `((lo >> shift) | (hi << (8 - shift))) & 0x7FF`.
+
+`unpack_11bit_channels` uses the vector implementation if one is available for the target, otherwise the scalar one.
+*/
+namespace channels_11bit {
+
+static constexpr uint16_t MASK = 0x07FF;
+static constexpr size_t GROUP_CHANNEL_COUNT = 8;
+static constexpr size_t GROUP_BYTE_COUNT = 11;
+
+static constexpr size_t byte_offset(size_t channel) { return (channel * 11) / 8; }
+static constexpr unsigned shift(size_t channel) { return static_cast<unsigned>((channel * 11) % 8); }
+
+//! Number of bytes used by `N` packed 11-bit channels.
+static constexpr size_t byte_count(size_t channel_count) { return (channel_count * 11 + 7) / 8; }
+
+} // namespace channels_11bit
+
+
+/*!
+Unpack the single 11-bit channel `index` from `data`.
+*/
+inline uint16_t unpack_11bit_channel(const uint8_t* data, size_t index)
+{
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const size_t offset = channels_11bit::byte_offset(index);
+    // a channel spans at most 3 bytes, the 3rd byte is only read if the channel needs it, so there is no overread
+    uint32_t window = data[offset] | static_cast<uint32_t>(data[offset + 1] << 8U);
+    if (channels_11bit::shift(index) > 5) {
+        window |= static_cast<uint32_t>(data[offset + 2] << 16U);
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return static_cast<uint16_t>((window >> channels_11bit::shift(index)) & channels_11bit::MASK);
+}
+
+/*!
+Portable scalar unpacking of `N` 11-bit channels from `data` into `channels`.
+*/
+template <size_t N>
+inline void unpack_11bit_channels_scalar(uint16_t* channels, const uint8_t* data)
+{
+    for (size_t ii = 0; ii < N; ++ii) {
+        channels[ii] = unpack_11bit_channel(data, ii); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+}
+
+#if defined(__SSE2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+#define LIBRARY_RECEIVER_UNPACK_11BIT_CHANNELS_VECTOR
+
+/*!
+Vector unpacking of `N` 11-bit channels from `data` into `channels`, 8 channels at a time.
+
+Any remaining channels (if `N` is not a multiple of 8) are unpacked using the scalar implementation.
+*/
+template <size_t N>
+inline void unpack_11bit_channels_vector(uint16_t* channels, const uint8_t* data) // NOLINT(readability-function-cognitive-complexity)
+{
+    using namespace channels_11bit;
+    static constexpr size_t GROUP_COUNT = N / GROUP_CHANNEL_COUNT;
+
+    // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic,cppcoreguidelines-pro-bounds-constant-array-index)
+    for (size_t group = 0; group < GROUP_COUNT; ++group) {
+        const uint8_t* const in = data + group*GROUP_BYTE_COUNT;
+        uint16_t* const out = channels + group*GROUP_CHANNEL_COUNT;
+#if defined(__SSSE3__) || (defined(__ARM_NEON) && defined(__aarch64__))
+        // 16-byte loads must not read past the end of the data, so the last group may be loaded from an earlier address,
+        // in which case the byte shuffle indices are offset to compensate
+        static constexpr size_t BYTE_COUNT = byte_count(N);
+        std::array<uint8_t, 16> buf {};
+        const uint8_t* load_address = in;
+        uint8_t index_offset = 0;
+        if constexpr (BYTE_COUNT < 16) {
+            memcpy(&buf[0], in, BYTE_COUNT - group*GROUP_BYTE_COUNT);
+            load_address = &buf[0];
+        } else if (group*GROUP_BYTE_COUNT + 16 > BYTE_COUNT) {
+            load_address = data + BYTE_COUNT - 16;
+            index_offset = static_cast<uint8_t>(group*GROUP_BYTE_COUNT + 16 - BYTE_COUNT);
+        }
+#endif
+#if defined(__SSE2__)
+#if defined(__SSSE3__)
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(load_address));
+        const __m128i offset = _mm_set1_epi8(static_cast<char>(index_offset));
+        const __m128i lo = _mm_shuffle_epi8(bytes, _mm_add_epi8(offset, _mm_setr_epi8(0,1, 1,2, 2,3, 4,5, 5,6, 6,7, 8,9, 9,10)));
+        // the high byte of the last lane is not needed, and reading it could read past the end of the data
+        const __m128i hi = _mm_shuffle_epi8(bytes, _mm_add_epi8(offset, _mm_setr_epi8(1,2, 2,3, 3,4, 5,6, 6,7, 7,8, 9,10, 10,10)));
+#else
+        // no byte shuffle, so gather the 16-bit lanes using scalar loads
+        const auto word = [in](size_t index) { return static_cast<int16_t>(in[index] | (in[index + 1] << 8U)); };
+        const __m128i lo = _mm_setr_epi16(word(0), word(1), word(2), word(4), word(5), word(6), word(8), word(9));
+        // the high byte of the last lane is not needed, and reading it could read past the end of the data
+        const __m128i hi = _mm_setr_epi16(word(1), word(2), word(3), word(5), word(6), word(7), word(9), in[10]);
+#endif
+        // SSE2 has no per-lane shifts, so use multiplies:
+        // lo >> s is the high half of lo * 2^(16-s) for s > 0, and the low half of lo * 1 for s == 0
+        // hi << (8-s) is the low half of hi * 2^(8-s)
+        // shifts are { 0, 3, 6, 1, 4, 7, 2, 5 }
+        const __m128i lo_shifted = _mm_or_si128(
+            _mm_mulhi_epu16(lo, _mm_setr_epi16(0, 1<<13, 1<<10, static_cast<int16_t>(1U<<15U), 1<<12, 1<<9, 1<<14, 1<<11)),
+            _mm_mullo_epi16(lo, _mm_setr_epi16(1, 0, 0, 0, 0, 0, 0, 0)));
+        const __m128i hi_shifted = _mm_mullo_epi16(hi, _mm_setr_epi16(1<<8, 1<<5, 1<<2, 1<<7, 1<<4, 1<<1, 1<<6, 1<<3));
+        const __m128i result = _mm_and_si128(_mm_or_si128(lo_shifted, hi_shifted), _mm_set1_epi16(static_cast<int16_t>(MASK)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), result);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        const uint8x16_t bytes = vld1q_u8(load_address);
+        static constexpr std::array<uint8_t, 16> LO_INDEX { 0,1, 1,2, 2,3, 4,5, 5,6, 6,7, 8,9, 9,10 };
+        static constexpr std::array<uint8_t, 16> HI_INDEX { 1,2, 2,3, 3,4, 5,6, 6,7, 7,8, 9,10, 10,10 };
+        const uint8x16_t offset = vdupq_n_u8(index_offset);
+        const uint16x8_t lo = vreinterpretq_u16_u8(vqtbl1q_u8(bytes, vaddq_u8(offset, vld1q_u8(&LO_INDEX[0]))));
+        const uint16x8_t hi = vreinterpretq_u16_u8(vqtbl1q_u8(bytes, vaddq_u8(offset, vld1q_u8(&HI_INDEX[0]))));
+        // NEON shifts left by a signed per-lane amount, so negative values shift right
+        static constexpr std::array<int16_t, 8> LO_SHIFT { 0, -3, -6, -1, -4, -7, -2, -5 };
+        static constexpr std::array<int16_t, 8> HI_SHIFT { 8, 5, 2, 7, 4, 1, 6, 3 };
+        const uint16x8_t result = vandq_u16(
+            vorrq_u16(vshlq_u16(lo, vld1q_s16(&LO_SHIFT[0])), vshlq_u16(hi, vld1q_s16(&HI_SHIFT[0]))),
+            vdupq_n_u16(MASK));
+        vst1q_u16(out, result);
+#endif
+    }
+    if constexpr (N % GROUP_CHANNEL_COUNT != 0) {
+        // remaining channels, the scalar implementation works on any group of 8 channels, since the bit pattern repeats
+        unpack_11bit_channels_scalar<N % GROUP_CHANNEL_COUNT>(channels + GROUP_COUNT*GROUP_CHANNEL_COUNT, data + GROUP_COUNT*GROUP_BYTE_COUNT);
+    }
+    // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic,cppcoreguidelines-pro-bounds-constant-array-index)
+}
+#endif
+
+/*!
+Unpack `N` 11-bit channels from `data` into `channels`, using the vector implementation if available.
+
+`data` must contain at least channels_11bit::byte_count(N) bytes.
+*/
+template <size_t N>
+inline void unpack_11bit_channels(uint16_t* channels, const uint8_t* data)
+{
+#if defined(LIBRARY_RECEIVER_UNPACK_11BIT_CHANNELS_VECTOR)
+    unpack_11bit_channels_vector<N>(channels, data);
+#else
+    unpack_11bit_channels_scalar<N>(channels, data);
+#endif
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "receiver_crsf.h"
+
+/*!
+CRSF packets shared by the native unit tests.
+*/
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+/*!
+Returns a RC channels packet with all 16 channels set to the raw 11-bit `value`, eg 992 maps to 1500.
+The packet is 26 bytes: sync, length, type, 22 bytes of channel data, and CRC.
+*/
+inline ReceiverCrsf::packet_u crsf_rc_channels_packet(uint16_t value)
+{
+    ReceiverCrsf::packet_u packet {};
+    packet.value.sync = ReceiverCrsf::CRSF_SYNC_BYTE;
+    packet.value.length = 24; // type + 22 bytes of channel data + CRC
+    packet.value.type = ReceiverCrsf::FRAMETYPE_RC_CHANNELS_PACKED;
+    size_t bit_index = 0;
+    for (size_t channel = 0; channel < 16; ++channel) {
+        for (size_t ii = 0; ii < 11; ++ii) {
+            if (value & (1U << ii)) {
+                packet.value.payload[bit_index / 8] |= static_cast<uint8_t>(1U << (bit_index % 8));
+            }
+            ++bit_index;
+        }
+    }
+    packet.value.payload[22] = ReceiverCrsf::calculate_crc(packet);
+    return packet;
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
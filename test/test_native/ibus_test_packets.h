@@ -0,0 +1,50 @@
+#pragma once
+
+#include "receiver_ibus.h"
+
+#include <algorithm>
+#include <array>
+
+/*!
+IBUS packets shared by the native unit tests.
+*/
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+/*!
+Returns a 32 byte IBUS packet with the 18 `channels` and a valid checksum.
+Channels 0 to 13 fill the 14 slots, channels 14 to 17 are stored in the upper 4 bits of 3 consecutive slots.
+*/
+inline std::array<uint8_t, 32> ibus_packet(const std::array<uint16_t, 18>& channels)
+{
+    std::array<uint8_t, 32> packet {};
+    packet[0] = ReceiverIbus::SERIAL_RX_PACKET_LENGTH;
+    packet[1] = 0x40;
+    for (size_t ii = 0; ii < ReceiverIbus::SLOT_COUNT; ++ii) {
+        packet[2 + 2*ii] = static_cast<uint8_t>(channels[ii] & 0xFFU);
+        packet[3 + 2*ii] = static_cast<uint8_t>((channels[ii] >> 8U) & 0x0FU);
+    }
+    for (size_t ii = ReceiverIbus::SLOT_COUNT; ii < 18; ++ii) {
+        const size_t offset = 3 + 6*(ii - ReceiverIbus::SLOT_COUNT);
+        packet[offset] |= static_cast<uint8_t>((channels[ii] & 0x00FU) << 4U);
+        packet[offset + 2] |= static_cast<uint8_t>(channels[ii] & 0x0F0U);
+        packet[offset + 4] |= static_cast<uint8_t>((channels[ii] & 0xF00U) >> 4U);
+    }
+    uint16_t checksum = 0xFFFF;
+    for (size_t ii = 2; ii < 30; ii += 2) {
+        checksum = static_cast<uint16_t>(checksum + packet[ii] + (packet[ii + 1] << 8U));
+    }
+    packet[30] = static_cast<uint8_t>(checksum & 0xFFU);
+    packet[31] = static_cast<uint8_t>(checksum >> 8U);
+    return packet;
+}
+
+/*!
+Returns a 32 byte IBUS packet with the 14 slot channels set to `value` and channels 14 to 17 set to zero.
+*/
+inline std::array<uint8_t, 32> ibus_packet(uint16_t value)
+{
+    std::array<uint16_t, 18> channels {};
+    std::fill_n(channels.begin(), ReceiverIbus::SLOT_COUNT, value);
+    return ibus_packet(channels);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "receiver_sbus.h"
+
+#include <array>
+
+/*!
+SBUS packets shared by the native unit tests.
+*/
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+/*!
+Returns a 25 byte SBUS packet with the 16 raw 11-bit `channels` and the given `flags` byte, eg 192 maps to 1000, 992 maps to 1500.
+*/
+inline std::array<uint8_t, 25> sbus_packet(const std::array<uint16_t, 16>& channels, uint8_t flags = 0)
+{
+    std::array<uint8_t, 25> packet {};
+    packet[0] = ReceiverSbus::SBUS_START_BYTE;
+    size_t bit_index = 0;
+    for (uint16_t channel : channels) {
+        for (size_t ii = 0; ii < 11; ++ii) {
+            if (channel & (1U << ii)) {
+                packet[1 + bit_index / 8] |= static_cast<uint8_t>(1U << (bit_index % 8));
+            }
+            ++bit_index;
+        }
+    }
+    packet[23] = flags;
+    packet[24] = ReceiverSbus::SBUS_END_BYTE;
+    return packet;
+}
+
+/*!
+Returns a 25 byte SBUS packet with all 16 channels set to the raw 11-bit `value`.
+*/
+inline std::array<uint8_t, 25> sbus_packet(uint16_t value)
+{
+    std::array<uint16_t, 16> channels {};
+    channels.fill(value);
+    return sbus_packet(channels);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
@@ -0,0 +1,222 @@
+#include "ibus_sensor_responder.h"
+
+#include <unity.h>
+#include <vector>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-magic-numbers)
+static std::array<uint8_t, 4> poll(uint8_t command, uint8_t address)
+{
+    std::array<uint8_t, 4> data { 0x04, static_cast<uint8_t>(command | address), 0, 0 };
+    const uint16_t checksum = IbusSensorResponder::calculate_checksum(&data[0], 2);
+    data[2] = static_cast<uint8_t>(checksum & 0xFFU);
+    data[3] = static_cast<uint8_t>(checksum >> 8U);
+    return data;
+}
+
+//! Replay a poll from the receiver, as it arrives at the serial port, and return the reply sent.
+static std::vector<uint8_t> replay(SerialPort& serialPort, IbusSensorResponder& responder, const std::array<uint8_t, 4>& data, time_us32_t time)
+{
+    serialPort.push_from_isr(&data[0], data.size());
+    responder.update(time);
+    std::array<uint8_t, 16> reply {};
+    const size_t len = serialPort.read_transmitted(&reply[0], reply.size());
+    return std::vector<uint8_t>(reply.begin(), reply.begin() + static_cast<std::ptrdiff_t>(len));
+}
+
+void test_ibus_sensor_responder_checksum()
+{
+    // discover poll for sensor 1, as sent by a Flysky receiver
+    const std::array<uint8_t, 4> data { 0x04, 0x81, 0x7A, 0xFF };
+    TEST_ASSERT_EQUAL_HEX16(0xFF7A, IbusSensorResponder::calculate_checksum(&data[0], 2));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&data[0], &poll(IbusSensorResponder::COMMAND_DISCOVER, 1)[0], 4);
+}
+
+void test_ibus_sensor_responder_poll_sequence()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 115200, SerialPort::DATA_BITS_8, SerialPort::STOP_BITS_1, SerialPort::PARITY_NONE);
+    static IbusSensorResponder responder(serialPort);
+    responder.set_half_duplex(false);
+
+    TEST_ASSERT_EQUAL(1, responder.add_sensor(IbusSensorResponder::SENSOR_TYPE_TEMPERATURE));
+    TEST_ASSERT_EQUAL(2, responder.add_sensor(IbusSensorResponder::SENSOR_TYPE_EXTERNAL_VOLTAGE));
+    TEST_ASSERT_EQUAL(2, responder.get_sensor_count());
+    responder.set_sensor_value(1, 500); // 10.0C
+    responder.set_sensor_value(2, 1260); // 12.60V
+
+    time_us32_t time = 0;
+    // on power up the receiver discovers the sensors, stopping at the first address that does not reply
+    std::vector<uint8_t> reply = replay(serialPort, responder, poll(IbusSensorResponder::COMMAND_DISCOVER, 1), time);
+    TEST_ASSERT_EQUAL(4, reply.size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&poll(IbusSensorResponder::COMMAND_DISCOVER, 1)[0], &reply[0], 4);
+    time += 7000;
+    reply = replay(serialPort, responder, poll(IbusSensorResponder::COMMAND_GET_TYPE, 1), time);
+    const std::array<uint8_t, 6> type_reply_1 { 0x06, 0x91, 0x01, 0x02, 0x65, 0xFF };
+    TEST_ASSERT_EQUAL(6, reply.size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&type_reply_1[0], &reply[0], 6);
+    time += 7000;
+    reply = replay(serialPort, responder, poll(IbusSensorResponder::COMMAND_DISCOVER, 2), time);
+    TEST_ASSERT_EQUAL(4, reply.size());
+    time += 7000;
+    reply = replay(serialPort, responder, poll(IbusSensorResponder::COMMAND_GET_TYPE, 2), time);
+    const std::array<uint8_t, 6> type_reply_2 { 0x06, 0x92, 0x03, 0x02, 0x62, 0xFF };
+    TEST_ASSERT_EQUAL(6, reply.size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&type_reply_2[0], &reply[0], 6);
+    time += 7000;
+    reply = replay(serialPort, responder, poll(IbusSensorResponder::COMMAND_DISCOVER, 3), time);
+    TEST_ASSERT_EQUAL(0, reply.size());
+
+    // then it polls the measurements in turn
+    const std::array<uint8_t, 6> measurement_reply_1 { 0x06, 0xA1, 0xF4, 0x01, 0x63, 0xFE };
+    const std::array<uint8_t, 6> measurement_reply_2 { 0x06, 0xA2, 0xEC, 0x04, 0x67, 0xFE };
+    for (int ii = 0; ii < 3; ++ii) {
+        time += 7000;
+        reply = replay(serialPort, responder, poll(IbusSensorResponder::COMMAND_GET_MEASUREMENT, 1), time);
+        TEST_ASSERT_EQUAL(6, reply.size());
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(&measurement_reply_1[0], &reply[0], 6);
+        time += 7000;
+        reply = replay(serialPort, responder, poll(IbusSensorResponder::COMMAND_GET_MEASUREMENT, 2), time);
+        TEST_ASSERT_EQUAL(6, reply.size());
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(&measurement_reply_2[0], &reply[0], 6);
+    }
+    TEST_ASSERT_EQUAL(11, responder.get_poll_count());
+    TEST_ASSERT_EQUAL(10, responder.get_reply_count());
+    TEST_ASSERT_EQUAL(0, responder.get_error_count());
+}
+
+void test_ibus_sensor_responder_set_value()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 115200, SerialPort::DATA_BITS_8, SerialPort::STOP_BITS_1, SerialPort::PARITY_NONE);
+    static IbusSensorResponder responder(serialPort);
+    responder.set_half_duplex(false);
+
+    TEST_ASSERT_EQUAL(1, responder.add_sensor(IbusSensorResponder::SENSOR_TYPE_ALTITUDE));
+    TEST_ASSERT_EQUAL(2, responder.add_sensor(IbusSensorResponder::SENSOR_TYPE_CELL));
+
+    time_us32_t time = 0;
+    std::vector<uint8_t> reply = replay(serialPort, responder, poll(IbusSensorResponder::COMMAND_GET_TYPE, 1), time);
+    TEST_ASSERT_EQUAL(6, reply.size());
+    TEST_ASSERT_EQUAL(IbusSensorResponder::SENSOR_TYPE_ALTITUDE, reply[2]);
+    TEST_ASSERT_EQUAL(4, reply[3]);
+
+    // replies are always checksum ready, whatever the value
+    const std::array<int32_t, 5> values { 0, 1, -1, 12345678, -30000 };
+    for (int32_t value : values) {
+        responder.set_sensor_value(1, value);
+        responder.set_sensor_value(2, value);
+        time += 7000;
+        reply = replay(serialPort, responder, poll(IbusSensorResponder::COMMAND_GET_MEASUREMENT, 1), time);
+        TEST_ASSERT_EQUAL(8, reply.size());
+        TEST_ASSERT_EQUAL(8, reply[0]);
+        TEST_ASSERT_EQUAL_HEX8(0xA1, reply[1]);
+        const uint32_t received = reply[2] | (reply[3] << 8U) | (reply[4] << 16U) | (static_cast<uint32_t>(reply[5]) << 24U);
+        TEST_ASSERT_EQUAL_INT32(value, static_cast<int32_t>(received));
+        TEST_ASSERT_EQUAL_HEX16(IbusSensorResponder::calculate_checksum(&reply[0], 6), reply[6] | (reply[7] << 8U));
+
+        time += 7000;
+        reply = replay(serialPort, responder, poll(IbusSensorResponder::COMMAND_GET_MEASUREMENT, 2), time);
+        TEST_ASSERT_EQUAL(6, reply.size());
+        TEST_ASSERT_EQUAL(static_cast<int16_t>(value), static_cast<int16_t>(reply[2] | (reply[3] << 8U)));
+        TEST_ASSERT_EQUAL_HEX16(IbusSensorResponder::calculate_checksum(&reply[0], 4), reply[4] | (reply[5] << 8U));
+    }
+
+    // out of range addresses are ignored
+    responder.set_sensor_value(0, 1);
+    responder.set_sensor_value(3, 1);
+}
+
+void test_ibus_sensor_responder_table_full()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 115200, SerialPort::DATA_BITS_8, SerialPort::STOP_BITS_1, SerialPort::PARITY_NONE);
+    // addresses 1 to 3 are used by other sensors on the bus
+    static IbusSensorResponder responder(serialPort, 4);
+
+    for (uint8_t address = 4; address <= 15; ++address) {
+        TEST_ASSERT_EQUAL(address, responder.add_sensor(IbusSensorResponder::SENSOR_TYPE_RPM));
+    }
+    TEST_ASSERT_EQUAL(0, responder.add_sensor(IbusSensorResponder::SENSOR_TYPE_RPM));
+    TEST_ASSERT_EQUAL(12, responder.get_sensor_count());
+
+    std::vector<uint8_t> reply = replay(serialPort, responder, poll(IbusSensorResponder::COMMAND_DISCOVER, 3), 0);
+    TEST_ASSERT_EQUAL(0, reply.size());
+    reply = replay(serialPort, responder, poll(IbusSensorResponder::COMMAND_DISCOVER, 4), 7000);
+    TEST_ASSERT_EQUAL(4, reply.size());
+}
+
+void test_ibus_sensor_responder_half_duplex()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 115200, SerialPort::DATA_BITS_8, SerialPort::STOP_BITS_1, SerialPort::PARITY_NONE);
+    static IbusSensorResponder responder(serialPort);
+    TEST_ASSERT_EQUAL(1, responder.add_sensor(IbusSensorResponder::SENSOR_TYPE_FUEL));
+
+    // the discover reply is identical to the poll, so on a single wire bus it must not be taken as another poll
+    const std::array<uint8_t, 4> discover = poll(IbusSensorResponder::COMMAND_DISCOVER, 1);
+    std::vector<uint8_t> reply = replay(serialPort, responder, discover, 0);
+    TEST_ASSERT_EQUAL(4, reply.size());
+    serialPort.push_from_isr(&reply[0], reply.size());
+    TEST_ASSERT_EQUAL(0, responder.update(400));
+    TEST_ASSERT_EQUAL(1, responder.get_poll_count());
+
+    reply = replay(serialPort, responder, poll(IbusSensorResponder::COMMAND_GET_MEASUREMENT, 1), 7000);
+    TEST_ASSERT_EQUAL(6, reply.size());
+    serialPort.push_from_isr(&reply[0], reply.size());
+    TEST_ASSERT_EQUAL(0, responder.update(7500));
+
+    // if the echo is not received the next poll, after a gap, is still answered
+    reply = replay(serialPort, responder, poll(IbusSensorResponder::COMMAND_GET_MEASUREMENT, 1), 14000);
+    TEST_ASSERT_EQUAL(6, reply.size());
+    reply = replay(serialPort, responder, poll(IbusSensorResponder::COMMAND_GET_MEASUREMENT, 1), 21000);
+    TEST_ASSERT_EQUAL(6, reply.size());
+    TEST_ASSERT_EQUAL(4, responder.get_poll_count());
+    TEST_ASSERT_EQUAL(4, responder.get_reply_count());
+}
+
+void test_ibus_sensor_responder_bad_poll()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 115200, SerialPort::DATA_BITS_8, SerialPort::STOP_BITS_1, SerialPort::PARITY_NONE);
+    static IbusSensorResponder responder(serialPort);
+    responder.set_half_duplex(false);
+    TEST_ASSERT_EQUAL(1, responder.add_sensor(IbusSensorResponder::SENSOR_TYPE_FUEL));
+
+    // bad checksum
+    std::array<uint8_t, 4> data = poll(IbusSensorResponder::COMMAND_GET_MEASUREMENT, 1);
+    data[2] ^= 0x01;
+    std::vector<uint8_t> reply = replay(serialPort, responder, data, 0);
+    TEST_ASSERT_EQUAL(0, reply.size());
+    TEST_ASSERT_EQUAL(1, responder.get_error_count());
+
+    // partial poll, the rest of which is lost, followed by a complete poll after a gap
+    data = poll(IbusSensorResponder::COMMAND_GET_MEASUREMENT, 1);
+    serialPort.push_from_isr(&data[0], 2);
+    TEST_ASSERT_EQUAL(0, responder.update(7000));
+    reply = replay(serialPort, responder, data, 14000);
+    TEST_ASSERT_EQUAL(6, reply.size());
+
+    // unknown command
+    reply = replay(serialPort, responder, poll(0xC0, 1), 21000);
+    TEST_ASSERT_EQUAL(0, reply.size());
+    TEST_ASSERT_EQUAL(1, responder.get_error_count());
+    TEST_ASSERT_EQUAL(2, responder.get_poll_count());
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_ibus_sensor_responder_checksum);
+    RUN_TEST(test_ibus_sensor_responder_poll_sequence);
+    RUN_TEST(test_ibus_sensor_responder_set_value);
+    RUN_TEST(test_ibus_sensor_responder_table_full);
+    RUN_TEST(test_ibus_sensor_responder_half_duplex);
+    RUN_TEST(test_ibus_sensor_responder_bad_poll);
+
+    UNITY_END();
+}
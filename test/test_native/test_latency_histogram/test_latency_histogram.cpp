@@ -0,0 +1,180 @@
+#include "latency_histogram.h"
+#include "receiver_telemetry.h"
+#include "receiver_telemetry_data.h"
+#include "receiver_virtual.h"
+
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-magic-numbers)
+typedef LatencyHistogram<> histogram_t;
+
+void test_latency_histogram_buckets()
+{
+    static_assert(histogram_t::SUB_BUCKET_COUNT == 16);
+    static_assert(histogram_t::BUCKET_COUNT == 272);
+    static_assert(histogram_t::MAX_VALUE == 1048575);
+
+    // small values each have their own bucket
+    for (uint32_t value = 0; value < 2 * histogram_t::SUB_BUCKET_COUNT; ++value) {
+        TEST_ASSERT_EQUAL(value, histogram_t::bucket_index(value));
+        TEST_ASSERT_EQUAL(value, histogram_t::bucket_lowest_value(value));
+        TEST_ASSERT_EQUAL(value, histogram_t::bucket_highest_value(value));
+    }
+    TEST_ASSERT_EQUAL(32, histogram_t::bucket_index(32));
+    TEST_ASSERT_EQUAL(32, histogram_t::bucket_index(33));
+    TEST_ASSERT_EQUAL(33, histogram_t::bucket_index(34));
+    TEST_ASSERT_EQUAL(histogram_t::BUCKET_COUNT - 1, histogram_t::bucket_index(histogram_t::MAX_VALUE));
+    TEST_ASSERT_EQUAL(histogram_t::BUCKET_COUNT - 1, histogram_t::bucket_index(UINT32_MAX));
+
+    // the buckets are contiguous and cover the whole range
+    TEST_ASSERT_EQUAL(0, histogram_t::bucket_lowest_value(0));
+    for (size_t index = 0; index < histogram_t::BUCKET_COUNT; ++index) {
+        TEST_ASSERT_EQUAL(index, histogram_t::bucket_index(histogram_t::bucket_lowest_value(index)));
+        TEST_ASSERT_EQUAL(index, histogram_t::bucket_index(histogram_t::bucket_highest_value(index)));
+        if (index + 1 < histogram_t::BUCKET_COUNT) {
+            TEST_ASSERT_EQUAL(histogram_t::bucket_highest_value(index) + 1, histogram_t::bucket_lowest_value(index + 1));
+        }
+    }
+    TEST_ASSERT_EQUAL(histogram_t::MAX_VALUE, histogram_t::bucket_highest_value(histogram_t::BUCKET_COUNT - 1));
+}
+
+void test_latency_histogram_bucket_accuracy()
+{
+    // every value is in a bucket no wider than 1/16 of the value
+    for (uint32_t value = 0; value <= histogram_t::MAX_VALUE; ++value) {
+        const size_t index = histogram_t::bucket_index(value);
+        const uint32_t lowest = histogram_t::bucket_lowest_value(index);
+        const uint32_t highest = histogram_t::bucket_highest_value(index);
+        if (value < lowest || value > highest || (highest - lowest) * histogram_t::SUB_BUCKET_COUNT > value) {
+            TEST_FAIL_MESSAGE("value not in an accurate bucket");
+        }
+    }
+    // a coarser histogram, with 8 sub-buckets, to 2^16
+    typedef LatencyHistogram<3, 16> coarse_t;
+    static_assert(coarse_t::BUCKET_COUNT == 112);
+    for (uint32_t value = 0; value <= coarse_t::MAX_VALUE; ++value) {
+        const size_t index = coarse_t::bucket_index(value);
+        if (value < coarse_t::bucket_lowest_value(index) || value > coarse_t::bucket_highest_value(index)
+                || (coarse_t::bucket_highest_value(index) - coarse_t::bucket_lowest_value(index)) * coarse_t::SUB_BUCKET_COUNT > value) {
+            TEST_FAIL_MESSAGE("value not in an accurate bucket");
+        }
+    }
+}
+
+void test_latency_histogram_percentiles()
+{
+    static histogram_t histogram;
+    histogram_t::snapshot_t snapshot {};
+    TEST_ASSERT_TRUE(histogram.snapshot(snapshot));
+    TEST_ASSERT_EQUAL(0, snapshot.count);
+    TEST_ASSERT_EQUAL(0, snapshot.value_at_percentile(50));
+    TEST_ASSERT_EQUAL(0, snapshot.mean());
+
+    for (uint32_t value = 1; value <= 1000; ++value) {
+        histogram.record(value);
+    }
+    TEST_ASSERT_EQUAL(1000, histogram.get_count());
+    TEST_ASSERT_TRUE(histogram.snapshot(snapshot));
+    TEST_ASSERT_EQUAL(1000, snapshot.count);
+    TEST_ASSERT_EQUAL(1, snapshot.min);
+    TEST_ASSERT_EQUAL(1000, snapshot.max);
+    TEST_ASSERT_EQUAL(500, snapshot.mean());
+    TEST_ASSERT_EQUAL(1, snapshot.value_at_percentile(0));
+    TEST_ASSERT_EQUAL(1000, snapshot.value_at_percentile(100));
+    // percentiles are never below the true value, and at most one bucket width above it
+    const std::array<uint32_t, 6> per_milles { 10, 250, 500, 900, 990, 999 };
+    for (uint32_t per_mille : per_milles) {
+        const uint32_t value = snapshot.value_at_per_mille(per_mille);
+        TEST_ASSERT_GREATER_OR_EQUAL(per_mille, value);
+        TEST_ASSERT_LESS_OR_EQUAL(per_mille + per_mille / histogram_t::SUB_BUCKET_COUNT, value);
+    }
+    TEST_ASSERT_EQUAL(snapshot.value_at_per_mille(500), snapshot.value_at_percentile(50));
+
+    // values above the maximum go into the last bucket, but the true maximum is kept
+    histogram.record(5'000'000);
+    TEST_ASSERT_TRUE(histogram.snapshot(snapshot));
+    TEST_ASSERT_EQUAL(1, snapshot.counts[histogram_t::BUCKET_COUNT - 1]);
+    TEST_ASSERT_EQUAL(5'000'000, snapshot.max);
+    TEST_ASSERT_EQUAL(5'000'000, snapshot.value_at_percentile(100));
+
+    histogram.reset();
+    TEST_ASSERT_TRUE(histogram.snapshot(snapshot));
+    TEST_ASSERT_EQUAL(0, snapshot.count);
+    TEST_ASSERT_EQUAL(UINT32_MAX, snapshot.min);
+    TEST_ASSERT_EQUAL(0, snapshot.counts[histogram_t::BUCKET_COUNT - 1]);
+}
+
+void test_latency_histogram_bimodal()
+{
+    // frames mostly arrive 4ms apart, with the occasional late one
+    static histogram_t histogram;
+    for (int ii = 0; ii < 980; ++ii) {
+        histogram.record(4000);
+    }
+    for (int ii = 0; ii < 20; ++ii) {
+        histogram.record(12000);
+    }
+    histogram_t::snapshot_t snapshot {};
+    TEST_ASSERT_TRUE(histogram.snapshot(snapshot));
+    TEST_ASSERT_EQUAL(4000, snapshot.min);
+    TEST_ASSERT_EQUAL(4095, snapshot.value_at_percentile(50)); // highest value of the bucket [3968, 4095]
+    TEST_ASSERT_EQUAL(4095, snapshot.value_at_percentile(98));
+    TEST_ASSERT_EQUAL(12000, snapshot.value_at_percentile(99));
+}
+
+#if defined(LIBRARY_RECEIVER_USE_LATENCY_HISTOGRAMS)
+void test_receiver_latency_histograms()
+{
+    static ReceiverVirtual receiver;
+
+    // the stub time_us() used by the native tests is constant, so the frame time set by update() is that time
+    time_us32_t task_time = time_us() + 100;
+    for (int ii = 0; ii < 10; ++ii) {
+        TEST_ASSERT_TRUE(receiver.update(0));
+        receiver.record_latencies(task_time, task_time + 20);
+    }
+    histogram_t::snapshot_t snapshot {};
+    TEST_ASSERT_TRUE(receiver.get_latency_histogram(ReceiverBase::LATENCY_PUBLISH_TO_TASK).snapshot(snapshot));
+    TEST_ASSERT_EQUAL(10, snapshot.count);
+    TEST_ASSERT_TRUE(receiver.get_latency_histogram(ReceiverBase::LATENCY_TASK_TO_CONTROLS).snapshot(snapshot));
+    TEST_ASSERT_EQUAL(20, snapshot.max);
+    TEST_ASSERT_TRUE(receiver.get_latency_histogram(ReceiverBase::LATENCY_FRAME_INTERVAL).snapshot(snapshot));
+    TEST_ASSERT_EQUAL(9, snapshot.count); // no interval for the first frame
+
+    std::array<uint8_t, sizeof(TD_RECEIVER_LATENCY)> buffer {};
+    TEST_ASSERT_EQUAL(sizeof(TD_RECEIVER_LATENCY), pack_telemetry_data_receiver_latency(&buffer[0], 7, 3, receiver));
+    const auto* td = reinterpret_cast<const TD_RECEIVER_LATENCY*>(&buffer[0]);
+    TEST_ASSERT_EQUAL(TD_RECEIVER::TYPE, td->type);
+    TEST_ASSERT_EQUAL(TD_RECEIVER_LATENCY::SUB_TYPE, td->subType);
+    TEST_ASSERT_EQUAL(10, td->stages[ReceiverBase::LATENCY_TASK_TO_CONTROLS].count);
+    TEST_ASSERT_EQUAL(20, td->stages[ReceiverBase::LATENCY_TASK_TO_CONTROLS].p50);
+    TEST_ASSERT_EQUAL(20, td->stages[ReceiverBase::LATENCY_TASK_TO_CONTROLS].max);
+
+    receiver.reset_latency_histograms();
+    TEST_ASSERT_EQUAL(0, receiver.get_latency_histogram(ReceiverBase::LATENCY_LAST_BYTE_TO_CONTROLS).get_count());
+}
+#endif
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_latency_histogram_buckets);
+    RUN_TEST(test_latency_histogram_bucket_accuracy);
+    RUN_TEST(test_latency_histogram_percentiles);
+    RUN_TEST(test_latency_histogram_bimodal);
+#if defined(LIBRARY_RECEIVER_USE_LATENCY_HISTOGRAMS)
+    RUN_TEST(test_receiver_latency_histograms);
+#endif
+
+    UNITY_END();
+}
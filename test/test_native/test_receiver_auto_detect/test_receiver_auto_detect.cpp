@@ -0,0 +1,266 @@
+#include "receiver_auto_detect.h"
+#include "receiver_crsf.h"
+#include "receiver_ibus.h"
+#include "receiver_sbus.h"
+
+#include "../crsf_test_packets.h"
+#include "../ibus_test_packets.h"
+#include "../sbus_test_packets.h"
+
+#include <cstdio>
+#include <vector>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
+static std::vector<uint8_t> sbus_frame(uint16_t value)
+{
+    const auto packet = sbus_packet(value);
+    return { packet.begin(), packet.end() };
+}
+
+static std::vector<uint8_t> crsf_frame(uint16_t value)
+{
+    const ReceiverCrsf::packet_u packet = crsf_rc_channels_packet(value);
+    return { packet.data.begin(), packet.data.begin() + 26 };
+}
+
+static std::vector<uint8_t> ibus_frame(uint16_t value)
+{
+    const auto packet = ibus_packet(value);
+    return { packet.begin(), packet.end() };
+}
+
+/*!
+Recorded stream from a receiver: a frame every `frame_interval_us`, sent with serial settings `config`.
+*/
+struct recorded_stream_t {
+    const char* name;
+    ReceiverSyncDetector::protocol_e protocol;
+    ReceiverAutoDetect::serial_config_t config;
+    uint32_t frame_interval_us;
+    std::vector<uint8_t> (*frame)(uint16_t value);
+};
+
+static const std::array<recorded_stream_t, 5> streams {{
+    { "CRSF 416666 150Hz", ReceiverSyncDetector::PROTOCOL_CRSF, { 416666, 8, 1, SerialPort::PARITY_NONE }, 6667, crsf_frame },
+    { "CRSF 420000 50Hz", ReceiverSyncDetector::PROTOCOL_CRSF, { 420000, 8, 1, SerialPort::PARITY_NONE }, 20000, crsf_frame },
+    { "IBUS 115200", ReceiverSyncDetector::PROTOCOL_IBUS, { 115200, 8, 1, SerialPort::PARITY_NONE }, 7000, ibus_frame },
+    { "SBUS 100000", ReceiverSyncDetector::PROTOCOL_SBUS, { 100000, 8, 2, SerialPort::PARITY_EVEN }, 14000, sbus_frame },
+    { "SBUS 200000", ReceiverSyncDetector::PROTOCOL_SBUS, { 200000, 8, 2, SerialPort::PARITY_EVEN }, 7000, sbus_frame },
+}};
+
+/*!
+Plays back a recorded stream into a serial port, a millisecond at a time.
+
+If the serial port settings do not match those of the stream then the port receives garbage instead:
+the baudrate must be within 3% and the parity must match, but stop bits may differ,
+since a UART only checks the first stop bit.
+*/
+class StreamPlayer {
+public:
+    StreamPlayer(const recorded_stream_t& stream, time_us32_t phase_us) : _stream(stream), _next_frame_time(phase_us) {}
+    void play(SerialPort& serialPort, time_us32_t time) {
+        const auto& config = _stream.config;
+        const uint32_t bits_per_byte = 1 + config.data_bits + (config.parity == SerialPort::PARITY_NONE ? 0 : 1) + config.stop_bits;
+        const uint32_t byte_time_us = bits_per_byte * 1000000 / config.baudrate;
+        const uint32_t port_baudrate = serialPort.get_baudrate();
+        const uint32_t baudrate_difference = port_baudrate > config.baudrate ? port_baudrate - config.baudrate : config.baudrate - port_baudrate;
+        const bool match = baudrate_difference * 100 <= config.baudrate * 3 && serialPort.get_parity() == config.parity;
+        while (_next_frame_time <= time) {
+            if (_frame.empty()) {
+                _frame = _stream.frame(static_cast<uint16_t>(172 + (_frame_count * 37) % 1600));
+                _byte_index = 0;
+            }
+            // send the bytes that have been transmitted by `time`
+            while (_byte_index < _frame.size() && _next_frame_time + (_byte_index + 1) * byte_time_us <= time) {
+                uint8_t byte = _frame[_byte_index];
+                if (!match) {
+                    _seed = _seed * 1664525U + 1013904223U;
+                    byte = static_cast<uint8_t>(_seed >> 24U);
+                }
+                serialPort.push_from_isr(&byte, 1);
+                ++_byte_index;
+            }
+            if (_byte_index < _frame.size()) {
+                break;
+            }
+            _frame.clear();
+            ++_frame_count;
+            _next_frame_time += _stream.frame_interval_us;
+        }
+    }
+private:
+    const recorded_stream_t& _stream;
+    time_us32_t _next_frame_time;
+    std::vector<uint8_t> _frame {};
+    size_t _byte_index {};
+    uint32_t _frame_count {};
+    uint32_t _seed {12345};
+};
+
+/*!
+Run the receiver task, as ReceiverTask does with time based scheduling. Returns true if a packet was received.
+*/
+static bool run_receiver_task(ReceiverSerial& receiver, time_us32_t time)
+{
+    std::array<uint8_t, 64> buf {};
+    size_t len = 0;
+    while ((len = receiver.read(&buf[0], buf.size())) > 0) {
+        receiver.on_data_received(&buf[0], len, time);
+    }
+    return receiver.update(0);
+}
+
+void test_receiver_sync_detector()
+{
+    for (const auto& stream : streams) {
+        ReceiverSyncDetector detector(stream.protocol);
+        std::vector<uint8_t> data { 0x00, 0x0F, 0xC8, 0x20, 0x55, 0xEE, 0x12 };
+        for (uint16_t ii = 0; ii < 4; ++ii) {
+            const auto frame = stream.frame(static_cast<uint16_t>(500 + ii));
+            data.insert(data.end(), frame.begin(), frame.end());
+        }
+        TEST_ASSERT_EQUAL(data.size(), detector.on_data_received(&data[0], data.size(), 10));
+        TEST_ASSERT_EQUAL(4, detector.get_frame_count());
+
+        // stops at the frame count limit
+        detector.reset();
+        const size_t used = detector.on_data_received(&data[0], data.size(), 2);
+        TEST_ASSERT_EQUAL(2, detector.get_frame_count());
+        TEST_ASSERT_EQUAL(data.size() - 2 * stream.frame(0).size(), used);
+
+        // a corrupted frame followed by a good frame, the good frame is found by rescanning
+        detector.reset();
+        auto corrupted = stream.frame(500);
+        corrupted[corrupted.size() - 1] ^= 0x01;
+        const auto frame = stream.frame(501);
+        // truncate the corrupted frame, so that the start of the good frame is within the corrupted frame's length
+        corrupted.erase(corrupted.end() - 5, corrupted.end());
+        corrupted.insert(corrupted.end(), frame.begin(), frame.end());
+        detector.on_data_received(&corrupted[0], corrupted.size(), 10);
+        TEST_ASSERT_EQUAL(1, detector.get_frame_count());
+    }
+}
+
+void test_receiver_auto_detect_power_up()
+{
+    for (const auto& stream : streams) {
+        SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, 8, 1, SerialPort::PARITY_NONE);
+        ReceiverSbus sbus(serialPort);
+        ReceiverCrsf crsf(serialPort);
+        ReceiverIbus ibus(serialPort);
+        ReceiverAutoDetect autoDetect(serialPort, { &sbus, &crsf, &ibus });
+
+        // the receiver powers up part way through a frame
+        StreamPlayer player(stream, 1234);
+        time_us32_t detected_time = 0;
+        time_us32_t first_frame_time = 0;
+        for (time_us32_t time = 0; time < 2000000 && first_frame_time == 0; time += 1000) {
+            player.play(serialPort, time);
+            ReceiverSerial* receiver = autoDetect.update(time);
+            if (receiver != nullptr) {
+                if (detected_time == 0) {
+                    detected_time = time;
+                }
+                if (run_receiver_task(*receiver, time)) {
+                    first_frame_time = time;
+                }
+            }
+        }
+        printf("%-18s detected after %3ums, first valid frame after %3ums\r\n", stream.name, detected_time / 1000, first_frame_time / 1000);
+        TEST_ASSERT_EQUAL(stream.protocol, autoDetect.get_protocol());
+        TEST_ASSERT_TRUE(first_frame_time != 0);
+        // all the serial configs are tried within this time
+        TEST_ASSERT_TRUE(first_frame_time < ReceiverAutoDetect::SERIAL_CONFIGS.size() * ReceiverAutoDetect::DWELL_EXTENDED_US);
+    }
+}
+
+void test_receiver_auto_detect_receiver_swap()
+{
+    SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, 8, 1, SerialPort::PARITY_NONE);
+    ReceiverSbus sbus(serialPort);
+    ReceiverCrsf crsf(serialPort);
+    ReceiverIbus ibus(serialPort);
+    ReceiverAutoDetect autoDetect(serialPort, { &sbus, &crsf, &ibus });
+
+    StreamPlayer sbusPlayer(streams[3], 0);
+    time_us32_t time = 0;
+    for (; time < 1000000; time += 1000) {
+        sbusPlayer.play(serialPort, time);
+        ReceiverSerial* receiver = autoDetect.update(time);
+        if (receiver != nullptr) {
+            run_receiver_task(*receiver, time);
+        }
+    }
+    TEST_ASSERT_EQUAL(ReceiverSyncDetector::PROTOCOL_SBUS, autoDetect.get_protocol());
+
+    // swap to a CRSF receiver
+    const time_us32_t swap_time = time;
+    StreamPlayer crsfPlayer(streams[0], swap_time + 100000);
+    time_us32_t first_frame_time = 0;
+    for (; time < swap_time + 5000000 && first_frame_time == 0; time += 1000) {
+        crsfPlayer.play(serialPort, time);
+        ReceiverSerial* receiver = autoDetect.update(time);
+        if (receiver == &crsf && run_receiver_task(crsf, time)) {
+            first_frame_time = time;
+        } else if (receiver != nullptr) {
+            run_receiver_task(*receiver, time);
+        }
+    }
+    printf("receiver swap SBUS to CRSF, first valid frame after %ums\r\n", (first_frame_time - swap_time) / 1000);
+    TEST_ASSERT_EQUAL(ReceiverSyncDetector::PROTOCOL_CRSF, autoDetect.get_protocol());
+    TEST_ASSERT_TRUE(first_frame_time != 0);
+    TEST_ASSERT_TRUE(first_frame_time - swap_time < ReceiverAutoDetect::LOST_TIMEOUT_US + ReceiverAutoDetect::SERIAL_CONFIGS.size() * ReceiverAutoDetect::DWELL_EXTENDED_US);
+}
+void test_receiver_auto_detect_serial_config_handover()
+{
+    // the detected serial config is handed to the receiver, which was constructed before the baudrate was known
+    for (const size_t index : { 1, 3, 4 }) {
+        const recorded_stream_t& stream = streams[index];
+        SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, 8, 1, SerialPort::PARITY_NONE);
+        ReceiverSbus sbus(serialPort);
+        sbus.set_baudrate_mode(ReceiverSbus::BAUDRATE_MODE_AUTO);
+        ReceiverCrsf crsf(serialPort);
+        ReceiverIbus ibus(serialPort);
+        ReceiverAutoDetect autoDetect(serialPort, { &sbus, &crsf, &ibus });
+
+        StreamPlayer player(stream, 0);
+        ReceiverSerial* receiver = nullptr;
+        for (time_us32_t time = 0; time < 2000000 && receiver == nullptr; time += 1000) {
+            player.play(serialPort, time);
+            receiver = autoDetect.update(time);
+        }
+        TEST_ASSERT_EQUAL(stream.protocol, autoDetect.get_protocol());
+        if (stream.protocol == ReceiverSyncDetector::PROTOCOL_SBUS) {
+            TEST_ASSERT_EQUAL(stream.config.baudrate, serialPort.get_baudrate());
+            TEST_ASSERT_EQUAL(stream.config.baudrate == ReceiverSbus::FAST_BAUDRATE, sbus.is_fast());
+            TEST_ASSERT_EQUAL(sbus.is_fast() ? ReceiverSbus::TIME_NEEDED_PER_FRAME_US / 2 : ReceiverSbus::TIME_NEEDED_PER_FRAME_US, sbus.get_time_needed_per_frame_us());
+            // the baudrate has been detected, so the SBUS receiver does not probe for it
+            TEST_ASSERT_TRUE(sbus.is_baudrate_detected());
+        } else {
+            // 420000 baud is within the tolerance of a UART set to 416666 baud, so the stream may be detected at either
+            TEST_ASSERT_EQUAL(ReceiverCrsf::TIME_NEEDED_PER_FRAME_US * ReceiverCrsf::BAUD_RATE / serialPort.get_baudrate(), crsf.get_time_needed_per_frame_us());
+        }
+    }
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_receiver_sync_detector);
+    RUN_TEST(test_receiver_auto_detect_power_up);
+    RUN_TEST(test_receiver_auto_detect_receiver_swap);
+    RUN_TEST(test_receiver_auto_detect_serial_config_handover);
+
+    UNITY_END();
+}
@@ -0,0 +1,436 @@
+#include "cockpit_base.h"
+#include "latency_histogram.h"
+#include "receiver_crsf.h"
+#include "receiver_ibus.h"
+#include "receiver_pipeline.h"
+#include "receiver_sbus.h"
+#include "unpack_11bit_channels.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-magic-numbers)
+enum { FRAME_COUNT = 20000 };
+enum { CHUNK_SIZE = 32 }; // size of RPI Pico UART FIFO
+
+static std::vector<uint8_t> sbus_stream()
+{
+    std::vector<uint8_t> stream;
+    for (size_t ii = 0; ii < FRAME_COUNT; ++ii) {
+        stream.push_back(ReceiverSbus::SBUS_START_BYTE);
+        for (size_t jj = 1; jj < 24; ++jj) {
+            stream.push_back(static_cast<uint8_t>(ii + jj));
+        }
+        stream.push_back(ReceiverSbus::SBUS_END_BYTE);
+    }
+    return stream;
+}
+
+static std::vector<uint8_t> crsf_stream()
+{
+    std::vector<uint8_t> stream;
+    for (size_t ii = 0; ii < FRAME_COUNT; ++ii) {
+        ReceiverCrsf::packet_u packet {};
+        packet.value.sync = ReceiverCrsf::CRSF_SYNC_BYTE;
+        packet.value.length = 24;
+        packet.value.type = ReceiverCrsf::FRAMETYPE_RC_CHANNELS_PACKED;
+        for (size_t jj = 0; jj < 22; ++jj) {
+            packet.value.payload[jj] = static_cast<uint8_t>(ii + jj);
+        }
+        packet.value.payload[22] = ReceiverCrsf::calculate_crc(packet);
+        stream.insert(stream.end(), packet.data.begin(), packet.data.begin() + 26);
+    }
+    return stream;
+}
+
+static std::vector<uint8_t> ibus_stream()
+{
+    std::vector<uint8_t> stream;
+    for (size_t ii = 0; ii < FRAME_COUNT; ++ii) {
+        stream.push_back(ReceiverIbus::SERIAL_RX_PACKET_LENGTH);
+        stream.push_back(0x40);
+        uint16_t checksum = 0xFFFF;
+        for (size_t jj = 0; jj < ReceiverIbus::SLOT_COUNT; ++jj) {
+            const auto channel = static_cast<uint16_t>(1000 + ii + jj);
+            stream.push_back(static_cast<uint8_t>(channel & 0xFFU));
+            stream.push_back(static_cast<uint8_t>(channel >> 8U));
+            checksum = static_cast<uint16_t>(checksum + (channel & 0xFFU) + (channel & 0xFF00U));
+        }
+        stream.push_back(static_cast<uint8_t>(checksum & 0xFFU));
+        stream.push_back(static_cast<uint8_t>(checksum >> 8U));
+    }
+    return stream;
+}
+
+struct throughput_t {
+    double per_byte;
+    double batch;
+    size_t per_byte_packet_count;
+    size_t batch_packet_count;
+};
+
+/*!
+Compares the throughput, in bytes per second, of the per-byte path (one virtual call and one timestamp per byte)
+with the batch path (one call and one timestamp per chunk).
+*/
+static throughput_t measure_throughput(ReceiverSerial& per_byte_receiver, ReceiverSerial& batch_receiver, const std::vector<uint8_t>& stream)
+{
+    ReceiverBase& receiver = per_byte_receiver;
+    size_t per_byte_packet_count = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint8_t data : stream) {
+        if (receiver.on_data_received_from_isr(data)) {
+            ++per_byte_packet_count;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    const double per_byte_seconds = std::chrono::duration<double>(end - start).count();
+
+    size_t batch_packet_count = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t ii = 0; ii < stream.size(); ii += CHUNK_SIZE) {
+        const size_t len = std::min(static_cast<size_t>(CHUNK_SIZE), stream.size() - ii);
+        batch_packet_count += batch_receiver.on_data_received(&stream[ii], len, time_us());
+    }
+    end = std::chrono::steady_clock::now();
+    const double batch_seconds = std::chrono::duration<double>(end - start).count();
+
+    const auto bytes = static_cast<double>(stream.size());
+    return throughput_t {
+        .per_byte = bytes / per_byte_seconds,
+        .batch = bytes / batch_seconds,
+        .per_byte_packet_count = per_byte_packet_count,
+        .batch_packet_count = batch_packet_count
+    };
+}
+
+void test_receiver_sbus_ingest_throughput()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    static ReceiverSbus per_byte_receiver(serialPort);
+    static ReceiverSbus batch_receiver(serialPort);
+
+    const throughput_t throughput = measure_throughput(per_byte_receiver, batch_receiver, sbus_stream());
+    TEST_ASSERT_EQUAL(FRAME_COUNT, throughput.per_byte_packet_count);
+    TEST_ASSERT_EQUAL(FRAME_COUNT, throughput.batch_packet_count);
+    TEST_ASSERT_EQUAL(per_byte_receiver.get_packet_sequence(), batch_receiver.get_packet_sequence());
+    printf("SBUS ingest: per-byte %.1f Mbytes/s, batch %.1f Mbytes/s\r\n", throughput.per_byte / 1.0e6, throughput.batch / 1.0e6);
+}
+
+void test_receiver_crsf_ingest_throughput()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf per_byte_receiver(serialPort);
+    static ReceiverCrsf batch_receiver(serialPort);
+
+    const throughput_t throughput = measure_throughput(per_byte_receiver, batch_receiver, crsf_stream());
+    TEST_ASSERT_EQUAL(FRAME_COUNT, throughput.per_byte_packet_count);
+    TEST_ASSERT_EQUAL(FRAME_COUNT, throughput.batch_packet_count);
+    TEST_ASSERT_EQUAL(per_byte_receiver.get_packet_sequence(), batch_receiver.get_packet_sequence());
+    printf("CRSF ingest: per-byte %.1f Mbytes/s, batch %.1f Mbytes/s\r\n", throughput.per_byte / 1.0e6, throughput.batch / 1.0e6);
+}
+
+void test_receiver_ibus_ingest_throughput()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverIbus::DATA_BITS, ReceiverIbus::STOP_BITS, ReceiverIbus::PARITY);
+    static ReceiverIbus per_byte_receiver(serialPort);
+    static ReceiverIbus batch_receiver(serialPort);
+
+    const throughput_t throughput = measure_throughput(per_byte_receiver, batch_receiver, ibus_stream());
+    TEST_ASSERT_EQUAL(FRAME_COUNT, throughput.per_byte_packet_count);
+    TEST_ASSERT_EQUAL(FRAME_COUNT, throughput.batch_packet_count);
+    TEST_ASSERT_EQUAL(per_byte_receiver.get_packet_sequence(), batch_receiver.get_packet_sequence());
+    printf("IBUS ingest: per-byte %.1f Mbytes/s, batch %.1f Mbytes/s\r\n", throughput.per_byte / 1.0e6, throughput.batch / 1.0e6);
+}
+void test_crc8_throughput()
+{
+    enum { ITERATIONS = 200000 };
+    // CRSF RC channels frame: type, 22 bytes of channel data
+    std::array<uint8_t, 23> frame {};
+    for (size_t ii = 0; ii < frame.size(); ++ii) {
+        frame[ii] = static_cast<uint8_t>(ii * 37);
+    }
+    typedef ReceiverCrsf::crc8_dvb_s2_t crc8_t;
+    typedef uint8_t (*calculate_t)(uint8_t, const uint8_t*, size_t);
+    struct kernel_t {
+        const char* name;
+        calculate_t calculate;
+    };
+    static constexpr std::array<kernel_t, 3> kernels {{
+        { "bitwise", crc8_t::calculate_bitwise },
+        { "table", crc8_t::calculate_table },
+        { "slicing", crc8_t::calculate_slicing }
+    }};
+
+    const uint8_t expected = crc8_t::calculate_bitwise(0, &frame[0], frame.size());
+    for (const kernel_t& kernel : kernels) {
+        uint8_t crc = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t ii = 0; ii < ITERATIONS; ++ii) {
+            // feed the previous result back in, so the calls cannot be optimized away
+            frame[0] = crc;
+            crc = kernel.calculate(0, &frame[0], frame.size());
+        }
+        const auto end = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        frame[0] = 0;
+        TEST_ASSERT_EQUAL(expected, kernel.calculate(0, &frame[0], frame.size()));
+        printf("CRC8 %-8s %.1f Mbytes/s\r\n", kernel.name, static_cast<double>(ITERATIONS * frame.size()) / seconds / 1.0e6);
+    }
+}
+void test_latency_histogram_record_throughput()
+{
+    enum { VALUE_COUNT = 1024, ITERATIONS = 2000 };
+    // frame intervals around 4ms with some jitter, and some much larger values
+    std::vector<uint32_t> values(VALUE_COUNT);
+    for (size_t ii = 0; ii < values.size(); ++ii) {
+        values[ii] = (ii % 64 == 0) ? static_cast<uint32_t>(50000 + ii) : static_cast<uint32_t>(4000 + (ii * 37) % 200);
+    }
+    static LatencyHistogram<> histogram;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t ii = 0; ii < ITERATIONS; ++ii) {
+        for (uint32_t value : values) {
+            histogram.record(value);
+        }
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const double ns_per_record = std::chrono::duration<double, std::nano>(end - start).count() / (VALUE_COUNT * ITERATIONS);
+    TEST_ASSERT_EQUAL(VALUE_COUNT * ITERATIONS, histogram.get_count());
+    printf("LatencyHistogram record %.2f ns\r\n", ns_per_record);
+    // recording is a handful of integer operations, allow plenty of margin for slow or instrumented builds
+    TEST_ASSERT_LESS_THAN(50.0, ns_per_record);
+}
+void test_unpack_11bit_channels_throughput()
+{
+    enum { FRAMES = 1024, ITERATIONS = 1000 };
+    std::vector<uint8_t> frames(FRAMES * 22);
+    for (size_t ii = 0; ii < frames.size(); ++ii) {
+        frames[ii] = static_cast<uint8_t>(ii * 37 + (ii >> 8U));
+    }
+    typedef void (*unpack_t)(uint16_t*, const uint8_t*);
+    struct kernel_t {
+        const char* name;
+        unpack_t unpack;
+    };
+    static constexpr std::array<kernel_t, 2> kernels {{
+        { "scalar", unpack_11bit_channels_scalar<16> },
+#if defined(LIBRARY_RECEIVER_UNPACK_11BIT_CHANNELS_VECTOR)
+        { "vector", unpack_11bit_channels_vector<16> }
+#else
+        { "scalar", unpack_11bit_channels_scalar<16> }
+#endif
+    }};
+
+    uint32_t expected_sum = 0;
+    for (const kernel_t& kernel : kernels) {
+        std::array<uint16_t, 16> channels {};
+        uint32_t sum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t ii = 0; ii < ITERATIONS; ++ii) {
+            for (size_t frame = 0; frame < FRAMES; ++frame) {
+                kernel.unpack(&channels[0], &frames[frame * 22]);
+                sum += channels[0] + channels[15];
+            }
+        }
+        const auto end = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        if (expected_sum == 0) {
+            expected_sum = sum;
+        }
+        TEST_ASSERT_EQUAL(expected_sum, sum);
+        printf("unpack_11bit_channels<16> %s %.1f Mframes/s\r\n", kernel.name, static_cast<double>(FRAMES * ITERATIONS) / seconds / 1.0e6);
+    }
+}
+void test_controls_throughput()
+{
+    // this host has an FPU, so the savings on a target without one (where each float divide is a library call) are much larger
+    enum { ITERATIONS = 2000 };
+    std::vector<receiver_controls_pwm_t> pwms;
+    for (uint16_t pwm = 988; pwm <= 2012; ++pwm) {
+        pwms.push_back({ pwm, static_cast<uint16_t>(3000 - pwm), pwm, static_cast<uint16_t>(pwm ^ 0x0FU) });
+    }
+
+    float float_sum = 0.0F;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t ii = 0; ii < ITERATIONS; ++ii) {
+        for (const auto& pwm : pwms) {
+            // the original float calculation
+            const receiver_controls_t controls {
+                .throttle = (static_cast<float>(pwm.throttle) - ReceiverBase::CHANNEL_LOW_F) / ReceiverBase::CHANNEL_RANGE_F,
+                .roll = (static_cast<float>(pwm.roll) - ReceiverBase::CHANNEL_MIDDLE_F) / ReceiverBase::CHANNEL_RANGE_F,
+                .pitch = (static_cast<float>(pwm.pitch) - ReceiverBase::CHANNEL_MIDDLE_F) / ReceiverBase::CHANNEL_RANGE_F,
+                .yaw = (static_cast<float>(pwm.yaw) - ReceiverBase::CHANNEL_MIDDLE_F) / ReceiverBase::CHANNEL_RANGE_F
+            };
+            float_sum += controls.throttle + controls.roll + controls.pitch + controls.yaw;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    const double float_seconds = std::chrono::duration<double>(end - start).count();
+
+    float integer_sum = 0.0F;
+    start = std::chrono::steady_clock::now();
+    for (size_t ii = 0; ii < ITERATIONS; ++ii) {
+        for (const auto& pwm : pwms) {
+            // the integer implementation, used by controls_from_pwm() on targets without an FPU
+            const receiver_controls_t controls {
+                .throttle = ReceiverBase::divide_by_channel_range_integer(static_cast<int32_t>(pwm.throttle) - ReceiverBase::CHANNEL_LOW),
+                .roll = ReceiverBase::divide_by_channel_range_integer(static_cast<int32_t>(pwm.roll) - ReceiverBase::CHANNEL_MIDDLE),
+                .pitch = ReceiverBase::divide_by_channel_range_integer(static_cast<int32_t>(pwm.pitch) - ReceiverBase::CHANNEL_MIDDLE),
+                .yaw = ReceiverBase::divide_by_channel_range_integer(static_cast<int32_t>(pwm.yaw) - ReceiverBase::CHANNEL_MIDDLE)
+            };
+            integer_sum += controls.throttle + controls.roll + controls.pitch + controls.yaw;
+        }
+    }
+    end = std::chrono::steady_clock::now();
+    const double integer_seconds = std::chrono::duration<double>(end - start).count();
+
+    int32_t q12dot4_sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t ii = 0; ii < ITERATIONS; ++ii) {
+        for (const auto& pwm : pwms) {
+            const receiver_controls_q12dot4_t controls = ReceiverBase::controls_q12dot4_from_pwm(pwm);
+            q12dot4_sum += controls.throttle + controls.roll + controls.pitch + controls.yaw;
+        }
+    }
+    end = std::chrono::steady_clock::now();
+    const double q12dot4_seconds = std::chrono::duration<double>(end - start).count();
+
+    TEST_ASSERT_EQUAL_FLOAT(float_sum, integer_sum);
+    // each q12dot4 value is within half a step of the float value
+    const float tolerance = 4.0F * static_cast<float>(pwms.size() * ITERATIONS) * 0.5F / 2048.0F;
+    TEST_ASSERT_FLOAT_WITHIN(tolerance, float_sum, ReceiverBase::q12dot4_to_float(q12dot4_sum));
+
+    const auto count = static_cast<double>(pwms.size() * ITERATIONS);
+    printf("controls: float %.1f ns, integer float %.1f ns, q12dot4 %.1f ns\r\n",
+        float_seconds / count * 1.0e9, integer_seconds / count * 1.0e9, q12dot4_seconds / count * 1.0e9);
+}
+/*!
+Measures the time to receive and unpack a frame when only the sticks are used, as in the flight loop.
+Build with LIBRARY_RECEIVER_USE_LAZY_CHANNEL_DECODING defined to compare lazy with eager decoding.
+*/
+static double unpack_sticks_ns_per_frame(ReceiverSerial& receiver, const std::vector<uint8_t>& stream, size_t frame_size, uint32_t& sum)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t ii = 0; ii + frame_size <= stream.size(); ii += frame_size) {
+        receiver.on_data_received(&stream[ii], frame_size, 0);
+        receiver.unpack_packet();
+        const receiver_controls_pwm_t controls = receiver.get_controls_pwm();
+        sum += controls.throttle + controls.roll + controls.pitch + controls.yaw;
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count() / static_cast<double>(stream.size() / frame_size) * 1.0e9;
+}
+
+void test_unpack_sticks_throughput()
+{
+#if defined(LIBRARY_RECEIVER_USE_LAZY_CHANNEL_DECODING)
+    static constexpr const char* mode = "lazy";
+#else
+    static constexpr const char* mode = "eager";
+#endif
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    static ReceiverSbus sbus(serialPort);
+    static ReceiverCrsf crsf(serialPort);
+    static ReceiverIbus ibus(serialPort);
+
+    uint32_t sum = 0;
+    const double sbus_ns = unpack_sticks_ns_per_frame(sbus, sbus_stream(), 25, sum);
+    const double crsf_ns = unpack_sticks_ns_per_frame(crsf, crsf_stream(), 26, sum);
+    const double ibus_ns = unpack_sticks_ns_per_frame(ibus, ibus_stream(), 32, sum);
+    TEST_ASSERT_NOT_EQUAL(0, sum);
+    printf("receive and unpack sticks (%s decoding): SBUS %.1f ns/frame, CRSF %.1f ns/frame, IBUS %.1f ns/frame\r\n", mode, sbus_ns, crsf_ns, ibus_ns);
+}
+struct receiver_context_t {
+    uint32_t sum;
+};
+
+class CockpitSum final : public CockpitBase {
+public:
+    void update_controls(uint32_t tick_count, uint32_t frame_age_us, const ReceiverBase& receiver, receiver_context_t& ctx) override {
+        (void)tick_count;
+        (void)frame_age_us;
+        const receiver_controls_pwm_t controls = receiver.get_controls_pwm();
+        ctx.sum += controls.throttle + controls.roll + controls.pitch + controls.yaw;
+    }
+    void check_failsafe(uint32_t tick_count, receiver_context_t& ctx) override {
+        (void)tick_count;
+        (void)ctx;
+    }
+};
+
+/*!
+Feed `stream` to `serial_port` a frame at a time, as a block as a FIFO or DMA UART ISR does, and run the task loop after each frame,
+so each frame goes through the whole frame->controls path. Returns the time per frame.
+*/
+template <typename Task>
+static double pipeline_ns_per_frame(SerialPort& serial_port, Task& task, const std::vector<uint8_t>& stream, size_t frame_size)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t ii = 0; ii + frame_size <= stream.size(); ii += frame_size) {
+        serial_port.on_data_received_from_isr(&stream[ii], frame_size, time_us());
+        task.loop();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count() / static_cast<double>(stream.size() / frame_size) * 1.0e9;
+}
+
+void test_receiver_pipeline_dispatch_throughput()
+{
+    // runtime pipeline: SerialPort -> ReceiverSerialPortWatcher -> ReceiverBase -> ReceiverCrsf, ReceiverTask -> CockpitBase
+    static SerialPort runtime_serial_port(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf runtime_receiver(runtime_serial_port);
+    static CockpitSum runtime_cockpit;
+    static receiver_context_t runtime_context {};
+    static ReceiverTask runtime_task(0, runtime_receiver, runtime_cockpit, runtime_context);
+    // compile-time pipeline: SerialPort -> ReceiverSerialT<ReceiverCrsf>, ReceiverTaskT -> CockpitSum
+    static SerialPort serial_port(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverSerialT<ReceiverCrsf> receiver(serial_port);
+    static CockpitSum cockpit;
+    static receiver_context_t context {};
+    static ReceiverTaskT<ReceiverSerialT<ReceiverCrsf>, CockpitSum> task(0, receiver, cockpit, context);
+
+    // the pipelines are timed alternately and the fastest run of each is reported, to reduce the noise from the host
+    constexpr int RUN_COUNT = 9;
+    const std::vector<uint8_t> stream = crsf_stream();
+    double runtime_ns = 1.0e9;
+    double compile_time_ns = 1.0e9;
+    for (int run = 0; run < RUN_COUNT; ++run) {
+        runtime_ns = std::min(runtime_ns, pipeline_ns_per_frame(runtime_serial_port, runtime_task, stream, 26));
+        compile_time_ns = std::min(compile_time_ns, pipeline_ns_per_frame(serial_port, task, stream, 26));
+    }
+    TEST_ASSERT_EQUAL(FRAME_COUNT * RUN_COUNT, runtime_receiver.get_packet_sequence());
+    TEST_ASSERT_EQUAL(FRAME_COUNT * RUN_COUNT, receiver.get_packet_sequence());
+    TEST_ASSERT_NOT_EQUAL(0, context.sum);
+    TEST_ASSERT_EQUAL(runtime_context.sum, context.sum);
+    printf("CRSF frame->controls, best of %d runs: virtual %.1f ns/frame, compile-time %.1f ns/frame, saving %.1f ns/frame\r\n",
+        RUN_COUNT, runtime_ns, compile_time_ns, runtime_ns - compile_time_ns);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_receiver_sbus_ingest_throughput);
+    RUN_TEST(test_receiver_crsf_ingest_throughput);
+    RUN_TEST(test_receiver_ibus_ingest_throughput);
+    RUN_TEST(test_crc8_throughput);
+    RUN_TEST(test_latency_histogram_record_throughput);
+    RUN_TEST(test_unpack_11bit_channels_throughput);
+    RUN_TEST(test_controls_throughput);
+    RUN_TEST(test_unpack_sticks_throughput);
+    RUN_TEST(test_receiver_pipeline_dispatch_throughput);
+
+    UNITY_END();
+}
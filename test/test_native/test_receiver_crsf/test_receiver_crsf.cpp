@@ -1,5 +1,8 @@
 #include "receiver_crsf.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <vector>
 #include <unity.h>
 
 void setUp()
@@ -13,7 +16,7 @@ void tearDown()
 // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
 void test_receiver_crsf()
 {
-    static SerialPort serialPort(SerialPort::uart_pins_t{}, 0, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
     static ReceiverCrsf receiver(serialPort);
     enum { CRC = 205 };
     ReceiverCrsf::packet_u packet = {
@@ -48,7 +51,7 @@ void test_receiver_crsf()
 
 void test_receiver_bind_packet()
 {
-    static SerialPort serialPort(SerialPort::uart_pins_t{}, 0, 0, 0, 0, 0);
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, 0, 0, 0);
     static ReceiverCrsf receiver(serialPort);
 
     enum { COMMAND_CRC = 0x9E };
@@ -76,7 +79,657 @@ void test_receiver_bind_packet()
     TEST_ASSERT_EQUAL(ReceiverCrsf::FRAMETYPE_COMMAND, receiver.get_packet_type());
     TEST_ASSERT_EQUAL(PACKET_CRC, receiver.get_received_crc());
     TEST_ASSERT_EQUAL(PACKET_CRC, receiver.calculate_crc());
+    TEST_ASSERT_EQUAL(COMMAND_CRC, ReceiverCrsf::get_received_command_crc(packet));
+    TEST_ASSERT_EQUAL(COMMAND_CRC, ReceiverCrsf::calculate_command_crc(packet));
 }
+
+void test_receiver_crsf_crc8()
+{
+    // check value for CRC8 DVB-S2 is 0xBC, see https://reveng.sourceforge.io/crc-catalogue/1-15.htm#crc.cat.crc-8-dvb-s2
+    const std::array<uint8_t, 9> check { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    TEST_ASSERT_EQUAL(0xBC, ReceiverCrsf::crc8_dvb_s2_t::calculate_bitwise(0, &check[0], check.size()));
+    TEST_ASSERT_EQUAL(0xBC, ReceiverCrsf::crc8_dvb_s2_t::calculate_table(0, &check[0], check.size()));
+    TEST_ASSERT_EQUAL(0xBC, ReceiverCrsf::crc8_dvb_s2_t::calculate_slicing(0, &check[0], check.size()));
+    TEST_ASSERT_EQUAL(0xBC, ReceiverCrsf::crc8_dvb_s2_t::calculate(0, &check[0], check.size()));
+
+    // all implementations agree, for all lengths and initial values
+    std::array<uint8_t, 64> data {};
+    uint32_t seed = 1;
+    for (uint8_t& value : data) {
+        seed = seed * 1664525U + 1013904223U;
+        value = static_cast<uint8_t>(seed >> 24U);
+    }
+    for (size_t len = 0; len <= data.size(); ++len) {
+        const uint8_t crc = ReceiverCrsf::crc8_dvb_s2_t::calculate_bitwise(static_cast<uint8_t>(len), &data[0], len);
+        TEST_ASSERT_EQUAL(crc, ReceiverCrsf::crc8_dvb_s2_t::calculate_table(static_cast<uint8_t>(len), &data[0], len));
+        TEST_ASSERT_EQUAL(crc, ReceiverCrsf::crc8_dvb_s2_t::calculate_slicing(static_cast<uint8_t>(len), &data[0], len));
+        uint8_t crc_bytewise = static_cast<uint8_t>(len);
+        for (size_t ii = 0; ii < len; ++ii) {
+            crc_bytewise = ReceiverCrsf::calculate_crc(crc_bytewise, data[ii]);
+        }
+        TEST_ASSERT_EQUAL(crc, crc_bytewise);
+    }
+}
+static ReceiverCrsf::packet_u crsf_rc_channels_packet(const std::array<uint16_t, 16>& channels)
+{
+    ReceiverCrsf::packet_u packet {};
+    packet.value.sync = ReceiverCrsf::CRSF_SYNC_BYTE;
+    packet.value.length = 24; // type + 22 bytes of channel data + CRC
+    packet.value.type = ReceiverCrsf::FRAMETYPE_RC_CHANNELS_PACKED;
+    size_t bit_index = 0;
+    for (uint16_t channel : channels) {
+        for (size_t ii = 0; ii < 11; ++ii) {
+            if (channel & (1U << ii)) {
+                packet.value.payload[bit_index / 8] |= static_cast<uint8_t>(1U << (bit_index % 8));
+            }
+            ++bit_index;
+        }
+    }
+    packet.value.payload[22] = ReceiverCrsf::calculate_crc(packet);
+    return packet;
+}
+
+/*!
+Generate a subset RC channels packet, channel values have `resolution` bits and are packed least significant bit first.
+*/
+static ReceiverCrsf::packet_u crsf_subset_rc_channels_packet(uint8_t starting_channel, unsigned resolution, const std::vector<uint16_t>& channels)
+{
+    ReceiverCrsf::packet_u packet {};
+    packet.value.sync = ReceiverCrsf::CRSF_SYNC_BYTE;
+    packet.value.type = ReceiverCrsf::FRAMETYPE_SUBSET_RC_CHANNELS_PACKED;
+    packet.value.payload[0] = static_cast<uint8_t>(starting_channel | ((resolution - 10) << 5U));
+    size_t bit_index = 0;
+    for (uint16_t channel : channels) {
+        for (size_t ii = 0; ii < resolution; ++ii) {
+            if (channel & (1U << ii)) {
+                packet.value.payload[1 + bit_index / 8] |= static_cast<uint8_t>(1U << (bit_index % 8));
+            }
+            ++bit_index;
+        }
+    }
+    const size_t data_size = (bit_index + 7) / 8;
+    packet.value.length = static_cast<uint8_t>(data_size + 3); // type + configuration byte + channel data + CRC
+    packet.value.payload[1 + data_size] = ReceiverCrsf::calculate_crc(packet);
+    return packet;
+}
+
+static size_t crsf_packet_size(const ReceiverCrsf::packet_u& packet)
+{
+    return packet.value.length + 2U; // sync and length bytes
+}
+
+void test_receiver_crsf_chunked_data()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+
+    const ReceiverCrsf::packet_u packet1 = crsf_rc_channels_packet({ 172, 992, 1811, 992, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172 });
+    const ReceiverCrsf::packet_u packet2 = crsf_rc_channels_packet({ 992, 172, 992, 1811, 1811, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172 });
+    enum { PACKET_SIZE = 26 };
+    // garbage, packet1, packet2
+    std::array<uint8_t, 2 + PACKET_SIZE + PACKET_SIZE> stream {};
+    stream[0] = 0x01;
+    stream[1] = 0x02;
+    std::copy(packet1.data.begin(), packet1.data.begin() + PACKET_SIZE, stream.begin() + 2);
+    std::copy(packet2.data.begin(), packet2.data.begin() + PACKET_SIZE, stream.begin() + 2 + PACKET_SIZE);
+
+    // feed the stream in chunks of all sizes, the result should be the same as feeding it in one go
+    for (size_t chunk_size = 1; chunk_size <= stream.size(); ++chunk_size) {
+        const uint32_t sequence = receiver.get_packet_sequence();
+        size_t packet_count = 0;
+        for (size_t ii = 0; ii < stream.size(); ii += chunk_size) {
+            packet_count += receiver.on_data_received(&stream[ii], std::min(chunk_size, stream.size() - ii), 0);
+        }
+        TEST_ASSERT_EQUAL(2, packet_count);
+        TEST_ASSERT_EQUAL(sequence + 2, receiver.get_packet_sequence());
+        TEST_ASSERT_EQUAL(0, receiver.get_packet_index());
+        TEST_ASSERT_EQUAL(ReceiverCrsf::FRAMETYPE_RC_CHANNELS_PACKED, receiver.get_packet_type());
+        TEST_ASSERT_EQUAL(receiver.calculate_crc(), receiver.get_received_crc());
+        TEST_ASSERT_TRUE(receiver.unpack_packet());
+        TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(0));
+        TEST_ASSERT_EQUAL(988, receiver.get_channel_pwm(1));
+        TEST_ASSERT_EQUAL(2012, receiver.get_channel_pwm(3));
+    }
+}
+
+void test_receiver_crsf_frame_time()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+
+    const ReceiverCrsf::packet_u packet = crsf_rc_channels_packet({ 172, 992, 1811, 992, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172 });
+    const size_t size = crsf_packet_size(packet);
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&packet.data[0], 5, 1000));
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[5], size - 5, 1500));
+    TEST_ASSERT_TRUE(receiver.update(0));
+    TEST_ASSERT_EQUAL(1000, receiver.get_frame_time().first_byte_us);
+    TEST_ASSERT_EQUAL(1500, receiver.get_frame_time().last_byte_us);
+    TEST_ASSERT_EQUAL(250, receiver.get_frame_age_us(1750));
+
+    // two packets arrive before the receiver is updated, the frame time is that of the packet unpacked
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], size, 5000));
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], size, 9000));
+    TEST_ASSERT_TRUE(receiver.update(0));
+    TEST_ASSERT_EQUAL(9000, receiver.get_frame_time().first_byte_us);
+    TEST_ASSERT_EQUAL(9000, receiver.get_frame_time().last_byte_us);
+}
+
+void test_receiver_crsf_invalid_length()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+
+    // length byte too large for the packet buffer, so the packet is rejected
+    const std::array<uint8_t, 3> data = { ReceiverCrsf::CRSF_SYNC_BYTE, ReceiverCrsf::MAX_PACKET_SIZE, ReceiverCrsf::FRAMETYPE_RC_CHANNELS_PACKED };
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&data[0], 2, 0));
+    TEST_ASSERT_EQUAL(0, receiver.get_packet_index());
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&data[2], 1, 0));
+    TEST_ASSERT_EQUAL(0, receiver.get_packet_index());
+
+    // the bad length is a framing error, and the bytes skipped after it are part of the same resync
+    receiver_stats_t stats {};
+    TEST_ASSERT_TRUE(receiver.get_stats(stats));
+    TEST_ASSERT_EQUAL(0, stats.valid_frame_count);
+    TEST_ASSERT_EQUAL(0, stats.crc_error_count);
+    TEST_ASSERT_EQUAL(1, stats.framing_error_count);
+    TEST_ASSERT_EQUAL(1, stats.resync_count);
+    TEST_ASSERT_EQUAL(3, stats.byte_count);
+}
+
+void test_receiver_crsf_stats_idle_gap()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+
+    const ReceiverCrsf::packet_u packet = crsf_rc_channels_packet({ 172, 992, 1811, 992, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172 });
+    // packets 4ms apart, the idle gap between them is not a drop
+    time_us32_t time = 10000;
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], 26, time));
+    time += 4000;
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], 26, time));
+    TEST_ASSERT_EQUAL(0, receiver.get_dropped_packet_count());
+
+    // a packet cut short by a gap is dropped, and is a framing error
+    time += 4000;
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&packet.data[0], 10, time));
+    time += 4000;
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], 26, time));
+    TEST_ASSERT_EQUAL(1, receiver.get_dropped_packet_count());
+
+    receiver_stats_t stats {};
+    TEST_ASSERT_TRUE(receiver.get_stats(stats));
+    TEST_ASSERT_EQUAL(3, stats.valid_frame_count);
+    TEST_ASSERT_EQUAL(1, stats.framing_error_count);
+    TEST_ASSERT_EQUAL(0, stats.resync_count);
+    TEST_ASSERT_EQUAL(3*26 + 10, stats.byte_count);
+}
+
+void test_receiver_crsf_bad_crc()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+
+    ReceiverCrsf::packet_u packet = crsf_rc_channels_packet({ 172, 992, 1811, 992, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172 });
+    packet.value.payload[5] ^= 0x01; // corrupt the packet
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&packet.data[0], 26, 0));
+    TEST_ASSERT_EQUAL(0, receiver.get_packet_index());
+    // the corrupt packet is counted as an error and not published, so the task is not woken
+    TEST_ASSERT_EQUAL(1, receiver.get_error_packet_count());
+    TEST_ASSERT_EQUAL(0, receiver.get_packet_sequence());
+    TEST_ASSERT_TRUE(receiver.is_packet_empty());
+
+    packet.value.payload[5] ^= 0x01;
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], 26, 0));
+    TEST_ASSERT_EQUAL(1, receiver.get_error_packet_count());
+    TEST_ASSERT_EQUAL(1, receiver.get_packet_sequence());
+
+    receiver_stats_t stats {};
+    TEST_ASSERT_TRUE(receiver.get_stats(stats));
+    TEST_ASSERT_EQUAL(1, stats.valid_frame_count);
+    TEST_ASSERT_EQUAL(1, stats.crc_error_count);
+    TEST_ASSERT_EQUAL(0, stats.framing_error_count);
+    TEST_ASSERT_EQUAL(52, stats.byte_count);
+}
+
+void test_receiver_crsf_map_to_pwm()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+
+    for (uint16_t raw = 0; raw < 2048; ++raw) {
+        // the previous float calculation
+        const auto expected = static_cast<uint16_t>(0.62477120195241F * static_cast<float>(raw) + 880.53935326418548F);
+        TEST_ASSERT_EQUAL(expected, ReceiverCrsf::map_to_pwm(raw));
+    }
+    TEST_ASSERT_EQUAL(988, ReceiverCrsf::map_to_pwm(172));
+    TEST_ASSERT_EQUAL(1500, ReceiverCrsf::map_to_pwm(992));
+    TEST_ASSERT_EQUAL(2012, ReceiverCrsf::map_to_pwm(1811));
+
+    const ReceiverCrsf::packet_u packet = crsf_rc_channels_packet({ 172, 992, 1811, 992, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 1811 });
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], 26, 0));
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    TEST_ASSERT_EQUAL(988, receiver.get_channel_pwm(0));
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(1));
+    TEST_ASSERT_EQUAL(2012, receiver.get_channel_pwm(2));
+    TEST_ASSERT_EQUAL(2012, receiver.get_channel_pwm(15));
+    TEST_ASSERT_EQUAL(ReceiverBase::CHANNEL_LOW, receiver.get_channel_pwm(16));
+}
+
+void test_receiver_crsf_channels_follow_packets()
+{
+    // with lazy channel decoding the auxiliary channels must be decoded from the current packet, not the one they were first read from
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+
+    ReceiverCrsf::packet_u packet = crsf_rc_channels_packet({ 172, 992, 1811, 992, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 1811 });
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], 26, 0));
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    TEST_ASSERT_EQUAL(988, receiver.get_channel_pwm(0));
+    TEST_ASSERT_EQUAL(988, receiver.get_channel_pwm(7));
+    TEST_ASSERT_EQUAL(2012, receiver.get_channel_pwm(15));
+
+    packet = crsf_rc_channels_packet({ 992, 172, 992, 1811, 1811, 992, 1811, 992, 1811, 992, 1811, 992, 1811, 992, 1811, 172 });
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], 26, 0));
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(0));
+    TEST_ASSERT_EQUAL(988, receiver.get_channel_pwm(1));
+    TEST_ASSERT_EQUAL(2012, receiver.get_channel_pwm(3));
+    TEST_ASSERT_EQUAL(2012, receiver.get_auxiliary_channel(0));
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(5));
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(7));
+    TEST_ASSERT_EQUAL(988, receiver.get_channel_pwm(15));
+}
+
+void test_receiver_crsf_sync_byte_as_length()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+
+    // a spurious sync byte before a packet, the packet's sync byte is first read as an invalid length and then rescanned
+    const ReceiverCrsf::packet_u packet = crsf_rc_channels_packet({ 172, 992, 1811, 992, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172 });
+    const uint8_t spurious = ReceiverCrsf::CRSF_SYNC_BYTE;
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&spurious, 1, 0));
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], 26, 0));
+    TEST_ASSERT_EQUAL(0, receiver.get_error_packet_count());
+    TEST_ASSERT_EQUAL(1, receiver.get_resync_count());
+}
+
+void test_receiver_crsf_resync_after_bad_length()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+
+    // the first packet's length is corrupted so that it swallows the start of the following packets
+    std::vector<uint8_t> stream;
+    for (uint16_t ii = 0; ii < 4; ++ii) {
+        const ReceiverCrsf::packet_u packet = crsf_rc_channels_packet({ 172, 992, 1811, static_cast<uint16_t>(992 + ii), 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172 });
+        stream.insert(stream.end(), packet.data.begin(), packet.data.begin() + 26);
+    }
+    stream[1] = 60;
+    TEST_ASSERT_EQUAL(3, receiver.on_data_received(&stream[0], stream.size(), 0));
+    TEST_ASSERT_EQUAL(1, receiver.get_error_packet_count());
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    TEST_ASSERT_EQUAL(ReceiverCrsf::map_to_pwm(995), receiver.get_channel_pwm(3));
+}
+
+/*!
+The CRSF framing used before resynchronization was added: a bad length byte is discarded,
+and after a bad CRC all the buffered bytes are discarded. Used as a reference for frames lost.
+*/
+class CrsfFramerDiscarding {
+public:
+    size_t on_data_received(const uint8_t* data, size_t len) {
+        size_t packet_count = 0;
+        for (size_t ii = 0; ii < len; ++ii) {
+            const uint8_t value = data[ii];
+            switch (_index) {
+            case 0:
+                if (value == ReceiverCrsf::CRSF_SYNC_BYTE || value == ReceiverCrsf::EDGE_TX_SYNC_BYTE) {
+                    _index = 1;
+                }
+                continue;
+            case 1:
+                if (value < 2 || value > ReceiverCrsf::MAX_PACKET_SIZE - 2) {
+                    _index = 0;
+                    continue;
+                }
+                _size = value + 2U;
+                _crc = 0;
+                break;
+            default:
+                _crc = ReceiverCrsf::crc8_dvb_s2_t::update(_crc, value);
+                break;
+            }
+            ++_index;
+            if (_index == _size) {
+                _index = 0;
+                if (_crc == 0) {
+                    ++packet_count;
+                }
+            }
+        }
+        return packet_count;
+    }
+private:
+    size_t _index {0};
+    size_t _size {0};
+    uint8_t _crc {0};
+};
+
+void test_receiver_crsf_corrupted_stream()
+{
+    enum { PACKET_COUNT = 2000, EVENT_INTERVAL = 20, PACKET_SIZE = 26 };
+    enum corruption_e { BIT_FLIP, LENGTH_LONGER, LENGTH_SHORTER, DROPPED_BYTE, SPURIOUS_SYNC_BYTE, CORRUPTION_COUNT };
+    static constexpr std::array<const char*, CORRUPTION_COUNT> names { "bit flip", "length longer", "length shorter", "dropped byte", "spurious sync byte" };
+
+    for (size_t corruption = 0; corruption < CORRUPTION_COUNT; ++corruption) {
+        std::vector<uint8_t> stream;
+        size_t event_count = 0;
+        for (size_t ii = 0; ii < PACKET_COUNT; ++ii) {
+            std::array<uint16_t, 16> channels {};
+            for (size_t jj = 0; jj < channels.size(); ++jj) {
+                channels[jj] = static_cast<uint16_t>((ii * 37 + jj * 101) % 2048);
+            }
+            ReceiverCrsf::packet_u packet = crsf_rc_channels_packet(channels);
+            std::vector<uint8_t> bytes(packet.data.begin(), packet.data.begin() + PACKET_SIZE);
+            if (ii % EVENT_INTERVAL == EVENT_INTERVAL / 2) {
+                ++event_count;
+                switch (corruption) {
+                case BIT_FLIP: bytes[10] ^= 0x04; break;
+                case LENGTH_LONGER: bytes[1] = 60; break;
+                case LENGTH_SHORTER: bytes[1] = 10; break;
+                case DROPPED_BYTE: bytes.erase(bytes.begin() + 12); break;
+                default: bytes.insert(bytes.begin(), ReceiverCrsf::CRSF_SYNC_BYTE); break;
+                }
+            }
+            stream.insert(stream.end(), bytes.begin(), bytes.end());
+        }
+
+        SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+        ReceiverCrsf receiver(serialPort);
+        CrsfFramerDiscarding discarding;
+        size_t received = 0;
+        size_t received_discarding = 0;
+        // replay in UART FIFO sized chunks
+        for (size_t ii = 0; ii < stream.size(); ii += 32) {
+            const size_t len = std::min(static_cast<size_t>(32), stream.size() - ii);
+            received += receiver.on_data_received(&stream[ii], len, 0);
+            received_discarding += discarding.on_data_received(&stream[ii], len);
+        }
+        const double lost = static_cast<double>(PACKET_COUNT - received) / static_cast<double>(event_count);
+        const double lost_discarding = static_cast<double>(PACKET_COUNT - received_discarding) / static_cast<double>(event_count);
+        printf("CRSF %-18s frames lost per event: resync %.2f, discarding %.2f\r\n", names[corruption], lost, lost_discarding);
+        // at most the corrupted frame is lost
+        TEST_ASSERT_TRUE(received >= PACKET_COUNT - event_count);
+        TEST_ASSERT_TRUE(received >= received_discarding);
+    }
+}
+
+void test_receiver_crsf_subset_channels()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+
+    ReceiverCrsf::packet_u packet = crsf_rc_channels_packet({ 172, 992, 1811, 992, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 1811 });
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], 26, 0));
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+
+    // 11-bit subset of channels 5 to 7, the other channels are unchanged
+    packet = crsf_subset_rc_channels_packet(5, 11, { 0, 1024, 2047 });
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], crsf_packet_size(packet), 0));
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    TEST_ASSERT_EQUAL(988, receiver.get_channel_pwm(0));
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(1));
+    TEST_ASSERT_EQUAL(2012, receiver.get_channel_pwm(2));
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(3));
+    TEST_ASSERT_EQUAL(988, receiver.get_channel_pwm(4));
+    TEST_ASSERT_EQUAL(988, receiver.get_channel_pwm(5));
+    TEST_ASSERT_EQUAL(988 + 512, receiver.get_channel_pwm(6));
+    TEST_ASSERT_EQUAL(988 + 1023, receiver.get_channel_pwm(7));
+    TEST_ASSERT_EQUAL(988, receiver.get_channel_pwm(8));
+    TEST_ASSERT_EQUAL(2012, receiver.get_channel_pwm(15));
+
+    // a full RC channels packet overwrites the subset channels
+    packet = crsf_rc_channels_packet({ 172, 992, 1811, 992, 172, 992, 992, 992, 172, 172, 172, 172, 172, 172, 172, 1811 });
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], 26, 0));
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(5));
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(6));
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(7));
+}
+
+void test_receiver_crsf_subset_channels_resolution()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+
+    for (unsigned resolution = 10; resolution <= 13; ++resolution) {
+        const uint16_t max = static_cast<uint16_t>((1U << resolution) - 1U);
+        const uint16_t mid = static_cast<uint16_t>(1U << (resolution - 1U));
+        // channel counts that do and do not fill a whole number of bytes
+        for (size_t count = 1; count <= 16; ++count) {
+            std::vector<uint16_t> channels(count);
+            for (size_t ii = 0; ii < count; ++ii) {
+                channels[ii] = (ii % 3 == 0) ? 0 : (ii % 3 == 1) ? mid : max;
+            }
+            const ReceiverCrsf::packet_u packet = crsf_subset_rc_channels_packet(static_cast<uint8_t>(16 - count), resolution, channels);
+            TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], crsf_packet_size(packet), 0));
+            TEST_ASSERT_TRUE(receiver.unpack_packet());
+            for (size_t ii = 0; ii < count; ++ii) {
+                const uint16_t expected = static_cast<uint16_t>(988 + (channels[ii] >> (resolution - 10)));
+                TEST_ASSERT_EQUAL(expected, receiver.get_channel_pwm(16 - count + ii));
+            }
+        }
+        // full range maps to [988,2011] for all resolutions
+        TEST_ASSERT_EQUAL(2011, receiver.get_channel_pwm(15 - 1));
+        TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(15 - 2));
+        TEST_ASSERT_EQUAL(988, receiver.get_channel_pwm(15 - 3));
+    }
+}
+
+void test_receiver_crsf_subset_channels_out_of_range()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+
+    ReceiverCrsf::packet_u packet = crsf_rc_channels_packet({ 172, 992, 1811, 992, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172 });
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], 26, 0));
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+
+    // channels beyond the last channel are ignored
+    packet = crsf_subset_rc_channels_packet(14, 12, { 4095, 4095, 4095, 4095 });
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], crsf_packet_size(packet), 0));
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    TEST_ASSERT_EQUAL(988, receiver.get_channel_pwm(13));
+    TEST_ASSERT_EQUAL(2011, receiver.get_channel_pwm(14));
+    TEST_ASSERT_EQUAL(2011, receiver.get_channel_pwm(15));
+    TEST_ASSERT_EQUAL(ReceiverBase::CHANNEL_LOW, receiver.get_channel_pwm(16));
+
+    // starting channel out of range, packet is rejected
+    packet = crsf_subset_rc_channels_packet(16, 11, { 0, 0 });
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], crsf_packet_size(packet), 0));
+    TEST_ASSERT_FALSE(receiver.unpack_packet());
+    TEST_ASSERT_EQUAL(2011, receiver.get_channel_pwm(15));
+}
+
+void test_receiver_crsf_subset_channels_too_short()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+
+    ReceiverCrsf::packet_u packet = crsf_rc_channels_packet({ 172, 992, 1811, 992, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172 });
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], 26, 0));
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+
+    // subset packets with a valid CRC, but with no configuration byte (length 2) or no channel data (length 3), are rejected
+    for (uint8_t length = 2; length <= 3; ++length) {
+        packet = ReceiverCrsf::packet_u {};
+        packet.value.sync = ReceiverCrsf::CRSF_SYNC_BYTE;
+        packet.value.length = length;
+        packet.value.type = ReceiverCrsf::FRAMETYPE_SUBSET_RC_CHANNELS_PACKED;
+        packet.value.payload[0] = 0xFF; // configuration byte, or stale data if length is 2
+        packet.value.payload[length - 2] = ReceiverCrsf::calculate_crc(packet);
+        TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], crsf_packet_size(packet), 0));
+        TEST_ASSERT_FALSE(receiver.unpack_packet());
+        TEST_ASSERT_EQUAL(988, receiver.get_channel_pwm(0));
+        TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(1));
+        TEST_ASSERT_EQUAL(2012, receiver.get_channel_pwm(2));
+        for (size_t ii = 4; ii < ReceiverCrsf::CHANNEL_COUNT; ++ii) {
+            TEST_ASSERT_EQUAL(988, receiver.get_channel_pwm(ii));
+        }
+    }
+}
+
+void test_receiver_crsf_subset_channels_controls()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+
+    ReceiverCrsf::packet_u packet = crsf_rc_channels_packet({ 172, 992, 1811, 992, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172 });
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], 26, 0));
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    receiver_controls_pwm_t controls = receiver.get_controls_pwm();
+    // channels are AETR: roll, pitch, throttle, yaw
+    TEST_ASSERT_EQUAL(988, controls.roll);
+    TEST_ASSERT_EQUAL(1500, controls.pitch);
+    TEST_ASSERT_EQUAL(2012, controls.throttle);
+    TEST_ASSERT_EQUAL(1500, controls.yaw);
+
+    // 13-bit subset of the sticks
+    packet = crsf_subset_rc_channels_packet(0, 13, { 4096, 8191, 0, 2048 });
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], crsf_packet_size(packet), 0));
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    controls = receiver.get_controls_pwm();
+    TEST_ASSERT_EQUAL(1500, controls.roll);
+    TEST_ASSERT_EQUAL(2011, controls.pitch);
+    TEST_ASSERT_EQUAL(988, controls.throttle);
+    TEST_ASSERT_EQUAL(1244, controls.yaw);
+    const receiver_controls_q12dot4_t expected = ReceiverBase::controls_q12dot4_from_pwm(controls);
+    const receiver_controls_q12dot4_t controls_q12dot4 = receiver.get_controls_q12dot4();
+    TEST_ASSERT_EQUAL(expected.throttle, controls_q12dot4.throttle);
+    TEST_ASSERT_EQUAL(expected.roll, controls_q12dot4.roll);
+    TEST_ASSERT_EQUAL(expected.pitch, controls_q12dot4.pitch);
+    TEST_ASSERT_EQUAL(expected.yaw, controls_q12dot4.yaw);
+}
+
+static ReceiverCrsf::packet_u crsf_speed_proposal_packet(uint8_t port_id, uint32_t baudrate)
+{
+    ReceiverCrsf::packet_u packet {};
+    packet.value.sync = ReceiverCrsf::CRSF_SYNC_BYTE;
+    packet.value.length = 12; // type + 10 payload bytes + CRC
+    packet.value.type = ReceiverCrsf::FRAMETYPE_COMMAND;
+    packet.value.payload = {
+        ReceiverCrsf::ADDRESS_FLIGHT_CONTROLLER,
+        ReceiverCrsf::ADDRESS_CRSF_RECEIVER,
+        ReceiverCrsf::COMMAND_SUBCMD_GENERAL,
+        ReceiverCrsf::COMMAND_SUBCMD_GENERAL_CRSF_SPEED_PROPOSAL,
+        port_id,
+        static_cast<uint8_t>(baudrate >> 24U),
+        static_cast<uint8_t>(baudrate >> 16U),
+        static_cast<uint8_t>(baudrate >> 8U),
+        static_cast<uint8_t>(baudrate)
+    };
+    packet.value.payload[9] = ReceiverCrsf::calculate_command_crc(packet);
+    packet.value.payload[10] = ReceiverCrsf::calculate_crc(packet);
+    return packet;
+}
+
+void test_receiver_crsf_speed_response_packet()
+{
+    const ReceiverCrsf::packet_u packet = ReceiverCrsf::speed_response_packet(1, true);
+    TEST_ASSERT_EQUAL(ReceiverCrsf::CRSF_SYNC_BYTE, packet.value.sync);
+    TEST_ASSERT_EQUAL(9, packet.value.length);
+    TEST_ASSERT_EQUAL(ReceiverCrsf::FRAMETYPE_COMMAND, packet.value.type);
+    TEST_ASSERT_EQUAL(ReceiverCrsf::ADDRESS_CRSF_RECEIVER, packet.value.payload[0]);
+    TEST_ASSERT_EQUAL(ReceiverCrsf::ADDRESS_FLIGHT_CONTROLLER, packet.value.payload[1]);
+    TEST_ASSERT_EQUAL(ReceiverCrsf::COMMAND_SUBCMD_GENERAL, packet.value.payload[2]);
+    TEST_ASSERT_EQUAL(ReceiverCrsf::COMMAND_SUBCMD_GENERAL_CRSF_SPEED_RESPONSE, packet.value.payload[3]);
+    TEST_ASSERT_EQUAL(1, packet.value.payload[4]);
+    TEST_ASSERT_EQUAL(1, packet.value.payload[5]);
+    TEST_ASSERT_EQUAL(ReceiverCrsf::calculate_command_crc(packet), ReceiverCrsf::get_received_command_crc(packet));
+    TEST_ASSERT_EQUAL(ReceiverCrsf::calculate_crc(packet), ReceiverCrsf::get_received_crc(packet));
+
+    const ReceiverCrsf::packet_u rejected = ReceiverCrsf::speed_response_packet(1, false);
+    TEST_ASSERT_EQUAL(0, rejected.value.payload[5]);
+    TEST_ASSERT_EQUAL(ReceiverCrsf::calculate_crc(rejected), ReceiverCrsf::get_received_crc(rejected));
+
+    TEST_ASSERT_TRUE(ReceiverCrsf::is_baudrate_supported(ReceiverCrsf::BAUD_RATE));
+    TEST_ASSERT_TRUE(ReceiverCrsf::is_baudrate_supported(ReceiverCrsf::BAUD_RATE_UNOFFICIAL));
+    TEST_ASSERT_TRUE(ReceiverCrsf::is_baudrate_supported(921600));
+    TEST_ASSERT_TRUE(ReceiverCrsf::is_baudrate_supported(2000000));
+    TEST_ASSERT_FALSE(ReceiverCrsf::is_baudrate_supported(115200));
+    TEST_ASSERT_FALSE(ReceiverCrsf::is_baudrate_supported(2470000));
+    TEST_ASSERT_FALSE(ReceiverCrsf::is_baudrate_supported(1234567));
+}
+
+void test_receiver_crsf_speed_negotiation()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, ReceiverCrsf::BAUD_RATE, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+    TEST_ASSERT_EQUAL(ReceiverCrsf::TIME_NEEDED_PER_FRAME_US, receiver.get_time_needed_per_frame_us());
+
+    ReceiverCrsf::packet_u packet = crsf_speed_proposal_packet(0, 2000000);
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], crsf_packet_size(packet), 0));
+    TEST_ASSERT_TRUE(receiver.unpack_other_packet());
+    // the response has been sent, but the baudrate is not changed until the next update
+    TEST_ASSERT_EQUAL(ReceiverCrsf::SPEED_NEGOTIATION_RESPONSE_SENT, receiver.get_speed_negotiation_state());
+    TEST_ASSERT_EQUAL(ReceiverCrsf::BAUD_RATE, serialPort.get_baudrate());
+
+    receiver.update_baudrate(1000);
+    TEST_ASSERT_EQUAL(ReceiverCrsf::SPEED_NEGOTIATION_CONFIRMING, receiver.get_speed_negotiation_state());
+    TEST_ASSERT_EQUAL(2000000, serialPort.get_baudrate());
+    TEST_ASSERT_EQUAL(1750 * 416666 / 2000000, receiver.get_time_needed_per_frame_us());
+
+    // receiving a valid packet at the new baudrate confirms it
+    packet = crsf_rc_channels_packet({ 172, 992, 1811, 992, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172, 172 });
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], 26, 2000));
+    receiver.update_baudrate(3000);
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    TEST_ASSERT_EQUAL(ReceiverCrsf::SPEED_NEGOTIATION_IDLE, receiver.get_speed_negotiation_state());
+    receiver.update_baudrate(1000 + ReceiverCrsf::BAUD_RATE_FALLBACK_TIMEOUT_US + 1);
+    TEST_ASSERT_EQUAL(2000000, serialPort.get_baudrate());
+    TEST_ASSERT_EQUAL(0, receiver.get_baudrate_fallback_count());
+
+    // unsupported baudrate is rejected
+    packet = crsf_speed_proposal_packet(0, 115200);
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], crsf_packet_size(packet), 4000));
+    TEST_ASSERT_TRUE(receiver.unpack_other_packet());
+    TEST_ASSERT_EQUAL(ReceiverCrsf::SPEED_NEGOTIATION_IDLE, receiver.get_speed_negotiation_state());
+    TEST_ASSERT_EQUAL(2000000, serialPort.get_baudrate());
+
+    // proposal with bad command CRC is ignored
+    packet = crsf_speed_proposal_packet(0, 921600);
+    packet.value.payload[9] ^= 0xFF;
+    packet.value.payload[10] = ReceiverCrsf::calculate_crc(packet);
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], crsf_packet_size(packet), 5000));
+    TEST_ASSERT_TRUE(receiver.unpack_other_packet());
+    TEST_ASSERT_EQUAL(ReceiverCrsf::SPEED_NEGOTIATION_IDLE, receiver.get_speed_negotiation_state());
+}
+
+void test_receiver_crsf_speed_negotiation_fallback()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, ReceiverCrsf::BAUD_RATE, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serialPort);
+
+    const ReceiverCrsf::packet_u packet = crsf_speed_proposal_packet(0, 1000000);
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet.data[0], crsf_packet_size(packet), 0));
+    TEST_ASSERT_TRUE(receiver.unpack_other_packet());
+    receiver.update_baudrate(1000);
+    TEST_ASSERT_EQUAL(1000000, serialPort.get_baudrate());
+    TEST_ASSERT_EQUAL(1750 * 416666 / 1000000, receiver.get_time_needed_per_frame_us());
+
+    // no packets received, so stay at new baudrate until the timeout
+    receiver.update_baudrate(1000 + ReceiverCrsf::BAUD_RATE_FALLBACK_TIMEOUT_US);
+    TEST_ASSERT_EQUAL(ReceiverCrsf::SPEED_NEGOTIATION_CONFIRMING, receiver.get_speed_negotiation_state());
+    TEST_ASSERT_EQUAL(1000000, serialPort.get_baudrate());
+
+    receiver.update_baudrate(1000 + ReceiverCrsf::BAUD_RATE_FALLBACK_TIMEOUT_US + 1);
+    TEST_ASSERT_EQUAL(ReceiverCrsf::SPEED_NEGOTIATION_IDLE, receiver.get_speed_negotiation_state());
+    TEST_ASSERT_EQUAL(ReceiverCrsf::BAUD_RATE, serialPort.get_baudrate());
+    TEST_ASSERT_EQUAL(ReceiverCrsf::TIME_NEEDED_PER_FRAME_US, receiver.get_time_needed_per_frame_us());
+    TEST_ASSERT_EQUAL(1, receiver.get_baudrate_fallback_count());
+}
+
 // NOLINTEND(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
 
 int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
@@ -84,6 +737,26 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
     UNITY_BEGIN();
 
     RUN_TEST(test_receiver_crsf);
+    RUN_TEST(test_receiver_bind_packet);
+    RUN_TEST(test_receiver_crsf_crc8);
+    RUN_TEST(test_receiver_crsf_chunked_data);
+    RUN_TEST(test_receiver_crsf_frame_time);
+    RUN_TEST(test_receiver_crsf_invalid_length);
+    RUN_TEST(test_receiver_crsf_bad_crc);
+    RUN_TEST(test_receiver_crsf_stats_idle_gap);
+    RUN_TEST(test_receiver_crsf_map_to_pwm);
+    RUN_TEST(test_receiver_crsf_channels_follow_packets);
+    RUN_TEST(test_receiver_crsf_sync_byte_as_length);
+    RUN_TEST(test_receiver_crsf_resync_after_bad_length);
+    RUN_TEST(test_receiver_crsf_corrupted_stream);
+    RUN_TEST(test_receiver_crsf_subset_channels);
+    RUN_TEST(test_receiver_crsf_subset_channels_resolution);
+    RUN_TEST(test_receiver_crsf_subset_channels_out_of_range);
+    RUN_TEST(test_receiver_crsf_subset_channels_too_short);
+    RUN_TEST(test_receiver_crsf_subset_channels_controls);
+    RUN_TEST(test_receiver_crsf_speed_response_packet);
+    RUN_TEST(test_receiver_crsf_speed_negotiation);
+    RUN_TEST(test_receiver_crsf_speed_negotiation_fallback);
 
     UNITY_END();
 }
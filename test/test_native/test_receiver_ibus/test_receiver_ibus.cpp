@@ -1,5 +1,7 @@
 #include "receiver_ibus.h"
 
+#include "../ibus_test_packets.h"
+
 #include <unity.h>
 
 void setUp()
@@ -13,7 +15,7 @@ void tearDown()
 // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
 void test_receiver_ibus()
 {
-    static SerialPort serialPort(SerialPort::uart_pins_t{}, 0, 0, ReceiverIbus::DATA_BITS, ReceiverIbus::STOP_BITS, ReceiverIbus::PARITY);
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverIbus::DATA_BITS, ReceiverIbus::STOP_BITS, ReceiverIbus::PARITY);
     static ReceiverIbus receiver(serialPort);
 
     receiver.set_packet_empty();
@@ -67,6 +69,164 @@ void test_receiver_ibus()
     TEST_ASSERT_EQUAL(0x05DC, receiver.get_channel_pwm(13));
  }
 
+/*!
+ReceiverIbus that simulates the ISR publishing a new packet while the task is unpacking the previous one.
+*/
+class ReceiverIbusTest : public ReceiverIbus {
+public:
+    explicit ReceiverIbusTest(SerialPort& serialPort) : ReceiverIbus(serialPort) {}
+    void set_interrupting_packet(const std::array<uint8_t, 32>* packet) { _interrupting_packet = packet; }
+    int get_unpack_count() const { return _unpack_count; }
+    bool unpack_packet() override { return unpack_newest_packet<ReceiverIbusTest>(); }
+protected:
+    friend class ReceiverSerial;
+    bool unpack_packet_slot(size_t packet_index) {
+        ++_unpack_count;
+        if (_interrupting_packet != nullptr) {
+            const std::array<uint8_t, 32>* packet = _interrupting_packet;
+            _interrupting_packet = nullptr;
+            for (uint8_t data : *packet) {
+                on_data_received_from_isr(data);
+            }
+        }
+        return ReceiverIbus::unpack_packet_slot(packet_index);
+    }
+private:
+    const std::array<uint8_t, 32>* _interrupting_packet {nullptr};
+    int _unpack_count {0};
+};
+
+void test_receiver_ibus_torn_read()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverIbus::DATA_BITS, ReceiverIbus::STOP_BITS, ReceiverIbus::PARITY);
+    static ReceiverIbusTest receiver(serialPort);
+
+    static const std::array<uint8_t, 32> packet1 = {
+        0x20, 0x40, 0xDB, 0x05, 0xDC, 0x05, 0x54, 0x05,
+        0xDC, 0x05, 0xE8, 0x03, 0xD0, 0x07, 0xD2, 0x05,
+        0xE8, 0x03, 0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05,
+        0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05, 0x80, 0x4F
+    };
+    // packet1 with channel 0 changed from 0x05DB to 0x05DA, and checksum adjusted accordingly
+    static const std::array<uint8_t, 32> packet2 = {
+        0x20, 0x40, 0xDA, 0x05, 0xDC, 0x05, 0x54, 0x05,
+        0xDC, 0x05, 0xE8, 0x03, 0xD0, 0x07, 0xD2, 0x05,
+        0xE8, 0x03, 0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05,
+        0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05, 0x7F, 0x4F
+    };
+
+    for (uint8_t data : packet1) {
+        receiver.on_data_received_from_isr(data);
+    }
+    TEST_ASSERT_EQUAL(1, receiver.get_packet_sequence());
+
+    // packet2 arrives while packet1 is being unpacked, so the read is retried and packet2 is unpacked
+    receiver.set_interrupting_packet(&packet2);
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    TEST_ASSERT_EQUAL(2, receiver.get_unpack_count());
+    TEST_ASSERT_EQUAL(2, receiver.get_packet_sequence());
+    TEST_ASSERT_TRUE(receiver.is_packet_empty());
+    TEST_ASSERT_EQUAL(0x05DA, receiver.get_channel_pwm(0));
+    TEST_ASSERT_EQUAL(0x05DC, receiver.get_channel_pwm(1));
+}
+
+void test_receiver_ibus_bad_checksum()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverIbus::DATA_BITS, ReceiverIbus::STOP_BITS, ReceiverIbus::PARITY);
+    static ReceiverIbus receiver(serialPort);
+
+    std::array<uint8_t, 32> packet = {
+        0x20, 0x40, 0xDB, 0x05, 0xDC, 0x05, 0x54, 0x05,
+        0xDC, 0x05, 0xE8, 0x03, 0xD0, 0x07, 0xD2, 0x05,
+        0xE8, 0x03, 0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05,
+        0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05, 0x80, 0x4F
+    };
+    // corrupt channel 3
+    packet[9] = 0x06;
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&packet[0], packet.size(), 0));
+    TEST_ASSERT_EQUAL(0, receiver.get_packet_index());
+    TEST_ASSERT_EQUAL(1, receiver.get_error_packet_count());
+    TEST_ASSERT_EQUAL(0, receiver.get_packet_sequence());
+
+    // valid packet, received in two parts
+    packet[9] = 0x05;
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&packet[0], 7, 0));
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet[7], packet.size() - 7, 0));
+    TEST_ASSERT_EQUAL(1, receiver.get_error_packet_count());
+    TEST_ASSERT_EQUAL(1, receiver.get_packet_sequence());
+
+    receiver_stats_t stats {};
+    TEST_ASSERT_TRUE(receiver.get_stats(stats));
+    TEST_ASSERT_EQUAL(1, stats.valid_frame_count);
+    TEST_ASSERT_EQUAL(1, stats.crc_error_count);
+    TEST_ASSERT_EQUAL(0, stats.framing_error_count);
+    TEST_ASSERT_EQUAL(0, stats.resync_count);
+    TEST_ASSERT_EQUAL(64, stats.byte_count);
+}
+
+void test_receiver_ibus_stats()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverIbus::DATA_BITS, ReceiverIbus::STOP_BITS, ReceiverIbus::PARITY);
+    static ReceiverIbus receiver(serialPort);
+
+    const std::array<uint8_t, 32> packet = {
+        0x20, 0x40, 0xDB, 0x05, 0xDC, 0x05, 0x54, 0x05,
+        0xDC, 0x05, 0xE8, 0x03, 0xD0, 0x07, 0xD2, 0x05,
+        0xE8, 0x03, 0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05,
+        0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05, 0x80, 0x4F
+    };
+    // packets 7ms apart, the idle gap between them is not a drop
+    time_us32_t time = 10000;
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet[0], packet.size(), time));
+    time += 7000;
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet[0], packet.size(), time));
+    TEST_ASSERT_EQUAL(0, receiver.get_dropped_packet_count());
+
+    // a packet cut short by a gap is dropped and is a framing error, and the noise before the next packet is a resync
+    time += 7000;
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&packet[0], 16, time));
+    time += 7000;
+    const std::array<uint8_t, 2> noise = { 0x00, 0x01 };
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&noise[0], noise.size(), time));
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet[0], packet.size(), time));
+    TEST_ASSERT_EQUAL(1, receiver.get_dropped_packet_count());
+
+    receiver_stats_t stats {};
+    TEST_ASSERT_TRUE(receiver.get_stats(stats));
+    TEST_ASSERT_EQUAL(3, stats.valid_frame_count);
+    TEST_ASSERT_EQUAL(0, stats.crc_error_count);
+    TEST_ASSERT_EQUAL(1, stats.framing_error_count);
+    TEST_ASSERT_EQUAL(1, stats.resync_count);
+    TEST_ASSERT_EQUAL(3*32 + 16 + 2, stats.byte_count);
+}
+
+void test_receiver_ibus_channels_follow_packets()
+{
+    // with lazy channel decoding the auxiliary channels must be decoded from the current packet, not the one they were first read from
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverIbus::DATA_BITS, ReceiverIbus::STOP_BITS, ReceiverIbus::PARITY);
+    static ReceiverIbus receiver(serialPort);
+
+    auto packet = ibus_packet({ 1000, 1500, 2000, 1500, 1100, 1200, 1300, 1400, 1500, 1600, 1700, 1800, 1900, 2000, 1000, 1234, 1500, 2000 });
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet[0], packet.size(), 0));
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    TEST_ASSERT_EQUAL(1000, receiver.get_channel_pwm(0));
+    TEST_ASSERT_EQUAL(1200, receiver.get_channel_pwm(5));
+    TEST_ASSERT_EQUAL(1234, receiver.get_channel_pwm(15));
+
+    packet = ibus_packet({ 1500, 1000, 1500, 2000, 2000, 1900, 1800, 1700, 1600, 1500, 1400, 1300, 1200, 1100, 2000, 1111, 1000, 1500 });
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet[0], packet.size(), 0));
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(0));
+    TEST_ASSERT_EQUAL(2000, receiver.get_channel_pwm(3));
+    TEST_ASSERT_EQUAL(2000, receiver.get_auxiliary_channel(0));
+    TEST_ASSERT_EQUAL(1900, receiver.get_channel_pwm(5));
+    TEST_ASSERT_EQUAL(1100, receiver.get_channel_pwm(13));
+    TEST_ASSERT_EQUAL(2000, receiver.get_channel_pwm(14));
+    TEST_ASSERT_EQUAL(1111, receiver.get_channel_pwm(15));
+    TEST_ASSERT_EQUAL(1000, receiver.get_channel_pwm(16));
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(17));
+}
+
 // NOLINTEND(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
 
 int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
@@ -74,6 +234,10 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
     UNITY_BEGIN();
 
     RUN_TEST(test_receiver_ibus);
+    RUN_TEST(test_receiver_ibus_torn_read);
+    RUN_TEST(test_receiver_ibus_bad_checksum);
+    RUN_TEST(test_receiver_ibus_stats);
+    RUN_TEST(test_receiver_ibus_channels_follow_packets);
 
     UNITY_END();
 }
@@ -0,0 +1,209 @@
+#include "receiver_crsf.h"
+
+#include "../crsf_test_packets.h"
+
+#include <cstdio>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
+/*!
+Simulation of time based receiver task scheduling: a 1kHz CRSF (ELRS) link read by a receiver task that runs every 4ms.
+
+Each frame is 26 bytes, which take 282us at 921600 baud, and frame `n` starts at `n*1000 + 100` us.
+The bytes are pushed into the serial port receive buffer at the time they arrive, as the UART ISR does,
+and the task drains the buffer every TASK_INTERVAL_US.
+
+All the frames are valid, so the frame unpacked by update() is frame (packet sequence - 1), and its age is the time since its last byte arrived.
+*/
+enum { FRAME_INTERVAL_US = 1000, FRAME_START_US = 100, FRAME_SIZE = 26, BAUDRATE = 921600, TASK_INTERVAL_US = 4000 };
+
+static ReceiverCrsf::packet_u crsf_link_statistics_packet()
+{
+    ReceiverCrsf::packet_u packet {};
+    packet.value.sync = ReceiverCrsf::CRSF_SYNC_BYTE;
+    packet.value.length = 12; // type + 10 bytes of link statistics + CRC
+    packet.value.type = ReceiverCrsf::FRAMETYPE_LINK_STATISTICS;
+    for (size_t ii = 0; ii < 10; ++ii) {
+        packet.value.payload[ii] = static_cast<uint8_t>(ii + 1);
+    }
+    packet.value.payload[10] = ReceiverCrsf::calculate_crc(packet);
+    return packet;
+}
+
+static time_us32_t byte_arrival_time(uint32_t frame, size_t index)
+{
+    // 10 bits per byte, 8N1
+    return frame * FRAME_INTERVAL_US + FRAME_START_US + static_cast<time_us32_t>((index + 1) * 10 * 1'000'000 / BAUDRATE);
+}
+
+/*!
+Serial link that pushes the bytes of the frame stream into the serial port's receive buffer as they arrive.
+*/
+class CrsfLink {
+public:
+    explicit CrsfLink(SerialPort& serial_port) : _serial_port(serial_port), _packet(crsf_rc_channels_packet(992)) {}
+    void run_until(time_us32_t time) {
+        while (byte_arrival_time(_frame, _index) <= time) {
+            _serial_port.push_from_isr(&_packet.data[_index], 1, byte_arrival_time(_frame, _index));
+            ++_index;
+            if (_index == FRAME_SIZE) {
+                _index = 0;
+                ++_frame;
+            }
+        }
+    }
+private:
+    SerialPort& _serial_port;
+    ReceiverCrsf::packet_u _packet;
+    uint32_t _frame {};
+    size_t _index {};
+};
+
+//! As ReceiverTask::drain_receiver() does: consume every available byte, so the latest frame wins.
+static void drain_latest_frame_wins(ReceiverSerial& receiver, time_us32_t time)
+{
+    std::array<uint8_t, 64> buf {};
+    size_t len = 0;
+    while ((len = receiver.read(&buf[0], buf.size())) > 0) {
+        receiver.on_data_received(&buf[0], len, time);
+    }
+}
+
+//! As drain_latest_frame_wins(), but the bytes are given their arrival time, rather than the time they are drained, as ReceiverTask::drain_receiver() does.
+static void drain_with_receive_time(ReceiverSerial& receiver)
+{
+    std::array<uint8_t, 64> buf {};
+    size_t len = 0;
+    while ((len = receiver.read(&buf[0], buf.size())) > 0) {
+        receiver.on_data_received(&buf[0], len, receiver.get_receive_time_us());
+    }
+}
+
+//! For comparison: stop draining at the first complete frame, leaving any newer frames in the receive buffer.
+static void drain_first_frame_wins(ReceiverSerial& receiver, time_us32_t time)
+{
+    uint8_t value = 0;
+    while (receiver.read(&value, 1) > 0) {
+        if (receiver.on_data_received(&value, 1, time) != 0) {
+            break;
+        }
+    }
+}
+
+static time_us32_t delivered_frame_age(const ReceiverSerial& receiver, time_us32_t time)
+{
+    const uint32_t frame = receiver.get_packet_sequence() - 1;
+    return time - byte_arrival_time(frame, FRAME_SIZE - 1);
+}
+
+void test_receiver_latest_frame_wins()
+{
+    static SerialPort serial_port(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, BAUDRATE, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serial_port);
+    CrsfLink link(serial_port);
+
+    printf("latest frame wins: 1kHz CRSF, %ums task interval\r\n", TASK_INTERVAL_US / 1000);
+    receiver_stats_t stats {};
+    for (uint32_t tick = 1; tick <= 10; ++tick) {
+        const time_us32_t time = tick * TASK_INTERVAL_US;
+        link.run_until(time);
+        drain_latest_frame_wins(receiver, time);
+        TEST_ASSERT_TRUE(receiver.update(0));
+        const time_us32_t age = delivered_frame_age(receiver, time);
+        TEST_ASSERT_TRUE(receiver.get_stats(stats));
+        printf("tick %2u: frame %2u delivered, age %5uus, superseded %2u\r\n", tick, receiver.get_packet_sequence() - 1, age, stats.superseded_frame_count);
+        // the newest complete frame is delivered, the frame after it is still being received
+        TEST_ASSERT_EQUAL(FRAME_INTERVAL_US - FRAME_START_US - 282, age);
+        TEST_ASSERT_EQUAL(0, serial_port.get_rx_buffer_available());
+    }
+    // 4 frames are received each tick, the newest is delivered and the other 3 are superseded
+    TEST_ASSERT_EQUAL(40, stats.valid_frame_count);
+    TEST_ASSERT_EQUAL(30, stats.superseded_frame_count);
+    TEST_ASSERT_EQUAL(0, stats.overrun_count);
+}
+
+void test_receiver_frame_age_includes_time_in_receive_buffer()
+{
+    static SerialPort serial_port(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, BAUDRATE, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serial_port);
+    CrsfLink link(serial_port);
+
+    for (uint32_t tick = 1; tick <= 10; ++tick) {
+        const time_us32_t time = tick * TASK_INTERVAL_US;
+        link.run_until(time);
+        drain_with_receive_time(receiver);
+        TEST_ASSERT_TRUE(receiver.update(0));
+        // the frame's last byte is stamped with the time it was pushed into the receive buffer, not the time it was drained
+        TEST_ASSERT_EQUAL(byte_arrival_time(receiver.get_packet_sequence() - 1, FRAME_SIZE - 1), receiver.get_frame_time().last_byte_us);
+        TEST_ASSERT_EQUAL(delivered_frame_age(receiver, time), receiver.get_frame_age_us(time));
+    }
+}
+
+void test_receiver_first_frame_wins()
+{
+    static SerialPort serial_port(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, BAUDRATE, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serial_port);
+    CrsfLink link(serial_port);
+
+    printf("first frame wins: 1kHz CRSF, %ums task interval\r\n", TASK_INTERVAL_US / 1000);
+    // the backlog overflows the receive buffer on the third tick, so there is no point running any longer
+    for (uint32_t tick = 1; tick <= 3; ++tick) {
+        const time_us32_t time = tick * TASK_INTERVAL_US;
+        link.run_until(time);
+        drain_first_frame_wins(receiver, time);
+        TEST_ASSERT_TRUE(receiver.update(0));
+        const time_us32_t age = delivered_frame_age(receiver, time);
+        printf("tick %2u: frame %2u delivered, age %5uus, backlog %3u bytes\r\n", tick, receiver.get_packet_sequence() - 1, age, static_cast<unsigned>(serial_port.get_rx_buffer_available()));
+        // one frame is delivered per tick, but four arrive, so the delivered frame gets 3ms older every tick
+        TEST_ASSERT_EQUAL(tick - 1, receiver.get_packet_sequence() - 1);
+        TEST_ASSERT_EQUAL(3000*tick + FRAME_INTERVAL_US - FRAME_START_US - 282, age);
+    }
+    TEST_ASSERT_TRUE(serial_port.get_rx_overrun_count() > 0);
+}
+void test_receiver_latest_frame_wins_interleaved_link_statistics()
+{
+    static SerialPort serial_port(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, BAUDRATE, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf receiver(serial_port);
+    const ReceiverCrsf::packet_u link_statistics = crsf_link_statistics_packet();
+
+    for (uint32_t tick = 1; tick <= 10; ++tick) {
+        // each RC channels frame is followed by a link statistics frame, and 4 of each arrive per tick
+        for (uint16_t ii = 0; ii < 4; ++ii) {
+            const ReceiverCrsf::packet_u rc_channels = crsf_rc_channels_packet(static_cast<uint16_t>(172 + 100*ii));
+            serial_port.push_from_isr(&rc_channels.data[0], FRAME_SIZE);
+            serial_port.push_from_isr(&link_statistics.data[0], link_statistics.value.length + 2U);
+        }
+        drain_latest_frame_wins(receiver, tick * TASK_INTERVAL_US);
+        // the newest RC channels frame is delivered, even though a link statistics frame arrived after it
+        TEST_ASSERT_TRUE(receiver.update(0));
+        TEST_ASSERT_EQUAL(ReceiverCrsf::map_to_pwm(472), receiver.get_channel_pwm(ReceiverBase::ROLL));
+        TEST_ASSERT_EQUAL(4*tick, receiver.get_packet_sequence());
+        TEST_ASSERT_EQUAL(4*tick, receiver.get_other_packet_sequence());
+    }
+    receiver_stats_t stats {};
+    TEST_ASSERT_TRUE(receiver.get_stats(stats));
+    TEST_ASSERT_EQUAL(80, stats.valid_frame_count);
+    // only the older RC channels frames are superseded, the link statistics frames are not counted
+    TEST_ASSERT_EQUAL(30, stats.superseded_frame_count);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_receiver_latest_frame_wins);
+    RUN_TEST(test_receiver_frame_age_includes_time_in_receive_buffer);
+    RUN_TEST(test_receiver_first_frame_wins);
+    RUN_TEST(test_receiver_latest_frame_wins_interleaved_link_statistics);
+
+    UNITY_END();
+}
@@ -0,0 +1,113 @@
+#include "cockpit_base.h"
+#include "receiver_crsf.h"
+#include "receiver_pipeline.h"
+#include "receiver_sbus.h"
+
+#include "../crsf_test_packets.h"
+
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
+struct receiver_context_t {
+    int id;
+};
+
+class CockpitTest final : public CockpitBase {
+public:
+    void update_controls(uint32_t tick_count, uint32_t frame_age_us, const ReceiverBase& receiver, receiver_context_t& ctx) override {
+        (void)tick_count;
+        (void)frame_age_us;
+        (void)ctx;
+        _controls_pwm = receiver.get_controls_pwm();
+        ++_update_controls_count;
+    }
+    void check_failsafe(uint32_t tick_count, receiver_context_t& ctx) override {
+        (void)tick_count;
+        (void)ctx;
+        ++_check_failsafe_count;
+    }
+public:
+    receiver_controls_pwm_t _controls_pwm {};
+    int _update_controls_count {};
+    int _check_failsafe_count {};
+};
+
+void test_receiver_serial_t_isr()
+{
+    static SerialPort serial_port(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_1, ReceiverCrsf::BAUD_RATE, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverSerialT<ReceiverCrsf> receiver(serial_port);
+    static CockpitTest cockpit;
+    static receiver_context_t context {};
+    ReceiverTaskT<ReceiverSerialT<ReceiverCrsf>, CockpitTest> receiver_task(0, receiver, cockpit, context);
+
+    // no packet, so the cockpit checks failsafe
+    receiver_task.loop();
+    TEST_ASSERT_EQUAL(0, cockpit._update_controls_count);
+    TEST_ASSERT_EQUAL(1, cockpit._check_failsafe_count);
+
+    // the UART interrupt gives the data to the receiver via its own serial port watcher
+    const ReceiverCrsf::packet_u packet = crsf_rc_channels_packet(992);
+    TEST_ASSERT_EQUAL(16, serial_port.receive_into_uart_fifo(&packet.data[0], 16));
+    SerialPort::data_ready_isr(SerialPort::UART_INDEX_1);
+    TEST_ASSERT_EQUAL(10, serial_port.receive_into_uart_fifo(&packet.data[16], 10));
+    SerialPort::data_ready_isr(SerialPort::UART_INDEX_1);
+    receiver_task.drain_receiver();
+    TEST_ASSERT_EQUAL(1, receiver.get_packet_sequence());
+
+    receiver_task.loop();
+    TEST_ASSERT_EQUAL(1, cockpit._update_controls_count);
+    TEST_ASSERT_EQUAL(ReceiverBase::CHANNEL_MIDDLE, cockpit._controls_pwm.roll);
+    TEST_ASSERT_EQUAL(ReceiverBase::CHANNEL_MIDDLE, cockpit._controls_pwm.yaw);
+    TEST_ASSERT_EQUAL(0, receiver.get_error_packet_count());
+}
+
+void test_receiver_serial_t_is_receiver_base()
+{
+    static SerialPort serial_port(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_3, ReceiverSbus::BAUD_RATE, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    static ReceiverSerialT<ReceiverSbus> receiver(serial_port);
+    static CockpitTest cockpit;
+    static receiver_context_t context {};
+
+    std::array<uint8_t, 25> packet {};
+    packet[0] = ReceiverSbus::SBUS_START_BYTE;
+    packet[24] = ReceiverSbus::SBUS_END_BYTE;
+
+    // the compile-time receiver also works through the virtual interface, eg with the runtime ReceiverTask
+    ReceiverBase& receiver_base = receiver;
+    for (uint8_t data : packet) {
+        receiver_base.on_data_received_from_isr(data);
+    }
+    TEST_ASSERT_EQUAL(1, receiver.get_packet_sequence());
+    ReceiverTask receiver_task(0, receiver, cockpit, context);
+    receiver_task.loop();
+    TEST_ASSERT_EQUAL(1, cockpit._update_controls_count);
+    TEST_ASSERT_EQUAL(receiver.get_channel_pwm(ReceiverBase::ROLL), cockpit._controls_pwm.roll);
+
+    // the serial port watcher can be reattached, eg after another receiver has used the serial port
+    static ReceiverSbus other_receiver(serial_port);
+    receiver.attach_serial_port_watcher();
+    for (uint8_t data : packet) {
+        serial_port.on_data_received_from_isr(data);
+    }
+    TEST_ASSERT_EQUAL(2, receiver.get_packet_sequence());
+    TEST_ASSERT_EQUAL(0, other_receiver.get_packet_sequence());
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_receiver_serial_t_isr);
+    RUN_TEST(test_receiver_serial_t_is_receiver_base);
+
+    UNITY_END();
+}
@@ -1,5 +1,9 @@
 #include "receiver_sbus.h"
 
+#include "../sbus_test_packets.h"
+
+#include <algorithm>
+#include <bit>
 #include <unity.h>
 
 void setUp()
@@ -13,13 +17,422 @@ void tearDown()
 // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
 void test_receiver_sbus()
 {
-    static SerialPort serialPort(SerialPort::uart_pins_t{}, 0, 0, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
     static ReceiverSbus receiver(serialPort);
 
     receiver.set_packet_empty();
     TEST_ASSERT_TRUE(receiver.is_packet_empty());
 }
 
+void test_receiver_sbus_packet_handoff()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    static ReceiverSbus receiver(serialPort);
+
+    // 192 maps to 1000, 992 maps to 1500, 1792 maps to 2000
+    const auto packet1 = sbus_packet({ 192, 992, 1792, 992, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192 }, 0x01);
+    const auto packet2 = sbus_packet({ 992, 192, 992, 1792, 1792, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192 }, 0x02);
+
+    TEST_ASSERT_TRUE(receiver.is_packet_empty());
+    TEST_ASSERT_FALSE(receiver.unpack_packet());
+
+    for (size_t ii = 0; ii < packet1.size() - 1; ++ii) {
+        TEST_ASSERT_FALSE(receiver.on_data_received_from_isr(packet1[ii]));
+    }
+    TEST_ASSERT_TRUE(receiver.is_packet_empty());
+    TEST_ASSERT_TRUE(receiver.on_data_received_from_isr(packet1[24]));
+    TEST_ASSERT_EQUAL(1, receiver.get_packet_sequence());
+    TEST_ASSERT_FALSE(receiver.is_packet_empty());
+
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    TEST_ASSERT_TRUE(receiver.is_packet_empty());
+    TEST_ASSERT_EQUAL(1000, receiver.get_channel_pwm(0));
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(1));
+    TEST_ASSERT_EQUAL(2000, receiver.get_channel_pwm(2));
+    TEST_ASSERT_EQUAL(ReceiverBase::CHANNEL_HIGH, receiver.get_channel_pwm(16));
+    TEST_ASSERT_EQUAL(ReceiverBase::CHANNEL_LOW, receiver.get_channel_pwm(17));
+    // packet already read
+    TEST_ASSERT_FALSE(receiver.unpack_packet());
+
+    // two packets arrive before the task runs, the newest is unpacked
+    for (uint8_t data : packet1) {
+        receiver.on_data_received_from_isr(data);
+    }
+    for (uint8_t data : packet2) {
+        receiver.on_data_received_from_isr(data);
+    }
+    TEST_ASSERT_EQUAL(3, receiver.get_packet_sequence());
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(0));
+    TEST_ASSERT_EQUAL(1000, receiver.get_channel_pwm(1));
+    TEST_ASSERT_EQUAL(2000, receiver.get_channel_pwm(4));
+    TEST_ASSERT_EQUAL(ReceiverBase::CHANNEL_LOW, receiver.get_channel_pwm(16));
+    TEST_ASSERT_EQUAL(ReceiverBase::CHANNEL_HIGH, receiver.get_channel_pwm(17));
+
+    // a packet with a bad end byte is not published
+    auto packet3 = packet1;
+    packet3[24] = 0xAA;
+    for (uint8_t data : packet3) {
+        TEST_ASSERT_FALSE(receiver.on_data_received_from_isr(data));
+    }
+    TEST_ASSERT_EQUAL(3, receiver.get_packet_sequence());
+    TEST_ASSERT_TRUE(receiver.is_packet_empty());
+}
+
+void test_receiver_sbus_chunked_data()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    static ReceiverSbus receiver(serialPort);
+
+    const auto packet1 = sbus_packet({ 192, 992, 1792, 992, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192 }, 0x00);
+    const auto packet2 = sbus_packet({ 992, 192, 992, 1792, 1792, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192 }, 0x00);
+    // garbage, packet1, packet2, start of packet1
+    std::array<uint8_t, 3 + 25 + 25 + 10> stream {};
+    stream[0] = 0xAA;
+    stream[1] = 0x00;
+    stream[2] = 0x55;
+    std::copy(packet1.begin(), packet1.end(), stream.begin() + 3);
+    std::copy(packet2.begin(), packet2.end(), stream.begin() + 3 + 25);
+    std::copy(packet1.begin(), packet1.begin() + 10, stream.begin() + 3 + 25 + 25);
+
+    // feed the stream in chunks of all sizes, the result should be the same as feeding it in one go
+    for (size_t chunk_size = 1; chunk_size <= stream.size(); ++chunk_size) {
+        const uint32_t sequence = receiver.get_packet_sequence();
+        size_t packet_count = 0;
+        for (size_t ii = 0; ii < stream.size(); ii += chunk_size) {
+            packet_count += receiver.on_data_received(&stream[ii], std::min(chunk_size, stream.size() - ii), 0);
+        }
+        TEST_ASSERT_EQUAL(2, packet_count);
+        TEST_ASSERT_EQUAL(sequence + 2, receiver.get_packet_sequence());
+        TEST_ASSERT_EQUAL(10, receiver.get_packet_index());
+        TEST_ASSERT_TRUE(receiver.unpack_packet());
+        TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(0));
+        TEST_ASSERT_EQUAL(2000, receiver.get_channel_pwm(3));
+        // complete the partial packet
+        TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet1[10], packet1.size() - 10, 0));
+        TEST_ASSERT_TRUE(receiver.unpack_packet());
+        TEST_ASSERT_EQUAL(1000, receiver.get_channel_pwm(0));
+        TEST_ASSERT_EQUAL(2000, receiver.get_channel_pwm(2));
+    }
+}
+
+void test_receiver_sbus_frame_time()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    static ReceiverSbus receiver(serialPort);
+
+    // bytes arrive one at a time, 120us apart at 100000 baud 8E2
+    auto packet = sbus_packet({ 992, 992, 992, 992, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192 }, 0x00);
+    time_us32_t time = 10000;
+    for (uint8_t value : packet) {
+        receiver.on_data_received(&value, 1, time);
+        time += 120;
+    }
+    TEST_ASSERT_TRUE(receiver.update(0));
+    TEST_ASSERT_EQUAL(10000, receiver.get_frame_time().first_byte_us);
+    TEST_ASSERT_EQUAL(12880, receiver.get_frame_time().last_byte_us);
+    TEST_ASSERT_EQUAL(120, receiver.get_frame_age_us(13000));
+
+    // a bad packet does not change the frame time
+    packet[24] = 0x55;
+    time = 20000;
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&packet[0], packet.size(), time));
+    TEST_ASSERT_FALSE(receiver.update(0));
+    TEST_ASSERT_EQUAL(12880, receiver.get_frame_time().last_byte_us);
+
+    // the next good packet arrives in two chunks
+    packet[24] = ReceiverSbus::SBUS_END_BYTE;
+    time = 30000;
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&packet[0], 10, time));
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet[10], packet.size() - 10, time + 1800));
+    TEST_ASSERT_TRUE(receiver.update(0));
+    TEST_ASSERT_EQUAL(30000, receiver.get_frame_time().first_byte_us);
+    TEST_ASSERT_EQUAL(31800, receiver.get_frame_time().last_byte_us);
+}
+
+void test_receiver_sbus_bad_end_byte()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    static ReceiverSbus receiver(serialPort);
+
+    auto packet = sbus_packet({ 192, 992, 1792, 992, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192 }, 0x00);
+    packet[24] = 0x55;
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&packet[0], packet.size(), 0));
+    TEST_ASSERT_EQUAL(1, receiver.get_error_packet_count());
+    TEST_ASSERT_EQUAL(0, receiver.get_packet_sequence());
+
+    packet[24] = ReceiverSbus::SBUS_END_BYTE;
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet[0], packet.size(), 0));
+    TEST_ASSERT_EQUAL(1, receiver.get_error_packet_count());
+    TEST_ASSERT_EQUAL(1, receiver.get_packet_sequence());
+}
+
+void test_receiver_sbus_stats()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    static ReceiverSbus receiver(serialPort);
+
+    auto packet = sbus_packet({ 992, 992, 992, 992, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192 }, 0x00);
+    time_us32_t time = 1'000'000;
+    receiver.update_frames_per_second(time); // start the frame rate window
+    // a packet every 14ms for one second, each followed by an idle gap, which must not be counted as a drop
+    for (int ii = 0; ii < 72; ++ii) {
+        TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet[0], packet.size(), time));
+        time += 14000;
+    }
+    TEST_ASSERT_EQUAL(0, receiver.get_dropped_packet_count());
+    receiver.update_frames_per_second(time);
+
+    receiver_stats_t stats {};
+    TEST_ASSERT_TRUE(receiver.get_stats(stats));
+    TEST_ASSERT_EQUAL(72, stats.valid_frame_count);
+    TEST_ASSERT_EQUAL(0, stats.crc_error_count);
+    TEST_ASSERT_EQUAL(0, stats.framing_error_count);
+    TEST_ASSERT_EQUAL(0, stats.resync_count);
+    TEST_ASSERT_EQUAL(0, stats.overrun_count);
+    TEST_ASSERT_EQUAL(72*25, stats.byte_count);
+    TEST_ASSERT_EQUAL(71, stats.frames_per_second); // 72 frames in 1.008s
+
+    // a bad end byte is a framing error
+    packet[24] = 0x55;
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&packet[0], packet.size(), time));
+    packet[24] = ReceiverSbus::SBUS_END_BYTE;
+    TEST_ASSERT_TRUE(receiver.get_stats(stats));
+    TEST_ASSERT_EQUAL(1, stats.framing_error_count);
+
+    // a run of noise before the start byte is a single resync
+    const std::array<uint8_t, 3> noise = { 0x12, 0x34, 0x56 };
+    time += 14000;
+    receiver.on_data_received(&noise[0], noise.size(), time);
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet[0], packet.size(), time));
+    TEST_ASSERT_TRUE(receiver.get_stats(stats));
+    TEST_ASSERT_EQUAL(1, stats.resync_count);
+    TEST_ASSERT_EQUAL(73, stats.valid_frame_count);
+
+    // a packet cut short by a gap is dropped, and is a framing error
+    time += 14000;
+    receiver.on_data_received(&packet[0], 10, time);
+    time += 14000;
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet[0], packet.size(), time));
+    TEST_ASSERT_EQUAL(1, receiver.get_dropped_packet_count());
+    TEST_ASSERT_TRUE(receiver.get_stats(stats));
+    TEST_ASSERT_EQUAL(2, stats.framing_error_count);
+    TEST_ASSERT_EQUAL(74, stats.valid_frame_count);
+    TEST_ASSERT_EQUAL(75*25 + 3 + 10, stats.byte_count);
+}
+
+void test_receiver_sbus_map_to_pwm()
+{
+    for (uint16_t raw = 0; raw < 2048; ++raw) {
+        const auto expected = static_cast<uint16_t>(static_cast<uint16_t>(5.0F * static_cast<float>(raw) / 8.0F) + 880);
+        TEST_ASSERT_EQUAL(expected, ReceiverSbus::map_to_pwm(raw));
+    }
+    TEST_ASSERT_EQUAL(1000, ReceiverSbus::map_to_pwm(192));
+    TEST_ASSERT_EQUAL(1500, ReceiverSbus::map_to_pwm(992));
+    TEST_ASSERT_EQUAL(2000, ReceiverSbus::map_to_pwm(1792));
+}
+
+void test_divide_by_channel_range_integer()
+{
+    // must be bit-exact with float division, including the sign of the result
+    for (int32_t value = -70000; value <= 70000; ++value) {
+        const float expected = static_cast<float>(value) / ReceiverBase::CHANNEL_RANGE_F;
+        TEST_ASSERT_EQUAL_HEX32(std::bit_cast<uint32_t>(expected), std::bit_cast<uint32_t>(ReceiverBase::divide_by_channel_range_integer(value)));
+    }
+    for (int32_t value = (1 << 24) - 100000; value < (1 << 24); ++value) {
+        const float expected = static_cast<float>(value) / ReceiverBase::CHANNEL_RANGE_F;
+        TEST_ASSERT_EQUAL_HEX32(std::bit_cast<uint32_t>(expected), std::bit_cast<uint32_t>(ReceiverBase::divide_by_channel_range_integer(value)));
+        TEST_ASSERT_EQUAL_HEX32(std::bit_cast<uint32_t>(-expected), std::bit_cast<uint32_t>(ReceiverBase::divide_by_channel_range_integer(-value)));
+    }
+}
+
+void test_receiver_sbus_controls()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    static ReceiverSbus receiver(serialPort);
+
+    for (uint16_t raw = 0; raw < 2048; raw += 7) {
+        const auto packet = sbus_packet({ raw, static_cast<uint16_t>(2047 - raw), static_cast<uint16_t>(raw / 2), 992, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192 }, 0x00);
+        TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet[0], packet.size(), 0));
+        TEST_ASSERT_TRUE(receiver.unpack_packet());
+
+        const receiver_controls_pwm_t pwm = receiver.get_controls_pwm();
+        TEST_ASSERT_EQUAL(ReceiverSbus::map_to_pwm(raw), pwm.roll);
+        TEST_ASSERT_EQUAL(ReceiverSbus::map_to_pwm(static_cast<uint16_t>(2047 - raw)), pwm.pitch);
+        TEST_ASSERT_EQUAL(ReceiverSbus::map_to_pwm(static_cast<uint16_t>(raw / 2)), pwm.throttle);
+        TEST_ASSERT_EQUAL(1500, pwm.yaw);
+
+        // the previous float calculation
+        const receiver_controls_t controls = receiver.get_controls();
+#if defined(LIBRARY_RECEIVER_USE_FIXED_POINT_CONTROLS)
+        TEST_ASSERT_FLOAT_WITHIN(0.5F / 2048.0F, (static_cast<float>(pwm.throttle) - 1000.0F) / 1000.0F, controls.throttle);
+        TEST_ASSERT_FLOAT_WITHIN(0.5F / 2048.0F, (static_cast<float>(pwm.roll) - 1500.0F) / 1000.0F, controls.roll);
+        TEST_ASSERT_FLOAT_WITHIN(0.5F / 2048.0F, (static_cast<float>(pwm.pitch) - 1500.0F) / 1000.0F, controls.pitch);
+        TEST_ASSERT_FLOAT_WITHIN(0.5F / 2048.0F, (static_cast<float>(pwm.yaw) - 1500.0F) / 1000.0F, controls.yaw);
+#else
+        TEST_ASSERT_EQUAL_HEX32(std::bit_cast<uint32_t>((static_cast<float>(pwm.throttle) - 1000.0F) / 1000.0F), std::bit_cast<uint32_t>(controls.throttle));
+        TEST_ASSERT_EQUAL_HEX32(std::bit_cast<uint32_t>((static_cast<float>(pwm.roll) - 1500.0F) / 1000.0F), std::bit_cast<uint32_t>(controls.roll));
+        TEST_ASSERT_EQUAL_HEX32(std::bit_cast<uint32_t>((static_cast<float>(pwm.pitch) - 1500.0F) / 1000.0F), std::bit_cast<uint32_t>(controls.pitch));
+        TEST_ASSERT_EQUAL_HEX32(std::bit_cast<uint32_t>((static_cast<float>(pwm.yaw) - 1500.0F) / 1000.0F), std::bit_cast<uint32_t>(controls.yaw));
+#endif
+    }
+}
+
+void test_controls_q12dot4_from_pwm()
+{
+    // fixed point controls must be within half a q12dot4 step of the floating point controls
+    for (uint16_t pwm = 800; pwm <= 2200; ++pwm) {
+        const receiver_controls_pwm_t controls_pwm { pwm, pwm, static_cast<uint16_t>(3000 - pwm), pwm };
+        const receiver_controls_t controls = ReceiverBase::controls_from_pwm(controls_pwm);
+        const receiver_controls_q12dot4_t controls_q12dot4 = ReceiverBase::controls_q12dot4_from_pwm(controls_pwm);
+        TEST_ASSERT_FLOAT_WITHIN(0.5F / 2048.0F, controls.throttle, ReceiverBase::q12dot4_to_float(controls_q12dot4.throttle));
+        TEST_ASSERT_FLOAT_WITHIN(0.5F / 2048.0F, controls.roll, ReceiverBase::q12dot4_to_float(controls_q12dot4.roll));
+        TEST_ASSERT_FLOAT_WITHIN(0.5F / 2048.0F, controls.pitch, ReceiverBase::q12dot4_to_float(controls_q12dot4.pitch));
+        TEST_ASSERT_EQUAL(ReceiverBase::float_to_q12dot4(controls.yaw), controls_q12dot4.yaw);
+        // roll and pitch are symmetric about the middle
+        TEST_ASSERT_EQUAL(-controls_q12dot4.roll, controls_q12dot4.pitch);
+    }
+    TEST_ASSERT_EQUAL(0, ReceiverBase::controls_q12dot4_from_pwm({ 1000, 1500, 1500, 1500 }).throttle);
+    TEST_ASSERT_EQUAL(2048, ReceiverBase::controls_q12dot4_from_pwm({ 2000, 1500, 1500, 1500 }).throttle);
+    TEST_ASSERT_EQUAL(-1024, ReceiverBase::controls_q12dot4_from_pwm({ 1000, 1000, 1500, 1500 }).roll);
+    TEST_ASSERT_EQUAL(1024, ReceiverBase::controls_q12dot4_from_pwm({ 1000, 2000, 1500, 1500 }).roll);
+}
+
+void test_receiver_sbus_channels_follow_packets()
+{
+    // with lazy channel decoding the auxiliary channels must be decoded from the current packet, not the one they were first read from
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, 0, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    static ReceiverSbus receiver(serialPort);
+
+    auto packet = sbus_packet({ 192, 992, 1792, 992, 192, 352, 512, 672, 832, 992, 1152, 1312, 1472, 1632, 1792, 192 }, 0x01);
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet[0], packet.size(), 0));
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    TEST_ASSERT_EQUAL(1000, receiver.get_channel_pwm(0));
+    TEST_ASSERT_EQUAL(1100, receiver.get_channel_pwm(5));
+    TEST_ASSERT_EQUAL(1100, receiver.get_channel_pwm(5));
+    TEST_ASSERT_EQUAL(2000, receiver.get_channel_pwm(16));
+
+    packet = sbus_packet({ 992, 192, 992, 1792, 1792, 1632, 1472, 1312, 1152, 992, 832, 672, 512, 352, 192, 1792 }, 0x02);
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet[0], packet.size(), 0));
+    TEST_ASSERT_TRUE(receiver.unpack_packet());
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(0));
+    TEST_ASSERT_EQUAL(1000, receiver.get_channel_pwm(1));
+    TEST_ASSERT_EQUAL(2000, receiver.get_channel_pwm(3));
+    TEST_ASSERT_EQUAL(1900, receiver.get_channel_pwm(5));
+    TEST_ASSERT_EQUAL(2000, receiver.get_auxiliary_channel(0));
+    TEST_ASSERT_EQUAL(1600, receiver.get_channel_pwm(8));
+    TEST_ASSERT_EQUAL(2000, receiver.get_channel_pwm(15));
+    TEST_ASSERT_EQUAL(1000, receiver.get_channel_pwm(16));
+    TEST_ASSERT_EQUAL(2000, receiver.get_channel_pwm(17));
+}
+
+/*!
+Simulated SBUS link: the transmitter sends a packet every `frame_interval_us` at `baudrate`, each byte taking 12 bit times (8E2).
+Bytes are given to the receiver in chunks, timestamped with the arrival time of the last byte in the chunk.
+If the serial port is set to a different baudrate then the receiver sees garbage instead of the packet.
+*/
+class SbusLink {
+public:
+    enum { CHUNK_SIZE = 8 };
+    SbusLink(uint32_t baudrate, uint32_t frame_interval_us) : _baudrate(baudrate), _frame_interval_us(frame_interval_us) {}
+    //! Send packets for `duration_us`, running the receiver task after each packet. Returns the number of packets unpacked.
+    size_t run(ReceiverSbus& receiver, const SerialPort& serialPort, uint32_t duration_us) {
+        const auto packet = sbus_packet({ 192, 992, 1792, 992, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192 }, 0);
+        const uint32_t byte_time_us = 12 * 1000000 / _baudrate;
+        size_t unpacked_count = 0;
+        for (const time_us32_t end = _time + duration_us; _time < end; _time += _frame_interval_us) {
+            std::array<uint8_t, 25> bytes = packet;
+            if (serialPort.get_baudrate() != _baudrate) {
+                for (uint8_t& byte : bytes) {
+                    _seed = _seed * 1664525U + 1013904223U;
+                    byte = static_cast<uint8_t>(_seed >> 24U);
+                }
+            }
+            for (size_t ii = 0; ii < bytes.size(); ii += CHUNK_SIZE) {
+                const size_t len = std::min(static_cast<size_t>(CHUNK_SIZE), bytes.size() - ii);
+                receiver.on_data_received(&bytes[ii], len, _time + static_cast<time_us32_t>(ii + len) * byte_time_us);
+            }
+            receiver.update_baudrate(_time + static_cast<time_us32_t>(bytes.size()) * byte_time_us);
+            if (receiver.unpack_packet()) {
+                ++unpacked_count;
+            }
+        }
+        return unpacked_count;
+    }
+    time_us32_t get_time() const { return _time; }
+private:
+    uint32_t _baudrate;
+    uint32_t _frame_interval_us;
+    time_us32_t _time {10000};
+    uint32_t _seed {12345};
+};
+
+void test_receiver_sbus_fast_mode()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, ReceiverSbus::BAUD_RATE, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    static ReceiverSbus receiver(serialPort);
+    TEST_ASSERT_FALSE(receiver.is_fast());
+    TEST_ASSERT_EQUAL(ReceiverSbus::TIME_NEEDED_PER_FRAME_US, receiver.get_time_needed_per_frame_us());
+
+    receiver.set_baudrate_mode(ReceiverSbus::BAUDRATE_MODE_FAST);
+    TEST_ASSERT_TRUE(receiver.is_fast());
+    TEST_ASSERT_TRUE(receiver.is_baudrate_detected());
+    TEST_ASSERT_EQUAL(ReceiverSbus::FAST_BAUDRATE, serialPort.get_baudrate());
+    TEST_ASSERT_EQUAL(ReceiverSbus::TIME_NEEDED_PER_FRAME_US / 2, receiver.get_time_needed_per_frame_us());
+
+    SbusLink link(ReceiverSbus::FAST_BAUDRATE, 7000);
+    TEST_ASSERT_EQUAL(10, link.run(receiver, serialPort, 70000));
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(1));
+
+    // a packet spread over more than the fast frame time plus allowance is dropped
+    const auto packet = sbus_packet({ 192, 992, 1792, 992, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192 }, 0);
+    time_us32_t time = link.get_time();
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&packet[0], 12, time));
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&packet[12], 13, time + 2200));
+
+    // but is accepted at normal speed
+    receiver.set_baudrate_mode(ReceiverSbus::BAUDRATE_MODE_NORMAL);
+    TEST_ASSERT_FALSE(receiver.is_fast());
+    TEST_ASSERT_EQUAL(ReceiverSbus::BAUD_RATE, serialPort.get_baudrate());
+    TEST_ASSERT_EQUAL(ReceiverSbus::TIME_NEEDED_PER_FRAME_US, receiver.get_time_needed_per_frame_us());
+    time += 10000;
+    TEST_ASSERT_EQUAL(0, receiver.on_data_received(&packet[0], 12, time));
+    TEST_ASSERT_EQUAL(1, receiver.on_data_received(&packet[12], 13, time + 2200));
+}
+
+void test_receiver_sbus_baudrate_auto_detect()
+{
+    struct test_case_t {
+        uint32_t transmitter_baudrate;
+        uint32_t frame_interval_us;
+        uint32_t initial_baudrate;
+    };
+    static constexpr std::array<test_case_t, 4> test_cases {{
+        { ReceiverSbus::BAUD_RATE, 14000, ReceiverSbus::BAUD_RATE },
+        { ReceiverSbus::BAUD_RATE, 14000, ReceiverSbus::FAST_BAUDRATE },
+        { ReceiverSbus::FAST_BAUDRATE, 7000, ReceiverSbus::FAST_BAUDRATE },
+        { ReceiverSbus::FAST_BAUDRATE, 7000, ReceiverSbus::BAUD_RATE },
+    }};
+    for (const auto& test_case : test_cases) {
+        SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, test_case.initial_baudrate, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+        ReceiverSbus receiver(serialPort);
+        receiver.set_baudrate_mode(ReceiverSbus::BAUDRATE_MODE_AUTO);
+        TEST_ASSERT_FALSE(receiver.is_baudrate_detected());
+
+        SbusLink link(test_case.transmitter_baudrate, test_case.frame_interval_us);
+        // detected within two probe windows
+        link.run(receiver, serialPort, 2 * ReceiverSbus::PROBE_WINDOW_US + 2 * test_case.frame_interval_us);
+        TEST_ASSERT_TRUE(receiver.is_baudrate_detected());
+        TEST_ASSERT_EQUAL(test_case.transmitter_baudrate, serialPort.get_baudrate());
+        TEST_ASSERT_EQUAL(test_case.transmitter_baudrate == ReceiverSbus::FAST_BAUDRATE, receiver.is_fast());
+
+        // and stays detected
+        const size_t count = link.run(receiver, serialPort, 100 * test_case.frame_interval_us);
+        TEST_ASSERT_EQUAL(100, count);
+        TEST_ASSERT_EQUAL(test_case.transmitter_baudrate, serialPort.get_baudrate());
+    }
+}
+
 // NOLINTEND(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
 
 int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
@@ -27,6 +440,18 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
     UNITY_BEGIN();
 
     RUN_TEST(test_receiver_sbus);
+    RUN_TEST(test_receiver_sbus_packet_handoff);
+    RUN_TEST(test_receiver_sbus_chunked_data);
+    RUN_TEST(test_receiver_sbus_frame_time);
+    RUN_TEST(test_receiver_sbus_bad_end_byte);
+    RUN_TEST(test_receiver_sbus_stats);
+    RUN_TEST(test_receiver_sbus_map_to_pwm);
+    RUN_TEST(test_divide_by_channel_range_integer);
+    RUN_TEST(test_receiver_sbus_controls);
+    RUN_TEST(test_controls_q12dot4_from_pwm);
+    RUN_TEST(test_receiver_sbus_channels_follow_packets);
+    RUN_TEST(test_receiver_sbus_fast_mode);
+    RUN_TEST(test_receiver_sbus_baudrate_auto_detect);
 
     UNITY_END();
 }
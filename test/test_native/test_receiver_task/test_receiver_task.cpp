@@ -0,0 +1,114 @@
+#include "cockpit_base.h"
+#include "receiver_task.h"
+#include "receiver_virtual.h"
+
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
+struct receiver_context_t {
+    int id;
+};
+
+class CockpitTest : public CockpitBase {
+public:
+    void update_controls(uint32_t tick_count, uint32_t frame_age_us, const ReceiverBase& receiver, receiver_context_t& ctx) override {
+        (void)tick_count;
+        (void)frame_age_us;
+        _receiver = &receiver;
+        _context_id = ctx.id;
+        ++_update_controls_count;
+    }
+    void check_failsafe(uint32_t tick_count, receiver_context_t& ctx) override {
+        (void)tick_count;
+        (void)ctx;
+        ++_check_failsafe_count;
+    }
+public:
+    const ReceiverBase* _receiver {nullptr};
+    int _context_id {};
+    int _update_controls_count {};
+    int _check_failsafe_count {};
+};
+
+void test_receiver_task_storage()
+{
+    static ReceiverVirtual receiver_primary;
+    static ReceiverVirtual receiver_backup;
+    static CockpitTest cockpit_primary;
+    static CockpitTest cockpit_backup;
+    static receiver_context_t context_primary { .id = 1 };
+    static receiver_context_t context_backup { .id = 2 };
+    static ReceiverTaskStorage<4096> storage_primary;
+    static ReceiverTaskStorage<1024> storage_backup;
+
+    TEST_ASSERT_NULL(storage_primary.get_task());
+    task_info_t task_info_primary {};
+    task_info_t task_info_backup {};
+    ReceiverTask* task_primary = storage_primary.create_task(task_info_primary, receiver_primary, cockpit_primary, context_primary, 3, 0, 0);
+    ReceiverTask* task_backup = storage_backup.create_task(task_info_backup, receiver_backup, cockpit_backup, context_backup, 2, 1, 4000);
+    TEST_ASSERT_NOT_NULL(task_primary);
+    TEST_ASSERT_NOT_NULL(task_backup);
+    TEST_ASSERT_TRUE(task_primary != task_backup);
+    TEST_ASSERT_EQUAL_PTR(task_primary, storage_primary.get_task());
+    TEST_ASSERT_EQUAL_PTR(task_backup, storage_backup.get_task());
+
+    // each task has its own stack, of the size given at compile time, and its own core and interval
+    TEST_ASSERT_EQUAL(4096, task_info_primary.stack_depth_bytes);
+    TEST_ASSERT_EQUAL(1024, task_info_backup.stack_depth_bytes);
+    TEST_ASSERT_TRUE(task_info_primary.stack_buffer != task_info_backup.stack_buffer);
+    TEST_ASSERT_EQUAL(3, task_info_primary.priority);
+    TEST_ASSERT_EQUAL(0, task_info_primary.core);
+    TEST_ASSERT_EQUAL(1, task_info_backup.core);
+    TEST_ASSERT_EQUAL(0, task_info_primary.task_interval_microseconds);
+    TEST_ASSERT_EQUAL(4000, task_info_backup.task_interval_microseconds);
+
+    // each task updates its own cockpit from its own receiver
+    task_primary->loop();
+    TEST_ASSERT_EQUAL(1, cockpit_primary._update_controls_count);
+    TEST_ASSERT_EQUAL_PTR(&receiver_primary, cockpit_primary._receiver);
+    TEST_ASSERT_EQUAL(1, cockpit_primary._context_id);
+    TEST_ASSERT_EQUAL(0, cockpit_backup._update_controls_count);
+    task_backup->loop();
+    task_backup->loop();
+    TEST_ASSERT_EQUAL(1, cockpit_primary._update_controls_count);
+    TEST_ASSERT_EQUAL(2, cockpit_backup._update_controls_count);
+    TEST_ASSERT_EQUAL_PTR(&receiver_backup, cockpit_backup._receiver);
+    TEST_ASSERT_EQUAL(2, cockpit_backup._context_id);
+
+    // the storage holds only one task
+    TEST_ASSERT_NULL(storage_primary.create_task(receiver_backup, cockpit_backup, context_backup, 3, 0, 0));
+    TEST_ASSERT_EQUAL_PTR(task_primary, storage_primary.get_task());
+}
+
+void test_receiver_task_create_task()
+{
+    static ReceiverVirtual receiver;
+    static CockpitTest cockpit;
+    static receiver_context_t context { .id = 3 };
+
+    ReceiverTask* task = ReceiverTask::create_task(receiver, cockpit, context, 3, 0);
+    TEST_ASSERT_NOT_NULL(task);
+#if defined(NDEBUG)
+    // the default storage holds a single task, so a second call asserts, or with assertions disabled returns nullptr
+    TEST_ASSERT_NULL(ReceiverTask::create_task(receiver, cockpit, context, 3, 0));
+#endif
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_receiver_task_storage);
+    RUN_TEST(test_receiver_task_create_task);
+
+    UNITY_END();
+}
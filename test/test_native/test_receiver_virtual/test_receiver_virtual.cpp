@@ -101,6 +101,31 @@ void test_receiver_auxiliary_channels()
     TEST_ASSERT_EQUAL(1200, receiver.get_channel_pwm(2 + ReceiverBase::STICK_COUNT));
 }
 
+void test_receiver_controls_q12dot4()
+{
+    ReceiverVirtual receiver;
+
+    receiver.set_controls(receiver_controls_q12dot4_t { 2048, -1024, 512, 0 });
+    const receiver_controls_q12dot4_t controls_q12dot4 = receiver.get_controls_q12dot4();
+    TEST_ASSERT_EQUAL(2048, controls_q12dot4.throttle);
+    TEST_ASSERT_EQUAL(-1024, controls_q12dot4.roll);
+    TEST_ASSERT_EQUAL(512, controls_q12dot4.pitch);
+    TEST_ASSERT_EQUAL(0, controls_q12dot4.yaw);
+
+    // the float API is a wrapper around the fixed point controls, or vice versa
+    const receiver_controls_t controls = receiver.get_controls();
+    TEST_ASSERT_EQUAL_FLOAT(1.0F, controls.throttle);
+    TEST_ASSERT_EQUAL_FLOAT(-0.5F, controls.roll);
+    TEST_ASSERT_EQUAL_FLOAT(0.25F, controls.pitch);
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, controls.yaw);
+
+    receiver.set_controls(receiver_controls_t { 0.1F, -0.1F, 0.0F, 1.0F });
+    TEST_ASSERT_EQUAL(205, receiver.get_controls_q12dot4().throttle);
+    TEST_ASSERT_EQUAL(-205, receiver.get_controls_q12dot4().roll);
+    TEST_ASSERT_EQUAL(0, receiver.get_controls_q12dot4().pitch);
+    TEST_ASSERT_EQUAL(2048, receiver.get_controls_q12dot4().yaw);
+}
+
 // NOLINTEND(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
 
 int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
@@ -109,6 +134,7 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
 
     RUN_TEST(test_receiver_switches);
     RUN_TEST(test_receiver_controls);
+    RUN_TEST(test_receiver_controls_q12dot4);
     RUN_TEST(test_receiver_auxiliary_channels);
 
     UNITY_END();
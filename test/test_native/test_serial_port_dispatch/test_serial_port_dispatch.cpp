@@ -0,0 +1,147 @@
+#include "receiver_crsf.h"
+#include "receiver_sbus.h"
+
+#include "../crsf_test_packets.h"
+#include "../sbus_test_packets.h"
+
+#include <algorithm>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
+/*!
+Simulate `len` bytes arriving at UART `uart_index`, `chunk_size` bytes per interrupt.
+If LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER is defined the ISR only fills the receive buffer, so it is then drained into the parser,
+as the ReceiverTask does.
+*/
+static void receive(uint8_t uart_index, ReceiverSerial& receiver, const uint8_t* data, size_t len, size_t chunk_size)
+{
+    SerialPort* serial_port = SerialPort::get_instance(uart_index);
+    TEST_ASSERT_NOT_NULL(serial_port);
+    for (size_t ii = 0; ii < len; ii += chunk_size) {
+        const size_t count = std::min(chunk_size, len - ii);
+        TEST_ASSERT_EQUAL(count, serial_port->receive_into_uart_fifo(&data[ii], count));
+        SerialPort::data_ready_isr(uart_index);
+    }
+    std::array<uint8_t, 64> buf {};
+    size_t count = 0;
+    while ((count = receiver.read(&buf[0], buf.size())) > 0) {
+        receiver.on_data_received(&buf[0], count, 0);
+    }
+}
+
+void test_serial_port_instances()
+{
+    TEST_ASSERT_NULL(SerialPort::get_instance(SerialPort::UART_INDEX_6));
+    {
+        SerialPort serial_port(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_6, 0, 8, 1, SerialPort::PARITY_NONE);
+        TEST_ASSERT_EQUAL_PTR(&serial_port, SerialPort::get_instance(SerialPort::UART_INDEX_6));
+    }
+    // the SerialPort removes itself when destroyed
+    TEST_ASSERT_NULL(SerialPort::get_instance(SerialPort::UART_INDEX_6));
+    TEST_ASSERT_NULL(SerialPort::get_instance(SerialPort::UART_COUNT));
+
+    // an interrupt for a UART with no SerialPort is ignored
+    SerialPort::data_ready_isr(SerialPort::UART_INDEX_6);
+    SerialPort::data_ready_isr(SerialPort::UART_COUNT);
+}
+
+void test_serial_port_two_ports()
+{
+    // primary CRSF link on UART 0, backup SBUS receiver on UART 2
+    static SerialPort crsf_serial_port(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_0, ReceiverCrsf::BAUD_RATE, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    static ReceiverCrsf crsf_receiver(crsf_serial_port);
+    static SerialPort sbus_serial_port(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_2, ReceiverSbus::BAUD_RATE, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    static ReceiverSbus sbus_receiver(sbus_serial_port);
+
+    TEST_ASSERT_EQUAL_PTR(&crsf_serial_port, SerialPort::get_instance(SerialPort::UART_INDEX_0));
+    TEST_ASSERT_EQUAL_PTR(&sbus_serial_port, SerialPort::get_instance(SerialPort::UART_INDEX_2));
+
+    const ReceiverCrsf::packet_u crsf = crsf_rc_channels_packet(992);
+    const std::array<uint8_t, 25> sbus = sbus_packet(192);
+
+    // the two UARTs interrupt alternately, each in the middle of the other's packet
+    receive(SerialPort::UART_INDEX_0, crsf_receiver, &crsf.data[0], 10, 5);
+    receive(SerialPort::UART_INDEX_2, sbus_receiver, &sbus[0], 12, 4);
+    TEST_ASSERT_EQUAL(0, crsf_receiver.get_packet_sequence());
+    TEST_ASSERT_EQUAL(0, sbus_receiver.get_packet_sequence());
+    receive(SerialPort::UART_INDEX_0, crsf_receiver, &crsf.data[10], 16, 5);
+    TEST_ASSERT_EQUAL(1, crsf_receiver.get_packet_sequence());
+    TEST_ASSERT_EQUAL(0, sbus_receiver.get_packet_sequence());
+    receive(SerialPort::UART_INDEX_2, sbus_receiver, &sbus[12], 13, 4);
+    TEST_ASSERT_EQUAL(1, crsf_receiver.get_packet_sequence());
+    TEST_ASSERT_EQUAL(1, sbus_receiver.get_packet_sequence());
+
+    TEST_ASSERT_TRUE(crsf_receiver.update(0));
+    TEST_ASSERT_TRUE(sbus_receiver.update(0));
+    TEST_ASSERT_EQUAL(ReceiverBase::CHANNEL_MIDDLE, crsf_receiver.get_channel_pwm(4));
+    TEST_ASSERT_EQUAL(ReceiverBase::CHANNEL_LOW, sbus_receiver.get_channel_pwm(4));
+    TEST_ASSERT_EQUAL(0, crsf_receiver.get_error_packet_count());
+    TEST_ASSERT_EQUAL(0, sbus_receiver.get_error_packet_count());
+
+    // a burst of packets on both ports, a whole UART FIFO at a time
+    std::array<uint8_t, 4*26> crsf_burst {};
+    std::array<uint8_t, 4*25> sbus_burst {};
+    for (size_t ii = 0; ii < 4; ++ii) {
+        std::copy_n(&crsf.data[0], 26, &crsf_burst[26*ii]);
+        std::copy_n(&sbus[0], 25, &sbus_burst[25*ii]);
+    }
+    receive(SerialPort::UART_INDEX_2, sbus_receiver, &sbus_burst[0], sbus_burst.size(), SerialPort::UART_FIFO_SIZE);
+    receive(SerialPort::UART_INDEX_0, crsf_receiver, &crsf_burst[0], crsf_burst.size(), SerialPort::UART_FIFO_SIZE);
+    TEST_ASSERT_EQUAL(5, crsf_receiver.get_packet_sequence());
+    TEST_ASSERT_EQUAL(5, sbus_receiver.get_packet_sequence());
+}
+void test_serial_port_data_ready_signal()
+{
+    static SerialPort serial_port(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_4, ReceiverSbus::BAUD_RATE, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    static ReceiverSbus receiver(serial_port);
+    TEST_ASSERT_EQUAL(25, serial_port.get_data_ready_threshold());
+
+    // a frame arriving 4 bytes per interrupt wakes the task once, in both the parsing and the ring buffer modes
+    const std::array<uint8_t, 25> sbus = sbus_packet(992);
+    for (size_t ii = 0; ii < 24; ii += 4) {
+        serial_port.receive_into_uart_fifo(&sbus[ii], 4);
+        SerialPort::data_ready_isr(SerialPort::UART_INDEX_4);
+    }
+    TEST_ASSERT_EQUAL(0, serial_port.get_data_ready_signal_count());
+    // the task is woken, and drains the ring buffer
+    receive(SerialPort::UART_INDEX_4, receiver, &sbus[24], 1, 4);
+    TEST_ASSERT_EQUAL(1, serial_port.get_data_ready_signal_count());
+    TEST_ASSERT_EQUAL(1, receiver.get_packet_sequence());
+
+    // a burst of 3 frames, before the task runs
+    for (size_t ii = 0; ii < 3; ++ii) {
+        for (size_t jj = 0; jj < sbus.size(); jj += 5) {
+            serial_port.receive_into_uart_fifo(&sbus[jj], 5);
+            SerialPort::data_ready_isr(SerialPort::UART_INDEX_4);
+        }
+    }
+#if defined(LIBRARY_RECEIVER_USE_SERIAL_RX_BUFFER)
+    // the task has not yet drained the ring buffer, so it is only woken once
+    TEST_ASSERT_EQUAL(2, serial_port.get_data_ready_signal_count());
+#else
+    // the ISR parses the frames, so wakes the task for each one
+    TEST_ASSERT_EQUAL(4, serial_port.get_data_ready_signal_count());
+#endif
+    receive(SerialPort::UART_INDEX_4, receiver, &sbus[0], 0, 1);
+    TEST_ASSERT_EQUAL(4, receiver.get_packet_sequence());
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-convert-member-functions-to-static,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_serial_port_instances);
+    RUN_TEST(test_serial_port_two_ports);
+    RUN_TEST(test_serial_port_data_ready_signal);
+
+    UNITY_END();
+}
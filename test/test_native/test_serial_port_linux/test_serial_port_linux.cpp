@@ -0,0 +1,199 @@
+#include "receiver_crsf.h"
+#include "receiver_sbus.h"
+
+#include "../sbus_test_packets.h"
+
+#include <unity.h>
+
+#if defined(FRAMEWORK_LINUX)
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-magic-numbers)
+#if defined(FRAMEWORK_LINUX)
+/*!
+Pseudo terminal pair: data written to the master appears on the slave, which is opened by the SerialPort.
+*/
+class Pty {
+public:
+    Pty() :
+        _master(posix_openpt(O_RDWR | O_NOCTTY))
+    {
+        grantpt(_master);
+        unlockpt(_master);
+    }
+    ~Pty() { close(_master); }
+    int master() const { return _master; }
+    const char* slave_name() const { return ptsname(_master); } // NOLINT(concurrency-mt-unsafe)
+    void write(const uint8_t* data, size_t len) const { TEST_ASSERT_EQUAL(static_cast<ssize_t>(len), ::write(_master, data, len)); }
+    //! Read up to `max_len` bytes written to the slave, waiting up to `timeout_ms` for them.
+    size_t read(uint8_t* data, size_t max_len, int timeout_ms) const {
+        pollfd fds { .fd = _master, .events = POLLIN, .revents = 0 };
+        if (poll(&fds, 1, timeout_ms) <= 0) {
+            return 0;
+        }
+        const ssize_t len = ::read(_master, data, max_len);
+        return len > 0 ? static_cast<size_t>(len) : 0;
+    }
+private:
+    int _master;
+};
+
+/*!
+Wait for data and parse it until a packet is complete, as the ReceiverTask does.
+*/
+static size_t receive_packet(ReceiverSerial& receiver)
+{
+    std::array<uint8_t, 64> buf {};
+    size_t packet_count = 0;
+    while (packet_count == 0 && receiver.WAIT_FOR_DATA_RECEIVED(1000) > 0) {
+        const size_t len = receiver.read(&buf[0], buf.size());
+        packet_count += receiver.on_data_received(&buf[0], len, time_us());
+    }
+    return packet_count;
+}
+
+void test_serial_port_linux_sbus()
+{
+    const Pty pty;
+    SerialPort serialPort(pty.slave_name(), ReceiverSbus::BAUD_RATE, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    ReceiverSbus receiver(serialPort);
+    receiver.init();
+    TEST_ASSERT_TRUE(serialPort.is_open());
+
+    // nothing has been sent, so the wait times out
+    TEST_ASSERT_EQUAL(0, receiver.WAIT_FOR_DATA_RECEIVED(10));
+    TEST_ASSERT_FALSE(receiver.is_data_available());
+    std::array<uint8_t, 8> buf {};
+    TEST_ASSERT_EQUAL(0, receiver.read(&buf[0], buf.size()));
+
+    // 192 maps to 1000, 992 maps to 1500, 1792 maps to 2000
+    const auto packet = sbus_packet({ 192, 992, 1792, 992, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192, 192 });
+    pty.write(&packet[0], packet.size());
+    TEST_ASSERT_EQUAL(1, receive_packet(receiver));
+    TEST_ASSERT_TRUE(receiver.update(0));
+    TEST_ASSERT_EQUAL(1000, receiver.get_channel_pwm(0));
+    TEST_ASSERT_EQUAL(1500, receiver.get_channel_pwm(1));
+    TEST_ASSERT_EQUAL(2000, receiver.get_channel_pwm(2));
+
+    serialPort.close();
+    TEST_ASSERT_FALSE(serialPort.is_open());
+}
+
+void test_serial_port_linux_crsf()
+{
+    const Pty pty;
+    SerialPort serialPort(pty.slave_name(), ReceiverCrsf::BAUD_RATE, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    ReceiverCrsf receiver(serialPort);
+    receiver.init();
+    TEST_ASSERT_TRUE(serialPort.is_open());
+
+    // non-standard baudrates are set using termios2
+    TEST_ASSERT_EQUAL(ReceiverCrsf::BAUD_RATE_UNOFFICIAL, serialPort.set_baudrate(ReceiverCrsf::BAUD_RATE_UNOFFICIAL));
+    TEST_ASSERT_EQUAL(ReceiverCrsf::BAUD_RATE, serialPort.set_baudrate(ReceiverCrsf::BAUD_RATE));
+
+    ReceiverCrsf::packet_u packet {};
+    packet.value.sync = ReceiverCrsf::CRSF_SYNC_BYTE;
+    packet.value.length = 24; // type + 22 bytes of channel data + CRC
+    packet.value.type = ReceiverCrsf::FRAMETYPE_RC_CHANNELS_PACKED;
+    packet.value.payload[22] = ReceiverCrsf::calculate_crc(packet);
+    pty.write(&packet.data[0], 26);
+    TEST_ASSERT_EQUAL(1, receive_packet(receiver));
+    TEST_ASSERT_EQUAL(1, receiver.get_packet_sequence());
+}
+
+void test_serial_port_linux_crsf_speed_negotiation()
+{
+    const Pty pty;
+    SerialPort serialPort(pty.slave_name(), ReceiverCrsf::BAUD_RATE, ReceiverCrsf::DATA_BITS, ReceiverCrsf::STOP_BITS, ReceiverCrsf::PARITY);
+    ReceiverCrsf receiver(serialPort);
+    receiver.init();
+    TEST_ASSERT_TRUE(serialPort.is_open());
+
+    // speed proposal from the receiver
+    ReceiverCrsf::packet_u packet {};
+    packet.value.sync = ReceiverCrsf::CRSF_SYNC_BYTE;
+    packet.value.length = 12; // type + 10 payload bytes + CRC
+    packet.value.type = ReceiverCrsf::FRAMETYPE_COMMAND;
+    packet.value.payload = {
+        ReceiverCrsf::ADDRESS_FLIGHT_CONTROLLER,
+        ReceiverCrsf::ADDRESS_CRSF_RECEIVER,
+        ReceiverCrsf::COMMAND_SUBCMD_GENERAL,
+        ReceiverCrsf::COMMAND_SUBCMD_GENERAL_CRSF_SPEED_PROPOSAL,
+        0, // port id
+        0x00, 0x1E, 0x84, 0x80 // 2000000, big endian
+    };
+    packet.value.payload[9] = ReceiverCrsf::calculate_command_crc(packet);
+    packet.value.payload[10] = ReceiverCrsf::calculate_crc(packet);
+    pty.write(&packet.data[0], 14);
+    TEST_ASSERT_EQUAL(1, receive_packet(receiver));
+    TEST_ASSERT_FALSE(receiver.update(0));
+
+    // the flight controller response appears on the master side of the pty
+    tcdrain(pty.master());
+    const ReceiverCrsf::packet_u expected = ReceiverCrsf::speed_response_packet(0, true);
+    std::array<uint8_t, 64> response {};
+    TEST_ASSERT_EQUAL(11, pty.read(&response[0], response.size(), 1000));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(&expected.data[0], &response[0], 11);
+    TEST_ASSERT_EQUAL(ReceiverCrsf::BAUD_RATE, serialPort.get_baudrate());
+
+    // the baudrate is switched on the next update
+    TEST_ASSERT_FALSE(receiver.update(0));
+    TEST_ASSERT_EQUAL(2000000, serialPort.get_baudrate());
+    TEST_ASSERT_EQUAL(ReceiverCrsf::SPEED_NEGOTIATION_CONFIRMING, receiver.get_speed_negotiation_state());
+
+    // an RC channels packet at the new baudrate confirms the switch
+    packet = ReceiverCrsf::packet_u {};
+    packet.value.sync = ReceiverCrsf::CRSF_SYNC_BYTE;
+    packet.value.length = 24; // type + 22 bytes of channel data + CRC
+    packet.value.type = ReceiverCrsf::FRAMETYPE_RC_CHANNELS_PACKED;
+    packet.value.payload[22] = ReceiverCrsf::calculate_crc(packet);
+    pty.write(&packet.data[0], 26);
+    TEST_ASSERT_EQUAL(1, receive_packet(receiver));
+    TEST_ASSERT_TRUE(receiver.update(0));
+    TEST_ASSERT_FALSE(receiver.update(0));
+    TEST_ASSERT_EQUAL(ReceiverCrsf::SPEED_NEGOTIATION_IDLE, receiver.get_speed_negotiation_state());
+    TEST_ASSERT_EQUAL(2000000, serialPort.get_baudrate());
+}
+
+void test_serial_port_linux_no_device()
+{
+    static SerialPort serialPort("/dev/does-not-exist", ReceiverSbus::BAUD_RATE, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+
+    serialPort.init();
+    TEST_ASSERT_FALSE(serialPort.is_open());
+    TEST_ASSERT_EQUAL(0, serialPort.WAIT_FOR_DATA_RECEIVED(10));
+
+    // a device SerialPort is not driven by a UART interrupt, so does not take a UART's slot
+    for (uint8_t uart_index = 0; uart_index < SerialPort::UART_COUNT; ++uart_index) {
+        TEST_ASSERT_NULL(SerialPort::get_instance(uart_index));
+    }
+}
+#endif
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+#if defined(FRAMEWORK_LINUX)
+    RUN_TEST(test_serial_port_linux_sbus);
+    RUN_TEST(test_serial_port_linux_crsf);
+    RUN_TEST(test_serial_port_linux_crsf_speed_negotiation);
+    RUN_TEST(test_serial_port_linux_no_device);
+#endif
+
+    UNITY_END();
+}
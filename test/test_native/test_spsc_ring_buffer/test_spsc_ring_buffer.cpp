@@ -0,0 +1,195 @@
+#include "receiver_sbus.h"
+#include "spsc_ring_buffer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-magic-numbers)
+void test_spsc_ring_buffer()
+{
+    static SpscRingBuffer<8> buffer;
+
+    TEST_ASSERT_EQUAL(8, buffer.capacity());
+    TEST_ASSERT_TRUE(buffer.empty());
+    uint8_t data = 0xFF;
+    TEST_ASSERT_FALSE(buffer.pop(data));
+    TEST_ASSERT_EQUAL(0xFF, data);
+
+    for (uint8_t ii = 0; ii < 8; ++ii) {
+        TEST_ASSERT_TRUE(buffer.push(ii));
+    }
+    TEST_ASSERT_EQUAL(8, buffer.available());
+    TEST_ASSERT_EQUAL(0, buffer.get_overrun_count());
+    // buffer full, so byte is dropped
+    TEST_ASSERT_FALSE(buffer.push(8));
+    TEST_ASSERT_EQUAL(1, buffer.get_overrun_count());
+
+    for (uint8_t ii = 0; ii < 5; ++ii) {
+        TEST_ASSERT_TRUE(buffer.pop(data));
+        TEST_ASSERT_EQUAL(ii, data);
+    }
+    TEST_ASSERT_EQUAL(3, buffer.available());
+
+    // wrap around the end of the storage
+    for (uint8_t ii = 10; ii < 15; ++ii) {
+        TEST_ASSERT_TRUE(buffer.push(ii));
+    }
+    TEST_ASSERT_EQUAL(8, buffer.available());
+
+    std::array<uint8_t, 16> buf {};
+    TEST_ASSERT_EQUAL(4, buffer.read(&buf[0], 4));
+    TEST_ASSERT_EQUAL(5, buf[0]);
+    TEST_ASSERT_EQUAL(6, buf[1]);
+    TEST_ASSERT_EQUAL(7, buf[2]);
+    TEST_ASSERT_EQUAL(10, buf[3]);
+    TEST_ASSERT_EQUAL(4, buffer.read(&buf[0], buf.size()));
+    TEST_ASSERT_EQUAL(11, buf[0]);
+    TEST_ASSERT_EQUAL(14, buf[3]);
+    TEST_ASSERT_TRUE(buffer.empty());
+    TEST_ASSERT_EQUAL(0, buffer.read(&buf[0], buf.size()));
+
+    const std::array<uint8_t, 10> input { 20, 21, 22, 23, 24, 25, 26, 27, 28, 29 };
+    TEST_ASSERT_EQUAL(8, buffer.write(&input[0], input.size()));
+    TEST_ASSERT_EQUAL(3, buffer.get_overrun_count());
+    TEST_ASSERT_EQUAL(8, buffer.read(&buf[0], buf.size()));
+    TEST_ASSERT_EQUAL(20, buf[0]);
+    TEST_ASSERT_EQUAL(27, buf[7]);
+
+    TEST_ASSERT_TRUE(buffer.push(20));
+    buffer.clear();
+    TEST_ASSERT_TRUE(buffer.empty());
+}
+
+void test_spsc_ring_buffer_producer_consumer()
+{
+    // producer thread simulates the ISR, consumer thread simulates the ReceiverTask
+    static SpscRingBuffer<64> buffer;
+    enum { BYTE_COUNT = 100'000 };
+
+    std::thread producer([]() {
+        for (uint32_t ii = 0; ii < BYTE_COUNT; ) {
+            if (buffer.push(static_cast<uint8_t>(ii))) {
+                ++ii;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t received = 0;
+    uint32_t errors = 0;
+    std::array<uint8_t, 32> buf {};
+    while (received < BYTE_COUNT) {
+        const size_t len = buffer.read(&buf[0], buf.size());
+        if (len == 0) {
+            std::this_thread::yield();
+        }
+        for (size_t ii = 0; ii < len; ++ii) {
+            if (buf[ii] != static_cast<uint8_t>(received)) {
+                ++errors;
+            }
+            ++received;
+        }
+    }
+    producer.join();
+
+    TEST_ASSERT_EQUAL(BYTE_COUNT, received);
+    TEST_ASSERT_EQUAL(0, errors);
+    TEST_ASSERT_TRUE(buffer.empty());
+}
+
+void test_spsc_ring_buffer_throughput()
+{
+    static SpscRingBuffer<256> buffer;
+    enum { BYTE_COUNT = 10'000'000 };
+
+    const auto start = std::chrono::steady_clock::now();
+    uint32_t sum = 0;
+    std::array<uint8_t, 64> buf {};
+    for (uint32_t ii = 0; ii < BYTE_COUNT; ii += 64) {
+        for (uint32_t jj = 0; jj < 64; ++jj) {
+            buffer.push(static_cast<uint8_t>(jj));
+        }
+        const size_t len = buffer.read(&buf[0], buf.size());
+        for (size_t jj = 0; jj < len; ++jj) {
+            sum += buf[jj];
+        }
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(end - start).count();
+
+    TEST_ASSERT_EQUAL((BYTE_COUNT / 64) * (63 * 64 / 2), sum);
+    TEST_ASSERT_EQUAL(0, buffer.get_overrun_count());
+    printf("SpscRingBuffer push+read: %.1f Mbytes/s\r\n", static_cast<double>(BYTE_COUNT) / seconds / 1.0e6);
+}
+
+void test_serial_port_rx_buffer()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, ReceiverSbus::BAUD_RATE, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+
+    TEST_ASSERT_FALSE(serialPort.is_data_available());
+    TEST_ASSERT_TRUE(serialPort.push_from_isr(0x0F));
+    TEST_ASSERT_TRUE(serialPort.push_from_isr(0x01));
+    TEST_ASSERT_EQUAL(2, serialPort.get_rx_buffer_available());
+    TEST_ASSERT_TRUE(serialPort.is_data_available());
+    TEST_ASSERT_EQUAL(0x0F, serialPort.read_byte());
+    TEST_ASSERT_EQUAL(0x01, serialPort.read_byte());
+    TEST_ASSERT_FALSE(serialPort.is_data_available());
+
+    for (size_t ii = 0; ii < SerialPort::RX_BUFFER_SIZE + 3; ++ii) {
+        serialPort.push_from_isr(static_cast<uint8_t>(ii));
+    }
+    TEST_ASSERT_EQUAL(3, serialPort.get_rx_overrun_count());
+}
+
+void test_serial_port_read()
+{
+    static SerialPort serialPort(SerialPort::uart_pins_t{}, SerialPort::UART_INDEX_NONE, ReceiverSbus::BAUD_RATE, ReceiverSbus::DATA_BITS, ReceiverSbus::STOP_BITS, ReceiverSbus::PARITY);
+    static ReceiverSbus receiver(serialPort);
+
+    std::array<uint8_t, 50> input {};
+    for (size_t ii = 0; ii < input.size(); ++ii) {
+        input[ii] = static_cast<uint8_t>(ii);
+    }
+    TEST_ASSERT_EQUAL(50, serialPort.push_from_isr(&input[0], input.size()));
+    TEST_ASSERT_EQUAL(50, serialPort.get_rx_buffer_available());
+
+    std::array<uint8_t, 32> buf {};
+    TEST_ASSERT_EQUAL(32, serialPort.read(&buf[0], buf.size()));
+    TEST_ASSERT_EQUAL(0, buf[0]);
+    TEST_ASSERT_EQUAL(31, buf[31]);
+    // ReceiverSerial exposes the same call
+    TEST_ASSERT_EQUAL(18, receiver.read(&buf[0], buf.size()));
+    TEST_ASSERT_EQUAL(32, buf[0]);
+    TEST_ASSERT_EQUAL(49, buf[17]);
+    TEST_ASSERT_EQUAL(0, receiver.read(&buf[0], buf.size()));
+
+    // bytes that do not fit in the receive buffer are dropped
+    std::array<uint8_t, SerialPort::RX_BUFFER_SIZE + 5> overflow {};
+    TEST_ASSERT_EQUAL(SerialPort::RX_BUFFER_SIZE, serialPort.push_from_isr(&overflow[0], overflow.size()));
+    TEST_ASSERT_EQUAL(5, serialPort.get_rx_overrun_count());
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_spsc_ring_buffer);
+    RUN_TEST(test_spsc_ring_buffer_producer_consumer);
+    RUN_TEST(test_spsc_ring_buffer_throughput);
+    RUN_TEST(test_serial_port_rx_buffer);
+    RUN_TEST(test_serial_port_read);
+
+    UNITY_END();
+}
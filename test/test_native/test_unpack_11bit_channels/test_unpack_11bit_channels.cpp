@@ -0,0 +1,157 @@
+#include "unpack_11bit_channels.h"
+
+#include <unity.h>
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-magic-numbers)
+/*!
+Reference decoder: the previous hand coded SBUS decoder, `packet` points to the channel data (ie excluding the start byte).
+*/
+static std::array<uint16_t, 16> unpack_reference_sbus(const uint8_t* p)
+{
+    std::array<uint16_t, 16> channels {};
+    channels[0]  = static_cast<uint16_t>(p[0]     | p[1]<<8);
+    channels[1]  = static_cast<uint16_t>(p[1]>>3  | p[2]<<5);
+    channels[2]  = static_cast<uint16_t>(p[2]>>6  | p[3]<<2  | p[4]<<10);
+    channels[3]  = static_cast<uint16_t>(p[4]>>1  | p[5]<<7);
+    channels[4]  = static_cast<uint16_t>(p[5]>>4  | p[6]<<4);
+    channels[5]  = static_cast<uint16_t>(p[6]>>7  | p[7]<<1  | p[8]<<9);
+    channels[6]  = static_cast<uint16_t>(p[8]>>2  | p[9]<<6);
+    channels[7]  = static_cast<uint16_t>(p[9]>>5  | p[10]<<3);
+    channels[8]  = static_cast<uint16_t>(p[11]    | p[12]<<8);
+    channels[9]  = static_cast<uint16_t>(p[12]>>3 | p[13]<<5);
+    channels[10] = static_cast<uint16_t>(p[13]>>6 | p[14]<<2 | p[15]<<10);
+    channels[11] = static_cast<uint16_t>(p[15]>>1 | p[16]<<7);
+    channels[12] = static_cast<uint16_t>(p[16]>>4 | p[17]<<4);
+    channels[13] = static_cast<uint16_t>(p[17]>>7 | p[18]<<1 | p[19]<<9);
+    channels[14] = static_cast<uint16_t>(p[19]>>2 | p[20]<<6);
+    channels[15] = static_cast<uint16_t>(p[20]>>5 | p[21]<<3);
+    for (uint16_t& channel : channels) {
+        channel &= 0x07FF;
+    }
+    return channels;
+}
+
+static void fill_random(uint8_t* data, size_t len, uint32_t& seed)
+{
+    for (size_t ii = 0; ii < len; ++ii) {
+        seed = seed * 1664525U + 1013904223U;
+        data[ii] = static_cast<uint8_t>(seed >> 24U);
+    }
+}
+
+void test_unpack_11bit_channels_byte_count()
+{
+    TEST_ASSERT_EQUAL(22, channels_11bit::byte_count(16));
+    TEST_ASSERT_EQUAL(11, channels_11bit::byte_count(8));
+    TEST_ASSERT_EQUAL(2, channels_11bit::byte_count(1));
+    TEST_ASSERT_EQUAL(0, channels_11bit::byte_offset(0));
+    TEST_ASSERT_EQUAL(20, channels_11bit::byte_offset(15));
+    TEST_ASSERT_EQUAL(5, channels_11bit::shift(15));
+}
+
+void test_unpack_11bit_channels_bit_exact()
+{
+    uint32_t seed = 1;
+    std::array<uint8_t, 22> data {};
+    for (size_t iteration = 0; iteration < 1000; ++iteration) {
+        fill_random(&data[0], data.size(), seed);
+        const std::array<uint16_t, 16> expected = unpack_reference_sbus(&data[0]);
+
+        std::array<uint16_t, 16> channels {};
+        unpack_11bit_channels_scalar<16>(&channels[0], &data[0]);
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(&expected[0], &channels[0], 16);
+#if defined(LIBRARY_RECEIVER_UNPACK_11BIT_CHANNELS_VECTOR)
+        channels = {};
+        unpack_11bit_channels_vector<16>(&channels[0], &data[0]);
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(&expected[0], &channels[0], 16);
+#endif
+        channels = {};
+        unpack_11bit_channels<16>(&channels[0], &data[0]);
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(&expected[0], &channels[0], 16);
+    }
+}
+
+void test_unpack_11bit_channels_partial()
+{
+    // channel counts that are not a multiple of 8 only read the bytes they need
+    uint32_t seed = 2;
+    std::array<uint8_t, 22> data {};
+    fill_random(&data[0], data.size(), seed);
+    const std::array<uint16_t, 16> expected = unpack_reference_sbus(&data[0]);
+
+    std::array<uint16_t, 16> channels {};
+    unpack_11bit_channels<12>(&channels[0], &data[0]);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(&expected[0], &channels[0], 12);
+    TEST_ASSERT_EQUAL(0, channels[12]);
+
+    channels = {};
+    unpack_11bit_channels<8>(&channels[0], &data[0]);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(&expected[0], &channels[0], 8);
+    TEST_ASSERT_EQUAL(0, channels[8]);
+
+    channels = {};
+    unpack_11bit_channels<3>(&channels[0], &data[0]);
+    TEST_ASSERT_EQUAL_UINT16_ARRAY(&expected[0], &channels[0], 3);
+    TEST_ASSERT_EQUAL(0, channels[3]);
+}
+/*!
+The vector implementation for the target must give the same channels as the scalar one.
+`data` is exactly byte_count(N) bytes, so when run with the address sanitizer any read past the end of the data is caught.
+*/
+template <size_t N>
+static void check_vector_matches_scalar(uint32_t seed)
+{
+    std::array<uint8_t, channels_11bit::byte_count(N)> data {};
+    for (size_t iteration = 0; iteration < 1000; ++iteration) {
+        fill_random(&data[0], data.size(), seed);
+        std::array<uint16_t, N> expected {};
+        unpack_11bit_channels_scalar<N>(&expected[0], &data[0]);
+        std::array<uint16_t, N> channels {};
+#if defined(LIBRARY_RECEIVER_UNPACK_11BIT_CHANNELS_VECTOR)
+        unpack_11bit_channels_vector<N>(&channels[0], &data[0]);
+#else
+        unpack_11bit_channels<N>(&channels[0], &data[0]);
+#endif
+        TEST_ASSERT_EQUAL_UINT16_ARRAY(&expected[0], &channels[0], N);
+    }
+}
+
+void test_unpack_11bit_channels_vector_matches_scalar()
+{
+    // the vector path depends on the target: SSE2, SSSE3 (see the unit-test-ssse3 environment), or NEON on an AArch64 host
+#if defined(__SSSE3__)
+    TEST_MESSAGE("vector path: SSSE3");
+#elif defined(__SSE2__)
+    TEST_MESSAGE("vector path: SSE2");
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    TEST_MESSAGE("vector path: NEON");
+#else
+    TEST_MESSAGE("vector path: none, scalar only");
+#endif
+    check_vector_matches_scalar<3>(3);
+    check_vector_matches_scalar<8>(4);
+    check_vector_matches_scalar<12>(5);
+    check_vector_matches_scalar<16>(6);
+    check_vector_matches_scalar<24>(7);
+}
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,misc-const-correctness,readability-magic-numbers)
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char **argv)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_unpack_11bit_channels_byte_count);
+    RUN_TEST(test_unpack_11bit_channels_bit_exact);
+    RUN_TEST(test_unpack_11bit_channels_partial);
+    RUN_TEST(test_unpack_11bit_channels_vector_matches_scalar);
+
+    UNITY_END();
+}